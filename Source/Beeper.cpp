@@ -0,0 +1,155 @@
+#include "Beeper.h"
+
+#include <algorithm>
+#include <cmath>
+
+Beeper::Beeper(uint32_t sampleRate, uint32_t bufferSamples)
+	: m_SampleRate(sampleRate), m_MaxQueuedFrames(static_cast<uint32_t>(std::min<size_t>(k_QueueCapacity, (bufferSamples * k_FrameRate + sampleRate - 1) / sampleRate + 1)))
+{
+}
+
+bool Beeper::QueueFrame(const ChipState* state)
+{
+	const uint64_t writeCount = m_WriteCount.load(std::memory_order_relaxed);
+
+	if (writeCount - m_ReadCount.load(std::memory_order_acquire) >= k_QueueCapacity)
+	{
+		m_DroppedFrames.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	m_Queue[writeCount % k_QueueCapacity] = CaptureFrame(state);
+
+	// Publishes the frame written above to the audio thread
+	m_WriteCount.store(writeCount + 1, std::memory_order_release);
+
+	return true;
+}
+
+void Beeper::Render(int16_t* samples, size_t count)
+{
+	uint64_t readCount = m_ReadCount.load(std::memory_order_relaxed);
+
+	while (count > 0)
+	{
+		if (m_CurrentFrameRemaining == 0)
+		{
+			const uint64_t writeCount = m_WriteCount.load(std::memory_order_acquire);
+
+			if (readCount == writeCount)
+			{
+				// Nothing has been emulated yet, so there's nothing to play
+				memset(samples, 0, count * sizeof(int16_t));
+				break;
+			}
+
+			// Frames that have built up while the audio thread was behind (Or the emulator was fast-forwarding) would only add latency
+			if (writeCount - readCount > m_MaxQueuedFrames)
+			{
+				m_DroppedFrames.fetch_add(writeCount - readCount - m_MaxQueuedFrames, std::memory_order_relaxed);
+				readCount = writeCount - m_MaxQueuedFrames;
+			}
+
+			m_CurrentFrame = m_Queue[readCount % k_QueueCapacity];
+			m_CurrentFrameRemaining = NextFrameLength();
+
+			// Hands the slot back to the emulation loop
+			m_ReadCount.store(++readCount, std::memory_order_release);
+		}
+
+		const size_t renderCount = std::min<size_t>(count, m_CurrentFrameRemaining);
+
+		Synthesise(m_CurrentFrame, samples, renderCount);
+
+		samples += renderCount;
+		count -= renderCount;
+		m_CurrentFrameRemaining -= static_cast<uint32_t>(renderCount);
+	}
+}
+
+void Beeper::RenderFrames(const ChipState* state, uint32_t frameCount, std::vector<int16_t>& samples)
+{
+	SoundFrame frame = CaptureFrame(state);
+
+	// The Sound register counts down once per frame, so the tone stops after that many frames
+	const uint32_t toneFrames = std::min<uint32_t>(frameCount, state->Sound);
+
+	for (uint32_t i = 0; i < frameCount; i++)
+	{
+		frame.bIsToneOn = i < toneFrames;
+
+		const uint32_t frameLength = NextFrameLength();
+		const size_t start = samples.size();
+
+		samples.resize(start + frameLength);
+
+		Synthesise(frame, samples.data() + start, frameLength);
+	}
+}
+
+Beeper::SoundFrame Beeper::CaptureFrame(const ChipState* state)
+{
+	SoundFrame frame;
+
+	frame.bIsToneOn = state->Sound > 0;
+	frame.Pitch = state->Pitch;
+
+	memcpy(frame.Pattern, state->AudioPattern, sizeof(frame.Pattern));
+
+	frame.bHasPattern = state->bHasAudioPattern;
+
+	return frame;
+}
+
+uint32_t Beeper::NextFrameLength()
+{
+	m_FrameRemainder += m_SampleRate;
+
+	const uint32_t frameLength = m_FrameRemainder / k_FrameRate;
+
+	m_FrameRemainder -= frameLength * k_FrameRate;
+
+	return frameLength;
+}
+
+void Beeper::Synthesise(const SoundFrame& frame, int16_t* samples, size_t count)
+{
+	if (!frame.bIsToneOn)
+	{
+		memset(samples, 0, count * sizeof(int16_t));
+		return;
+	}
+
+	if (frame.bHasPattern)
+	{
+		// XO-CHIP plays the pattern at 4000 * 2 ^ ((pitch - 64) / 48) bits per second
+		const double patternStep = k_PatternBaseRate * std::pow(2.0, (frame.Pitch - 64) / 48.0) / m_SampleRate;
+		const double patternBits = ChipState::k_AudioPatternSize * 8.0;
+
+		for (size_t i = 0; i < count; i++)
+		{
+			const uint32_t bit = static_cast<uint32_t>(m_PatternPosition);
+
+			samples[i] = ((frame.Pattern[bit >> 3] >> (7 - (bit & 7))) & 1) != 0 ? k_Amplitude : -k_Amplitude;
+
+			m_PatternPosition += patternStep;
+
+			if (m_PatternPosition >= patternBits)
+				m_PatternPosition -= patternBits;
+		}
+	}
+	else
+	{
+		const double squareStep = k_SquareWaveFrequency / m_SampleRate;
+
+		for (size_t i = 0; i < count; i++)
+		{
+			samples[i] = m_SquarePhase < 0.5 ? k_Amplitude : -k_Amplitude;
+
+			m_SquarePhase += squareStep;
+
+			if (m_SquarePhase >= 1.0)
+				m_SquarePhase -= 1.0;
+		}
+	}
+}
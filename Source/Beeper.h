@@ -0,0 +1,137 @@
+#pragma once
+
+#include "EmulatorCommon.h"
+
+#include "CPU.h"
+
+#include <atomic>
+#include <vector>
+
+/*
+* Synthesises the CHIP-8 beeper from the Sound register.
+*
+* The emulation loop queues the sound state of each emulated 60Hz frame, and the audio thread renders each queued frame as exactly
+* 1/60th of a second of samples. Tones start and stop on the sample matching the frame they were emulated in (The sound timer is only
+* looked at once a frame, like the COSMAC VIP's interrupt routine did), however the audio thread's buffers happen to line up.
+*
+* The queue is single-producer single-consumer and only ever touched through atomic indices, so the audio callback never waits on the
+* emulation loop (Or the other way around). If the audio thread falls behind, the oldest frames are dropped to keep the latency bounded.
+*
+* ROMs that have loaded an XO-CHIP audio pattern play it at the pitch set by Fx3A. Everything else plays a square wave.
+*/
+class Beeper
+{
+public:
+	// Rate the beeper asks the audio device for
+	static constexpr uint32_t k_DefaultSampleRate = 48000;
+
+	// Frames of sound state the queue can hold before new frames are dropped (Around a second)
+	static constexpr size_t k_QueueCapacity = 64;
+
+public:
+	/// <summary>
+	/// Creates a beeper
+	/// </summary>
+	/// <param name="sampleRate">Rate samples are rendered at (Hz)</param>
+	/// <param name="bufferSamples">Size of each buffer the audio thread renders. Frames queued beyond what's needed to fill one are dropped.</param>
+	explicit Beeper(uint32_t sampleRate = k_DefaultSampleRate, uint32_t bufferSamples = 0);
+
+	/// <summary>
+	/// Queues the sound state for one emulated frame. Must be called before the timers are ticked for the frame, and only from one thread.
+	/// </summary>
+	/// <param name="state">State of the CPU at the end of the frame</param>
+	/// <returns>True if the frame was queued. False if the queue is full and the frame was dropped</returns>
+	bool QueueFrame(const ChipState* state);
+
+	/// <summary>
+	/// Renders queued frames into an audio buffer. Silence is rendered once the queue runs out. Must only be called from one thread.
+	/// </summary>
+	/// <param name="samples">Receives the samples (Mono, signed 16-bit)</param>
+	/// <param name="count">Number of samples to render</param>
+	void Render(int16_t* samples, size_t count);
+
+	/// <summary>
+	/// Renders frames straight from the CPU state without going through the queue, for writing audio out as fast as it can be emulated.
+	/// The tone is on for as many of the frames as the Sound register will still be above zero, as if the timers were ticked after each one.
+	/// </summary>
+	/// <param name="state">State of the CPU before the timers are ticked for the first frame</param>
+	/// <param name="frameCount">Number of frames to render</param>
+	/// <param name="samples">The samples are appended to this (Mono, signed 16-bit)</param>
+	void RenderFrames(const ChipState* state, uint32_t frameCount, std::vector<int16_t>& samples);
+
+	/// <summary>
+	/// Gets the rate samples are rendered at
+	/// </summary>
+	uint32_t SampleRate() const { return m_SampleRate; }
+
+	/// <summary>
+	/// Gets the number of frames dropped because the queue was full or the audio thread fell behind
+	/// </summary>
+	uint64_t DroppedFrames() const { return m_DroppedFrames.load(std::memory_order_relaxed); }
+
+private:
+	// Everything needed to synthesise one frame of sound
+	struct SoundFrame
+	{
+		bool bIsToneOn = false;
+
+		// Set if the ROM has loaded an audio pattern to play instead of the square wave
+		bool bHasPattern = false;
+
+		uint8_t Pitch = 64;
+		uint8_t Pattern[ChipState::k_AudioPatternSize] = { 0 };
+	};
+
+	/// <summary>
+	/// Captures the sound state of the CPU
+	/// </summary>
+	static SoundFrame CaptureFrame(const ChipState* state);
+
+	/// <summary>
+	/// Gets the number of samples in the next frame. Frames aren't always a whole number of samples, so this spreads the remainder across them.
+	/// </summary>
+	uint32_t NextFrameLength();
+
+	/// <summary>
+	/// Synthesises samples for a frame, carrying on from where the last samples left off so there are no clicks between frames
+	/// </summary>
+	void Synthesise(const SoundFrame& frame, int16_t* samples, size_t count);
+
+private:
+	// Emulated frames per second
+	static constexpr uint32_t k_FrameRate = 60;
+
+	// Frequency of the square wave played when there's no audio pattern (Hz)
+	static constexpr double k_SquareWaveFrequency = 440.0;
+
+	// Peak amplitude of the output. Kept well below full scale, as a square wave at full volume is unpleasant.
+	static constexpr int16_t k_Amplitude = 4000;
+
+	// Rate XO-CHIP audio patterns play at with the default pitch of 64 (Bits per second)
+	static constexpr double k_PatternBaseRate = 4000.0;
+
+	const uint32_t m_SampleRate;
+
+	// Most frames the audio thread lets build up in the queue before dropping the oldest
+	const uint32_t m_MaxQueuedFrames;
+
+	// Frames written to and read from the queue since it was created. Each is only written by one thread, and on separate cache lines
+	// so the producer and consumer don't keep stealing the line from each other.
+	alignas(64) std::atomic<uint64_t> m_WriteCount{ 0 };
+	alignas(64) std::atomic<uint64_t> m_ReadCount{ 0 };
+
+	alignas(64) std::atomic<uint64_t> m_DroppedFrames{ 0 };
+
+	SoundFrame m_Queue[k_QueueCapacity];
+
+	// Audio thread state: the frame being rendered and how many of its samples are still to come
+	SoundFrame m_CurrentFrame;
+	uint32_t m_CurrentFrameRemaining = 0;
+
+	// Sample rate units left over from previous frames, carried into the next frame's length
+	uint32_t m_FrameRemainder = 0;
+
+	// Position through the square wave (0 - 1) and the audio pattern (0 - 128 bits), kept between frames so the waveform is continuous
+	double m_SquarePhase = 0.0;
+	double m_PatternPosition = 0.0;
+};
@@ -1,9 +1,20 @@
 #include "CPU.h"
 
+#include <algorithm>
+
+#ifdef CHIP8_USE_SSE2
+#include <emmintrin.h>
+#endif // CHIP8_USE_SSE2
+
 void CPU::Init()
 {
-	m_CpuState = new ChipState();
+	// Re-initialising reuses the existing state rather than allocating a new one for every ROM
+	if (m_CpuState == nullptr)
+	{
+		m_CpuState = new ChipState();
+	}
 
+	// Every field is reset in place rather than assigning a fresh ChipState, which would build (And copy) a 64KB temporary for every ROM
 	m_CpuState->I = 0;
 
 	m_CpuState->Delay = 0;
@@ -12,34 +23,58 @@ void CPU::Init()
 	m_CpuState->PC = 0x200;
 	m_CpuState->SP = 0;
 
-	for (int i = 0; i < 4096; i++)
-	{
-		m_CpuState->Memory[i] = 0;
-	}
-
-	for (int i = 0; i < 2048; i++)
-	{
-		m_CpuState->VideoMemory[i] = 0;
-	}
-
 	for (int i = 0; i < 16; i++)
 	{
 		m_CpuState->V[i] = 0;
 		m_CpuState->Stack[i] = 0;
 		m_CpuState->KeyState[i] = 0;
 		m_CpuState->PreviousKeyState[i] = 0;
+		m_CpuState->FlagRegisters[i] = 0;
 	}
 
-	for (int i = 0; i < 80; i++)
-	{
-		m_CpuState->Memory[i] = Sprites::Font[i];
-	}
+	m_CpuState->bIsWaitingForKeyPress = false;
+	m_CpuState->bIsStopped = true;
+	m_CpuState->StopReason = CpuStopReason::None;
+	m_CpuState->StopOpCode = 0;
+	m_CpuState->FaultAddress = 0;
 
-	srand(time(NULL));
+	memset(m_CpuState->VideoMemory, 0, sizeof(m_CpuState->VideoMemory));
 
-	//m_CpuState->VideoMemory = (uint8_t*)calloc(2048, 1); //&m_CpuState->Memory[0xF00];
+	m_CpuState->bIsHighResolution = false;
+	m_CpuState->SelectedPlanes = 1;
 
-	//memcpy(&m_CpuState->Memory[Sprites::FONT_START], Sprites::Font, Sprites::FONT_SIZE);
+	// The version keeps counting up across resets so anything caching video memory sees the cleared screen as a change
+	m_CpuState->DirtyRows = ~0ull;
+	m_CpuState->VideoMemoryVersion++;
+
+	memset(m_CpuState->AudioPattern, 0, sizeof(m_CpuState->AudioPattern));
+	m_CpuState->bHasAudioPattern = false;
+	m_CpuState->Pitch = 64;
+
+	SetQuirkProfile(m_QuirkProfile);
+
+	m_IdleInstructionsSkipped = 0;
+	m_FusedInstructions = 0;
+
+	m_CycleBalance = 0;
+	m_FrameCycles = 0;
+	m_bIsWaitingForVBlank = false;
+	m_bHasVBlankPassed = false;
+
+	m_Cosmac.Reset(m_CpuState->Memory, m_CpuState->KeyState);
+	m_MachineCodeCycles = 0;
+
+	// Only the part of memory the last ROM could have touched needs clearing (Everything, after a memory editor or the first Init)
+	memset(m_CpuState->Memory, 0, m_MemoryExtent);
+
+	InvalidateDecodeCache();
+
+	memcpy(&m_CpuState->Memory[Sprites::FONT_START], Sprites::Font, Sprites::FONT_SIZE);
+	memcpy(&m_CpuState->Memory[Sprites::BIG_FONT_START], Sprites::BigFont, Sprites::BIG_FONT_SIZE);
+
+	m_MemoryExtent = 0x200;
+
+	SetSeed(static_cast<uint32_t>(time(NULL)));
 }
 
 void CPU::SetKeyState(uint8_t keycode)
@@ -52,6 +87,14 @@ void CPU::ClearKeyState(uint8_t keycode)
 	m_CpuState->KeyState[keycode] = 0;
 }
 
+void CPU::SetKeyMask(uint16_t keyMask)
+{
+	for (int i = 0; i < 16; i++)
+	{
+		m_CpuState->KeyState[i] = (keyMask >> i) & 1;
+	}
+}
+
 void CPU::SetDelayRegister(uint8_t value)
 {
 	m_CpuState->Delay = value;
@@ -62,129 +105,989 @@ void CPU::SetSoundRegister(uint8_t value)
 	m_CpuState->Sound = value;
 }
 
+void CPU::TickTimers(uint32_t ticks)
+{
+	m_CpuState->Delay = m_CpuState->Delay > ticks ? static_cast<uint8_t>(m_CpuState->Delay - ticks) : 0;
+	m_CpuState->Sound = m_CpuState->Sound > ticks ? static_cast<uint8_t>(m_CpuState->Sound - ticks) : 0;
+
+	if (ticks > 0)
+	{
+		// The sprite that was waiting can now be drawn
+		m_bHasVBlankPassed = m_bIsWaitingForVBlank;
+		m_bIsWaitingForVBlank = false;
+		m_FrameCycles = 0;
+	}
+}
+
+bool CPU::IsHalted() const
+{
+	const uint32_t pc = m_CpuState->PC;
+
+	if (m_CpuState->bIsStopped || pc + 1 >= sizeof(m_CpuState->Memory))
+		return false;
+
+	const uint16_t opcode = static_cast<uint16_t>(m_CpuState->Memory[pc] << 8 | m_CpuState->Memory[pc + 1]);
+
+	return opcode == (0x1000 | pc);
+}
+
+void CPU::SetSeed(uint32_t seed)
+{
+	// Xorshift gets stuck at zero, so scramble the seed and make sure it can't end up there
+	m_RandomState = seed ^ 0x9E3779B9;
+
+	if (m_RandomState == 0)
+		m_RandomState = 1;
+}
+
+void CPU::SetLoggingEnabled(bool bIsEnabled)
+{
+	m_bIsLoggingEnabled = bIsEnabled;
+}
+
+uint8_t CPU::NextRandomByte()
+{
+	m_RandomState ^= m_RandomState << 13;
+	m_RandomState ^= m_RandomState >> 17;
+	m_RandomState ^= m_RandomState << 5;
+
+	return static_cast<uint8_t>(m_RandomState >> 24);
+}
+
 const ChipState* CPU::GetState() const
 {
 	return m_CpuState;
 }
 
-void CPU::Stop()
-{
-	std::cout << "INFO: CPU Stop called!" << std::endl;
+uint64_t CPU::TakeDirtyRows()
+{
+	const uint64_t dirtyRows = m_CpuState->DirtyRows;
+
+	m_CpuState->DirtyRows = 0;
+
+	return dirtyRows;
+}
+
+void CPU::WriteMemory(uint32_t address, uint8_t value)
+{
+	m_CpuState->Memory[address] = value;
+
+	OnMemoryWritten(address, 1);
+}
+
+void CPU::WriteVideoMemory(size_t offset, uint8_t value)
+{
+	reinterpret_cast<uint8_t*>(m_CpuState->VideoMemory)[offset] = value;
+
+	const size_t row = offset / sizeof(m_CpuState->VideoMemory[0][0]) % ChipState::k_DisplayHeight;
+
+	m_CpuState->DirtyRows |= 1ull << row;
+	m_CpuState->VideoMemoryVersion++;
+}
+
+void CPU::Stop(CpuStopReason reason)
+{
+	if (m_bIsLoggingEnabled)
+		std::cout << "INFO: CPU Stop called!" << std::endl;
+
+	m_CpuState->bIsStopped = true;
+	m_CpuState->StopReason = reason;
+}
+
+void CPU::StopOnUnknownOpCode(uint16_t opcode)
+{
+	if (m_bIsLoggingEnabled)
+		std::cout << "ERROR: Unknown OpCode: 0x" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(opcode) << std::dec << std::setfill(' ') << std::endl;
+
+	m_CpuState->StopOpCode = opcode;
+
+	Stop(CpuStopReason::UnknownOpCode);
+}
+
+bool CPU::LoadProgram(const wchar_t* FilePath)
+{
+	std::ifstream inputFile;
+	inputFile.open(FilePath, std::ios::binary);
+
+	if (inputFile.is_open())
+	{
+		inputFile.seekg(0, std::ios::end);
+		std::streampos end = inputFile.tellg();
+
+		inputFile.seekg(0, std::ios::beg);
+		std::streampos begin = inputFile.tellg();
+
+		size_t fileSize = static_cast<size_t>(end - begin);
+
+		if (fileSize > sizeof(m_CpuState->Memory) - 0x200)
+		{
+			if (m_bIsLoggingEnabled)
+				std::cout << "ERROR: ROM is too large to fit in memory (" << fileSize << " bytes)" << std::endl;
+			return false;
+		}
+
+		// Read straight into program memory rather than going through a temporary buffer
+		inputFile.read(reinterpret_cast<char*>(&m_CpuState->Memory[0x200]), fileSize);
+		inputFile.close();
+
+		OnMemoryWritten(0x200, static_cast<uint32_t>(fileSize));
+
+		m_CpuState->bIsStopped = false;
+		m_CpuState->StopReason = CpuStopReason::None;
+
+		return true;
+	}
+
+	if (m_bIsLoggingEnabled)
+		std::cout << "ERROR: Failed to open input '" << *FilePath << "': " << strerror(errno) << std::endl;
+
+	return false;
+}
+
+bool CPU::LoadProgram(const uint8_t* data, size_t size)
+{
+	if (size > sizeof(m_CpuState->Memory) - 0x200)
+	{
+		if (m_bIsLoggingEnabled)
+			std::cout << "ERROR: ROM is too large to fit in memory (" << size << " bytes)" << std::endl;
+		return false;
+	}
+
+	memcpy(&m_CpuState->Memory[0x200], data, size);
+
+	OnMemoryWritten(0x200, static_cast<uint32_t>(size));
+
+	m_CpuState->bIsStopped = false;
+	m_CpuState->StopReason = CpuStopReason::None;
+
+	return true;
+}
+
+void CPU::RunCycle()
+{
+	RunCycles(1);
+}
+
+uint32_t CPU::RunCycles(uint32_t count)
+{
+	return (this->*m_RunCycles)(count);
+}
+
+uint32_t CPU::RunMachineCycles(uint32_t cycles)
+{
+	return (this->*m_RunMachineCycles)(cycles);
+}
+
+void CPU::SetQuirkProfile(QuirkProfile profile)
+{
+	m_QuirkProfile = profile;
+
+	switch (profile)
+	{
+		case QuirkProfile::CosmacVip: SelectRunLoops<CosmacVipQuirks>(); break;
+		case QuirkProfile::Chip48:    SelectRunLoops<Chip48Quirks>();    break;
+		case QuirkProfile::SuperChip: SelectRunLoops<SuperChipQuirks>(); break;
+		case QuirkProfile::Modern:    SelectRunLoops<ModernQuirks>();    break;
+	}
+}
+
+void CPU::SetMemoryChecksEnabled(bool bIsEnabled)
+{
+	m_bIsMemoryCheckEnabled = bIsEnabled;
+
+	SetQuirkProfile(m_QuirkProfile);
+}
+
+template<typename Quirks>
+void CPU::SelectRunLoops()
+{
+	if (m_bIsMemoryCheckEnabled)
+	{
+		m_RunCycles = &CPU::RunCyclesWith<WithMemoryAccess<Quirks, CheckedMemoryAccess>>;
+		m_RunMachineCycles = &CPU::RunMachineCyclesWith<WithMemoryAccess<Quirks, CheckedMemoryAccess>>;
+	}
+	else
+	{
+		m_RunCycles = &CPU::RunCyclesWith<WithMemoryAccess<Quirks, UncheckedMemoryAccess>>;
+		m_RunMachineCycles = &CPU::RunMachineCyclesWith<WithMemoryAccess<Quirks, UncheckedMemoryAccess>>;
+	}
+}
+
+template<typename Quirks>
+bool CPU::IsMemoryAccessValid(uint32_t address, uint32_t length, uint16_t opcode)
+{
+	if constexpr (Quirks::k_bCheckMemoryAccess)
+	{
+		if (address + length > Quirks::k_MemorySize)
+		{
+			const uint32_t faultAddress = std::max(address, Quirks::k_MemorySize);
+
+			if (m_bIsLoggingEnabled)
+				std::cout << "ERROR: OpCode 0x" << std::hex << std::uppercase << std::setfill('0') << std::setw(4) << opcode << " at 0x" << std::setw(4) << m_CpuState->PC
+					<< " accessed 0x" << std::setw(4) << address << "-0x" << std::setw(4) << (address + length - 1) << ", past the end of memory at 0x" << std::setw(4) << (Quirks::k_MemorySize - 1)
+					<< std::dec << std::nouppercase << std::setfill(' ') << std::endl;
+
+			m_CpuState->StopOpCode = opcode;
+			m_CpuState->FaultAddress = faultAddress;
+
+			Stop(CpuStopReason::MemoryOutOfRange);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+template<typename Quirks>
+bool CPU::IsKeyValid(uint8_t key, uint16_t opcode)
+{
+	if constexpr (Quirks::k_bCheckMemoryAccess)
+	{
+		if (key > 0xF)
+		{
+			if (m_bIsLoggingEnabled)
+				std::cout << "ERROR: OpCode 0x" << std::hex << std::uppercase << std::setfill('0') << std::setw(4) << opcode << " at 0x" << std::setw(4) << m_CpuState->PC
+					<< " tested key 0x" << std::setw(2) << static_cast<int>(key) << ", which isn't on the keypad (0x0-0xF)" << std::dec << std::nouppercase << std::setfill(' ') << std::endl;
+
+			m_CpuState->StopOpCode = opcode;
+			m_CpuState->FaultAddress = key;
+
+			Stop(CpuStopReason::KeyOutOfRange);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+template<typename Quirks>
+bool CPU::IsStackAccessValid(bool bIsPush, uint16_t opcode)
+{
+	if constexpr (Quirks::k_bCheckMemoryAccess)
+	{
+		const bool bIsValid = bIsPush ? m_CpuState->SP < 16 : m_CpuState->SP > 0;
+
+		if (!bIsValid)
+		{
+			if (m_bIsLoggingEnabled)
+				std::cout << "ERROR: OpCode 0x" << std::hex << std::uppercase << std::setfill('0') << std::setw(4) << opcode << " at 0x" << std::setw(4) << m_CpuState->PC
+					<< std::dec << std::nouppercase << std::setfill(' ') << (bIsPush ? " overflowed the stack (16 levels deep)" : " returned with nothing on the stack") << std::endl;
+
+			m_CpuState->StopOpCode = opcode;
+
+			Stop(bIsPush ? CpuStopReason::StackOverflow : CpuStopReason::StackUnderflow);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+template<typename Quirks>
+uint32_t CPU::RunCyclesWith(uint32_t count)
+{
+	uint32_t executed = 0;
+
+	while (executed < count && !m_CpuState->bIsStopped)
+	{
+		// Fused handlers don't go through the checks between the instructions they cover
+		if (!Quirks::k_bCheckMemoryAccess && m_bIsFusionEnabled && count - executed >= k_MaxFusedLength)
+		{
+			FusedOp& fusedOp = m_DecodeCache[m_CpuState->PC];
+
+			if (fusedOp == FusedOp::Undecoded)
+			{
+				fusedOp = DecodeFusedOp(m_CpuState->PC);
+
+				m_DecodeCacheExtent = std::max(m_DecodeCacheExtent, static_cast<size_t>(m_CpuState->PC) + 1);
+			}
+
+			if (fusedOp != FusedOp::None)
+			{
+				const uint32_t fusedCount = RunFusedOp<Quirks>(fusedOp);
+
+				m_FusedInstructions += fusedCount;
+				executed += fusedCount;
+				continue;
+			}
+		}
+
+		const uint16_t opcode = FetchOpCode();
+
+		ExecuteOpCode<Quirks>(opcode);
+
+		executed++;
+
+		if (m_bIsIdleSkipEnabled && ((opcode & 0xF000) == 0x1000 || (opcode & 0xF0FF) == 0xF00A))
+		{
+			executed += SkipIdleLoop(opcode, count - executed);
+		}
+	}
+
+	return executed;
+}
+
+template<typename Quirks>
+void CPU::ExecuteOpCode(uint16_t opcode)
+{
+	// The instruction itself has to be inside memory (A jump can take the Program Counter anywhere)
+	if (!IsMemoryAccessValid<Quirks>(m_CpuState->PC, 2, opcode))
+		return;
+
+	switch (opcode & 0xF000)
+	{
+		case 0x0000: Op0<Quirks>(opcode); break;
+		case 0x1000: Op1(opcode); break;
+		case 0x2000: Op2<Quirks>(opcode); break;
+		case 0x3000: Op3<Quirks>(opcode); break;
+		case 0x4000: Op4<Quirks>(opcode); break;
+		case 0x5000: Op5<Quirks>(opcode); break;
+		case 0x6000: Op6(opcode); break;
+		case 0x7000: Op7(opcode); break;
+		case 0x8000: Op8<Quirks>(opcode); break;
+		case 0x9000: Op9<Quirks>(opcode); break;
+		case 0xA000: OpA(opcode); break;
+		case 0xB000: OpB<Quirks>(opcode); break;
+		case 0xC000: OpC(opcode); break;
+		case 0xD000: OpD<Quirks>(opcode); break;
+		case 0xE000: OpE<Quirks>(opcode); break;
+		case 0xF000: OpF<Quirks>(opcode); break;
+	}
+}
+
+template<typename Quirks>
+uint32_t CPU::RunMachineCyclesWith(uint32_t cycles)
+{
+	uint32_t executed = 0;
+
+	// Waiting for the vertical blank uses up the cycles without doing anything
+	if (m_bIsWaitingForVBlank || m_CpuState->bIsStopped)
+	{
+		m_CycleBalance = std::min<int64_t>(m_CycleBalance, 0);
+		return 0;
+	}
+
+	m_CycleBalance += cycles;
+
+	while (m_CycleBalance > 0 && !m_CpuState->bIsStopped)
+	{
+		const uint16_t opcode = FetchOpCode();
+
+		if ((opcode & 0xF000) == 0xD000)
+		{
+			// The VIP's interpreter waits for the vertical blank before each sprite is drawn, so at most one is drawn per frame
+			if (!m_bHasVBlankPassed)
+			{
+				m_bIsWaitingForVBlank = true;
+				m_CycleBalance = std::min<int64_t>(m_CycleBalance, 0);
+				break;
+			}
+
+			m_bHasVBlankPassed = false;
+		}
+
+		const uint32_t opcodeCycles = VipInstructionCycles(opcode);
+
+		m_MachineCodeCycles = 0;
+
+		ExecuteOpCode<Quirks>(opcode);
+
+		executed++;
+		m_CycleBalance -= opcodeCycles + m_MachineCodeCycles;
+		m_FrameCycles += opcodeCycles + m_MachineCodeCycles;
+
+		if (m_bIsIdleSkipEnabled && m_CycleBalance > 0 && (IsHalted() || m_CpuState->bIsWaitingForKeyPress))
+		{
+			// The same instruction would be executed over and over until the cycles run out, so count it as if it had been
+			const uint32_t idleCycles = VipInstructionCycles(FetchOpCode());
+			const uint32_t skipped = static_cast<uint32_t>((m_CycleBalance + idleCycles - 1) / idleCycles);
+
+			m_IdleInstructionsSkipped += skipped;
+			executed += skipped;
+			m_CycleBalance -= static_cast<int64_t>(skipped) * idleCycles;
+			m_FrameCycles += static_cast<uint64_t>(skipped) * idleCycles;
+		}
+	}
+
+	return executed;
+}
+
+uint32_t CPU::VipInstructionCycles(uint16_t opcode) const
+{
+	const uint8_t x = (opcode & 0x0F00) >> 8;
+	const uint8_t lowByte = opcode & 0x00FF;
+
+	uint32_t cycles = k_VipFetchCycles;
+
+	switch (opcode & 0xF000)
+	{
+		// 00E0 clears the 256 bytes of display memory one at a time
+		case 0x0000: cycles += opcode == 0x00E0 ? 24 + 256 * 6 : 10; break;
+		case 0x1000: cycles += 12; break;
+		case 0x2000: cycles += 26; break;
+		case 0x3000: cycles += 12; break;
+		case 0x4000: cycles += 12; break;
+		case 0x5000: cycles += 14; break;
+		case 0x6000: cycles += 6; break;
+		case 0x7000: cycles += 10; break;
+
+		// The VIP builds each 8xyn as a tiny routine in RAM and calls it
+		case 0x8000: cycles += 44; break;
+		case 0x9000: cycles += 14; break;
+		case 0xA000: cycles += 12; break;
+		case 0xB000: cycles += 22; break;
+		case 0xC000: cycles += 36; break;
+		case 0xD000:
+		{
+			// Each row of the sprite is shifted a bit at a time into place across two bytes, then XORed into one or both of them
+			const uint32_t shift = m_CpuState->V[x] & 0x7;
+			const uint32_t spriteY = m_CpuState->V[(opcode & 0x00F0) >> 4] % 32;
+			const uint32_t spriteRows = (opcode & 0x000F) != 0 ? (opcode & 0x000F) : 16;
+			const uint32_t rows = std::min<uint32_t>(spriteRows, 32 - spriteY);
+
+			cycles += 40 + rows * (20 + shift * 8 + (shift != 0 ? 10 : 0));
+			break;
+		}
+		case 0xE000: cycles += 14; break;
+		case 0xF000:
+		{
+			switch (lowByte)
+			{
+				case 0x0A: cycles += 16; break;
+				case 0x1E: cycles += 16; break;
+				case 0x29: cycles += 16; break;
+
+				// The digits are found by repeated subtraction, so bigger digits take longer
+				case 0x33:
+				{
+					const uint8_t value = m_CpuState->V[x];
+
+					cycles += 30 + 8 * (value / 100 + (value / 10) % 10 + value % 10);
+					break;
+				}
+
+				// Each register is copied separately
+				case 0x55:
+				case 0x65: cycles += 14 + 14 * (x + 1); break;
+
+				default: cycles += 10; break;
+			}
+			break;
+		}
+	}
+
+	return cycles;
+}
+
+void CPU::SetIdleSkipEnabled(bool bIsEnabled)
+{
+	m_bIsIdleSkipEnabled = bIsEnabled;
+}
+
+void CPU::SetFusionEnabled(bool bIsEnabled)
+{
+	m_bIsFusionEnabled = bIsEnabled;
+}
+
+void CPU::InvalidateDecodeCache()
+{
+	// Nothing past the highest address decoded can be anything but 'Undecoded'
+	memset(m_DecodeCache, 0, m_DecodeCacheExtent);
+
+	m_DecodeCacheExtent = 0;
+
+	// Memory could have been written anywhere
+	m_MemoryExtent = sizeof(m_CpuState->Memory);
+}
+
+void CPU::OnMemoryWritten(uint32_t address, uint32_t length)
+{
+	const uint32_t end = std::min(static_cast<uint32_t>(sizeof(m_CpuState->Memory)), address + length);
+
+	m_MemoryExtent = std::max(m_MemoryExtent, static_cast<size_t>(end));
+
+	// Sequences starting up to k_MaxFusedLength instructions before the write can include it
+	const uint32_t first = address > k_MaxFusedLength * 2 - 1 ? address - (k_MaxFusedLength * 2 - 1) : 0;
+	const uint32_t last = std::min(end, static_cast<uint32_t>(m_DecodeCacheExtent));
+
+	for (uint32_t i = first; i < last; i++)
+	{
+		m_DecodeCache[i] = FusedOp::Undecoded;
+	}
+
+	// Unchecked writes that run off the end of memory carry on from the start
+	if (address + length > sizeof(m_CpuState->Memory))
+		OnMemoryWritten(0, address + length - static_cast<uint32_t>(sizeof(m_CpuState->Memory)));
+}
+
+CPU::FusedOp CPU::DecodeFusedOp(uint16_t address) const
+{
+	auto readOpCode = [this](uint32_t opAddress) { return static_cast<uint16_t>(m_CpuState->Memory[opAddress] << 8 | m_CpuState->Memory[opAddress + 1]); };
+
+	// Widened so the bounds checks compare unsigned with unsigned
+	const uint32_t start = address;
+
+	if (start + 3 >= sizeof(m_CpuState->Memory))
+		return FusedOp::None;
+
+	const uint16_t first = readOpCode(start);
+	const uint16_t second = readOpCode(start + 2);
+
+	if ((first & 0xF000) == 0xA000 && (second & 0xF000) == 0xD000)
+		return FusedOp::LoadIDraw;
+
+	if ((first & 0xF000) == 0x6000 && (second & 0xF000) == 0x6000)
+		return FusedOp::LoadPair;
+
+	// The skip is handled as a fixed 2 byte jump, so leave it unfused if it could land on XO-CHIP's 4 byte F000 NNNN
+	if ((first & 0xF0FF) == 0xF007 && (second & 0xF000) == 0x3000 && (start + 5 >= sizeof(m_CpuState->Memory) || readOpCode(start + 4) != 0xF000))
+		return FusedOp::ReadDelaySkip;
+
+	if (start + 5 < sizeof(m_CpuState->Memory) && (first & 0xF0FF) == 0x7001 && (second & 0xF000) == 0x3000 && (readOpCode(start + 4) & 0xF000) == 0x1000)
+		return FusedOp::CountedLoop;
+
+	return FusedOp::None;
+}
+
+template<typename Quirks>
+uint32_t CPU::RunFusedOp(FusedOp fusedOp)
+{
+	const uint16_t pc = m_CpuState->PC;
+
+	const uint16_t first = static_cast<uint16_t>(m_CpuState->Memory[pc] << 8 | m_CpuState->Memory[pc + 1]);
+	const uint16_t second = static_cast<uint16_t>(m_CpuState->Memory[pc + 2] << 8 | m_CpuState->Memory[pc + 3]);
+
+	const uint8_t firstRegisterIdx = (first & 0x0F00) >> 8;
+	const uint8_t secondRegisterIdx = (second & 0x0F00) >> 8;
+
+	switch (fusedOp)
+	{
+		case FusedOp::LoadIDraw:
+		{
+			m_CpuState->I = first & 0x0FFF;
+			m_CpuState->PC += 2;
+
+			OpD<Quirks>(second);
+
+			return 2;
+		}
+		case FusedOp::LoadPair:
+		{
+			m_CpuState->V[firstRegisterIdx] = first & 0x00FF;
+			m_CpuState->V[secondRegisterIdx] = second & 0x00FF;
+			m_CpuState->PC += 4;
+
+			return 2;
+		}
+		case FusedOp::ReadDelaySkip:
+		{
+			m_CpuState->V[firstRegisterIdx] = m_CpuState->Delay;
+			m_CpuState->PC += m_CpuState->V[secondRegisterIdx] == (second & 0x00FF) ? 6 : 4;
+
+			return 2;
+		}
+		case FusedOp::CountedLoop:
+		{
+			m_CpuState->V[firstRegisterIdx]++;
+
+			// Reaching the limit skips the jump back
+			if (m_CpuState->V[secondRegisterIdx] == (second & 0x00FF))
+			{
+				m_CpuState->PC += 6;
+				return 2;
+			}
+
+			m_CpuState->PC = (m_CpuState->Memory[pc + 4] << 8 | m_CpuState->Memory[pc + 5]) & 0x0FFF;
+
+			return 3;
+		}
+		default:
+		{
+			return 0;
+		}
+	}
+}
+
+uint32_t CPU::SkipIdleLoop(uint16_t opcode, uint32_t remaining)
+{
+	uint32_t skipped = 0;
+
+	if ((opcode & 0xF000) == 0x1000)
+	{
+		const uint32_t pc = m_CpuState->PC;
+
+		auto readOpCode = [this](uint32_t address) { return static_cast<uint16_t>(m_CpuState->Memory[address] << 8 | m_CpuState->Memory[address + 1]); };
+
+		if (pc + 1 < sizeof(m_CpuState->Memory) && readOpCode(pc) == opcode)
+		{
+			// Jumped to itself, so nothing will ever change
+			skipped = remaining;
+		}
+		else if (pc + 5 < sizeof(m_CpuState->Memory))
+		{
+			const uint16_t readDelay = readOpCode(pc);
+			const uint16_t compare = readOpCode(pc + 2);
+			const uint16_t jumpBack = readOpCode(pc + 4);
+
+			// 'Fx07; 3xkk/4xkk; 1nnn' where the jump goes back to the Fx07
+			const bool bIsDelayLoop = (readDelay & 0xF0FF) == 0xF007 && ((compare & 0xF000) == 0x3000 || (compare & 0xF000) == 0x4000)
+				&& (compare & 0x0F00) == (readDelay & 0x0F00) && jumpBack == (0x1000 | pc);
+
+			if (bIsDelayLoop)
+			{
+				const uint8_t registerIdx = (readDelay & 0x0F00) >> 8;
+				const uint8_t value = compare & 0x00FF;
+
+				// The compare skips over the jump (Leaving the loop) when 3xkk matches or 4xkk doesn't
+				const bool bKeepsLooping = (compare & 0xF000) == 0x3000 ? m_CpuState->Delay != value : m_CpuState->Delay == value;
+
+				if (bKeepsLooping)
+				{
+					// Whole iterations only, so the loop is left at the same instruction it would have been stepped to
+					skipped = remaining - remaining % 3;
+
+					if (skipped > 0)
+						m_CpuState->V[registerIdx] = m_CpuState->Delay;
+				}
+			}
+		}
+	}
+	else if (m_CpuState->bIsWaitingForKeyPress)
+	{
+		// Fx0A didn't see a new key press. The key states can't change until the next batch, so neither will the result.
+		skipped = remaining;
+	}
+
+	m_IdleInstructionsSkipped += skipped;
+
+	return skipped;
+}
+
+template<typename Quirks>
+void CPU::Op0(uint16_t opcode)
+{
+	if constexpr (Quirks::k_bSuperChipOpCodes)
+	{
+		if ((opcode & 0xFFF0) == 0x00C0)
+		{
+			ScrollVertical(opcode & 0x000F);
+
+			m_CpuState->PC += 2;
+			return;
+		}
+	}
+
+	if constexpr (Quirks::k_bXoChipOpCodes)
+	{
+		if ((opcode & 0xFFF0) == 0x00D0)
+		{
+			ScrollVertical(-(opcode & 0x000F));
+
+			m_CpuState->PC += 2;
+			return;
+		}
+	}
+
+	switch (opcode)
+	{
+		case 0x00E0:
+		{
+			// Only the selected planes are cleared
+			for (int plane = 0; plane < ChipState::k_PlaneCount; plane++)
+			{
+				if (m_CpuState->SelectedPlanes & (1 << plane))
+					memset(m_CpuState->VideoMemory[plane], 0, sizeof(m_CpuState->VideoMemory[plane]));
+			}
+
+			m_CpuState->DirtyRows = ~0ull;
+			m_CpuState->VideoMemoryVersion++;
+
+			m_CpuState->PC += 2;
+			break;
+		}
+		case 0x00FB:
+		case 0x00FC:
+		{
+			if constexpr (Quirks::k_bSuperChipOpCodes)
+			{
+				ScrollHorizontal(opcode == 0x00FC);
+
+				m_CpuState->PC += 2;
+			}
+			else
+			{
+				StopOnUnknownOpCode(opcode);
+			}
+
+			return;
+		}
+		case 0x00FD:
+		{
+			if constexpr (Quirks::k_bSuperChipOpCodes)
+			{
+				Stop(CpuStopReason::Exited);
+			}
+			else
+			{
+				StopOnUnknownOpCode(opcode);
+			}
+
+			return;
+		}
+		case 0x00FE:
+		case 0x00FF:
+		{
+			if constexpr (Quirks::k_bSuperChipOpCodes)
+			{
+				m_CpuState->bIsHighResolution = opcode == 0x00FF;
+
+				// Switching resolution clears every plane, as what was drawn no longer lines up with the new pixel grid
+				memset(m_CpuState->VideoMemory, 0, sizeof(m_CpuState->VideoMemory));
+
+				m_CpuState->DirtyRows = ~0ull;
+				m_CpuState->VideoMemoryVersion++;
+
+				m_CpuState->PC += 2;
+			}
+			else
+			{
+				StopOnUnknownOpCode(opcode);
+			}
+
+			return;
+		}
+		case 0x00EE:
+		{
+			if (!IsStackAccessValid<Quirks>(false, opcode))
+				return;
+
+			m_CpuState->SP = (m_CpuState->SP - 1) & k_StackPointerMask;
+
+			m_CpuState->PC = m_CpuState->Stack[m_CpuState->SP & 0xF];
+
+			m_CpuState->PC += 2; //TODO: Check this
+			break;
+		}
+		default:
+		{
+			// Anything below 0x200 would be a routine inside the VIP's interpreter, which isn't there to call
+			if constexpr (Quirks::k_bMachineCodeRoutines)
+			{
+				if (opcode >= 0x0200)
+				{
+					RunMachineCodeRoutine(opcode);
+					return;
+				}
+			}
+
+			StopOnUnknownOpCode(opcode);
 
-	m_CpuState->bIsStopped = true;
+			return;
+		}
+	}
 }
 
-bool CPU::LoadProgram(const wchar_t* FilePath)
+void CPU::RunMachineCodeRoutine(uint16_t opcode)
 {
-	std::ifstream inputFile;
-	inputFile.open(FilePath, std::ios::binary);
+	uint8_t* memory = m_CpuState->Memory;
 
-	if (inputFile.is_open())
+	memcpy(&memory[k_VipVariablesAddress], m_CpuState->V, sizeof(m_CpuState->V));
+
+	// The VIP's 64x32 display is 8 bytes a row, leftmost pixel in the top bit, which is the top half of each row's first word
+	for (int y = 0; y < ChipState::k_DisplayHeight / 2; y++)
 	{
-		inputFile.seekg(0, std::ios::end);
-		std::streampos end = inputFile.tellg();
+		const uint64_t row = m_CpuState->VideoMemory[0][y][0];
 
-		inputFile.seekg(0, std::ios::beg);
-		std::streampos begin = inputFile.tellg();
+		for (int i = 0; i < 8; i++)
+		{
+			memory[k_VipDisplayAddress + y * 8 + i] = static_cast<uint8_t>(row >> (56 - i * 8));
+		}
+	}
 
-		int fileSize = static_cast<int>(end - begin);
+	Cosmac1802State* cosmac = m_Cosmac.GetState();
 
-		char* inBuffer = new char[fileSize];
+	// R5 is the CHIP-8 program counter (Already past the 0nnn), R6/R7 point at Vx/Vy, R8 holds the timers, RA is I and RB the display page
+	cosmac->R[2] = k_VipStackAddress;
+	cosmac->R[k_VipRoutineRegister] = opcode & 0x0FFF;
+	cosmac->R[5] = static_cast<uint16_t>(m_CpuState->PC + 2);
+	cosmac->R[6] = static_cast<uint16_t>(k_VipVariablesAddress + ((opcode & 0x0F00) >> 8));
+	cosmac->R[7] = static_cast<uint16_t>(k_VipVariablesAddress + ((opcode & 0x00F0) >> 4));
+	cosmac->R[8] = static_cast<uint16_t>(m_CpuState->Delay << 8 | m_CpuState->Sound);
+	cosmac->R[0xA] = m_CpuState->I;
+	cosmac->R[0xB] = k_VipDisplayAddress;
 
-		inputFile.read(inBuffer, fileSize);
-		inputFile.close();
+	cosmac->P = k_VipRoutineRegister;
+	cosmac->X = 2;
 
-		for (int i = 0; i < fileSize; i++)
-		{
-			m_CpuState->Memory[i + 512] = (uint8_t)inBuffer[i];
-		}
+	// The interpreter runs after the display DMA at the start of each frame. Without the timing model nothing counts the cycles it's used,
+	// so every routine starts straight after the DMA.
+	m_Cosmac.SetFramePosition(static_cast<uint32_t>((k_VipDisplayCyclesPerFrame + m_FrameCycles) % k_VipCyclesPerFrame));
+	m_Cosmac.ClearWrittenRange();
 
-		//uint8_t* memBuffer = &m_CpuState->Memory[0x200];
+	m_MachineCodeCycles = m_Cosmac.Run(k_MaxMachineCodeCycles, k_VipReturnRegister);
 
-		//memcpy(memBuffer, inBuffer, fileSize);
+	// The variables and display were written above, and the routine can have written anywhere. Recorded even if it never returns,
+	// so Init still clears it all for the next ROM.
+	OnMemoryWritten(k_VipVariablesAddress, k_VipDisplayAddress + 0x100 - k_VipVariablesAddress);
 
-		//delete[] inBuffer;
+	uint16_t writtenStart;
+	size_t writtenLength;
 
-		m_CpuState->bIsStopped = false;
+	m_Cosmac.GetWrittenRange(writtenStart, writtenLength);
 
-		return true;
+	if (writtenLength > 0)
+		OnMemoryWritten(writtenStart, static_cast<uint32_t>(writtenLength));
+
+	if (cosmac->P != k_VipReturnRegister)
+	{
+		if (m_bIsLoggingEnabled)
+			std::cout << "ERROR: Machine code routine at 0x" << std::hex << std::setw(3) << std::setfill('0') << (opcode & 0x0FFF) << std::dec << std::setfill(' ')
+				<< " didn't return within " << k_MaxMachineCodeCycles << " machine cycles" << std::endl;
+
+		m_CpuState->StopOpCode = opcode;
+
+		Stop(CpuStopReason::MachineCodeRunaway);
+		return;
 	}
 
-	std::cout << "ERROR: Failed to open input '" << *FilePath << "': " << strerror(errno) << std::endl;
+	memcpy(m_CpuState->V, &memory[k_VipVariablesAddress], sizeof(m_CpuState->V));
 
-	return false;
+	m_CpuState->PC = cosmac->R[5];
+	m_CpuState->I = cosmac->R[0xA];
+	m_CpuState->Delay = static_cast<uint8_t>(cosmac->R[8] >> 8);
+	m_CpuState->Sound = static_cast<uint8_t>(cosmac->R[8]);
+
+	for (int y = 0; y < ChipState::k_DisplayHeight / 2; y++)
+	{
+		uint64_t row = 0;
+
+		for (int i = 0; i < 8; i++)
+		{
+			row |= static_cast<uint64_t>(memory[k_VipDisplayAddress + y * 8 + i]) << (56 - i * 8);
+		}
+
+		if (row != m_CpuState->VideoMemory[0][y][0])
+		{
+			m_CpuState->VideoMemory[0][y][0] = row;
+			m_CpuState->DirtyRows |= 1ull << y;
+			m_CpuState->VideoMemoryVersion++;
+		}
+	}
 }
 
-void CPU::RunCycle()
+void CPU::ScrollVertical(int rows)
 {
-	if (m_CpuState->bIsStopped) return;
+	const int displayHeight = m_CpuState->DisplayHeight();
 
-	static long long instruction_count = 0;
+	const int distance = std::min(std::abs(rows), displayHeight);
 
-	uint16_t opcode = m_CpuState->Memory[m_CpuState->PC] << 8 | m_CpuState->Memory[m_CpuState->PC + 1];
+	if (distance == 0)
+		return;
 
-	//uint16_t highBit = opcode & 0xF000;
+	const uint64_t displayRows = displayHeight == 64 ? ~0ull : (1ull << displayHeight) - 1;
 
-	switch (opcode & 0xF000)
+	for (int plane = 0; plane < ChipState::k_PlaneCount; plane++)
 	{
-		case 0x0000: Op0(opcode); break;
-		case 0x1000: Op1(opcode); break;
-		case 0x2000: Op2(opcode); break;
-		case 0x3000: Op3(opcode); break;
-		case 0x4000: Op4(opcode); break;
-		case 0x5000: Op5(opcode); break;
-		case 0x6000: Op6(opcode); break;
-		case 0x7000: Op7(opcode); break;
-		case 0x8000: Op8(opcode); break;
-		case 0x9000: Op9(opcode); break;
-		case 0xA000: OpA(opcode); break;
-		case 0xB000: OpB(opcode); break;
-		case 0xC000: OpC(opcode); break;
-		case 0xD000: OpD(opcode); break;
-		case 0xE000: OpE(opcode); break;
-		case 0xF000: OpF(opcode); break;
-		default:
+		if ((m_CpuState->SelectedPlanes & (1 << plane)) == 0)
+			continue;
+
+		uint64_t (*planeRows)[2] = m_CpuState->VideoMemory[plane];
+
+		// Only rows with something in them before or after the scroll change
+		uint64_t occupiedRows = 0;
+
+		for (int y = 0; y < displayHeight; y++)
 		{
-			std::cout << "ERROR: Unknown OpCode:" << std::hex << static_cast<int>(opcode) << std::endl;
-			Stop();
+			if ((planeRows[y][0] | planeRows[y][1]) != 0)
+				occupiedRows |= 1ull << y;
+		}
 
-			break;
+		if (rows > 0)
+		{
+			memmove(planeRows[distance], planeRows[0], (displayHeight - distance) * sizeof(planeRows[0]));
+			memset(planeRows[0], 0, distance * sizeof(planeRows[0]));
+
+			m_CpuState->DirtyRows |= (occupiedRows | (occupiedRows << distance)) & displayRows;
+		}
+		else
+		{
+			memmove(planeRows[0], planeRows[distance], (displayHeight - distance) * sizeof(planeRows[0]));
+			memset(planeRows[displayHeight - distance], 0, distance * sizeof(planeRows[0]));
+
+			m_CpuState->DirtyRows |= (occupiedRows | (occupiedRows >> distance)) & displayRows;
 		}
 	}
+
+	m_CpuState->VideoMemoryVersion++;
 }
 
-void CPU::Op0(uint16_t opcode)
+void CPU::ScrollHorizontal(bool bIsLeft)
 {
-	switch (opcode & 0x000F)
+	const int displayHeight = m_CpuState->DisplayHeight();
+
+	// In low resolution the second word of each row is past the right edge, so nothing can be scrolled into it
+	const bool bIsHighResolution = m_CpuState->bIsHighResolution;
+
+#ifdef CHIP8_USE_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i rowMask = bIsHighResolution ? _mm_set1_epi64x(-1) : _mm_set_epi64x(0, -1);
+#endif // CHIP8_USE_SSE2
+
+	for (int plane = 0; plane < ChipState::k_PlaneCount; plane++)
 	{
-		case 0x0000:
-		{
-			for (int i = 0; i < 2048; i++)
-			{
-				m_CpuState->VideoMemory[i] = 0;
-			}
-			//memset(m_CpuState->VideoMemory, 0, 2048);
+		if ((m_CpuState->SelectedPlanes & (1 << plane)) == 0)
+			continue;
 
-			m_CpuState->PC += 2;
-			break;
-		}
-		case 0x000E:
+#ifdef CHIP8_USE_SSE2
+		for (int y = 0; y < displayHeight; y++)
 		{
-			m_CpuState->SP--;
+			__m128i* displayRow = reinterpret_cast<__m128i*>(m_CpuState->VideoMemory[plane][y]);
 
-			m_CpuState->PC = m_CpuState->Stack[m_CpuState->SP];
+			const __m128i row = _mm_load_si128(displayRow);
 
-			m_CpuState->PC += 2; //TODO: Check this
-			break;
+			// Empty rows stay empty
+			if (_mm_movemask_epi8(_mm_cmpeq_epi8(row, zero)) == 0xFFFF)
+				continue;
+
+			// Both words are shifted at once, then the 4 bits that cross from one word to the other are carried over
+			__m128i scrolled;
+
+			if (bIsLeft)
+				scrolled = _mm_or_si128(_mm_slli_epi64(row, 4), _mm_srli_epi64(_mm_srli_si128(row, 8), 60));
+			else
+				scrolled = _mm_or_si128(_mm_srli_epi64(row, 4), _mm_slli_epi64(_mm_slli_si128(row, 8), 60));
+
+			_mm_store_si128(displayRow, _mm_and_si128(scrolled, rowMask));
+
+			m_CpuState->DirtyRows |= 1ull << y;
 		}
-		default:
+#else
+		for (int y = 0; y < displayHeight; y++)
 		{
-			std::cout << "ERROR: Unknown operation for Op0: 0x" << std::hex << static_cast<int>(opcode) << std::endl;
-			Stop();
+			uint64_t& left = m_CpuState->VideoMemory[plane][y][0];
+			uint64_t& right = m_CpuState->VideoMemory[plane][y][1];
 
-			return;
+			// Empty rows stay empty
+			if ((left | right) == 0)
+				continue;
+
+			if (bIsLeft)
+			{
+				left = (left << 4) | (right >> 60);
+				right <<= 4;
+			}
+			else
+			{
+				right = bIsHighResolution ? (right >> 4) | (left << 60) : 0;
+				left >>= 4;
+			}
+
+			m_CpuState->DirtyRows |= 1ull << y;
 		}
+#endif // CHIP8_USE_SSE2
 	}
+
+	m_CpuState->VideoMemoryVersion++;
 }
 
 void CPU::Op1(uint16_t opcode)
@@ -192,19 +1095,41 @@ void CPU::Op1(uint16_t opcode)
 	m_CpuState->PC = opcode & 0x0FFF;
 }
 
+template<typename Quirks>
 void CPU::Op2(uint16_t opcode)
 {
-	m_CpuState->Stack[m_CpuState->SP] = m_CpuState->PC;
-	m_CpuState->SP++;
+	if (!IsStackAccessValid<Quirks>(true, opcode))
+		return;
+
+	m_CpuState->Stack[m_CpuState->SP & 0xF] = m_CpuState->PC;
+	m_CpuState->SP = (m_CpuState->SP + 1) & k_StackPointerMask;
 
 	m_CpuState->PC = opcode & 0x0FFF;
 }
 
+template<typename Quirks>
+void CPU::SkipNextInstruction()
+{
+	const uint32_t next = m_CpuState->PC + 2u;
+
+	if constexpr (Quirks::k_bXoChipOpCodes)
+	{
+		if (next + 1 < sizeof(m_CpuState->Memory) && m_CpuState->Memory[next] == 0xF0 && m_CpuState->Memory[next + 1] == 0x00)
+		{
+			m_CpuState->PC += 6;
+			return;
+		}
+	}
+
+	m_CpuState->PC += 4;
+}
+
+template<typename Quirks>
 void CPU::Op3(uint16_t opcode)
 {
 	if (m_CpuState->V[(opcode & 0x0F00) >> 8] == (opcode & 0x00FF))
 	{
-		m_CpuState->PC += 4;
+		SkipNextInstruction<Quirks>();
 	}
 	else
 	{
@@ -212,11 +1137,12 @@ void CPU::Op3(uint16_t opcode)
 	}
 }
 
+template<typename Quirks>
 void CPU::Op4(uint16_t opcode)
 {
 	if (m_CpuState->V[(opcode & 0x0F00) >> 8] != (opcode & 0x00FF))
 	{
-		m_CpuState->PC += 4;
+		SkipNextInstruction<Quirks>();
 	}
 	else
 	{
@@ -224,11 +1150,47 @@ void CPU::Op4(uint16_t opcode)
 	}
 }
 
+template<typename Quirks>
 void CPU::Op5(uint16_t opcode)
 {
-	if (m_CpuState->V[(opcode & 0x0F00) >> 8] == m_CpuState->V[(opcode & 0x00F0 >> 4)])
+	const uint8_t x = (opcode & 0x0F00) >> 8;
+	const uint8_t y = (opcode & 0x00F0) >> 4;
+
+	if constexpr (Quirks::k_bXoChipOpCodes)
+	{
+		const uint8_t operation = opcode & 0x000F;
+
+		if (operation == 0x2 || operation == 0x3)
+		{
+			// Registers are stored or loaded in the order given, so 5xy2 with x > y writes them to memory backwards
+			const int count = std::abs(x - y) + 1;
+			const int step = x <= y ? 1 : -1;
+
+			if (!IsMemoryAccessValid<Quirks>(m_CpuState->I, count, opcode))
+				return;
+
+			for (int i = 0; i < count; i++)
+			{
+				uint8_t& value = m_CpuState->V[x + i * step];
+				uint8_t& memoryValue = MemoryAt(m_CpuState->I + i);
+
+				if (operation == 0x2)
+					memoryValue = value;
+				else
+					value = memoryValue;
+			}
+
+			if (operation == 0x2)
+				OnMemoryWritten(m_CpuState->I, count);
+
+			m_CpuState->PC += 2;
+			return;
+		}
+	}
+
+	if (m_CpuState->V[x] == m_CpuState->V[y])
 	{
-		m_CpuState->PC += 4;
+		SkipNextInstruction<Quirks>();
 	}
 	else
 	{
@@ -250,124 +1212,104 @@ void CPU::Op7(uint16_t opcode)
 	m_CpuState->PC += 2;
 }
 
+template<typename Quirks>
 void CPU::Op8(uint16_t opcode)
 {
+	uint8_t& vx = m_CpuState->V[(opcode & 0x0F00) >> 8];
+	const uint8_t vy = m_CpuState->V[(opcode & 0x00F0) >> 4];
+
+	// V[15] is written after the result, so it holds the flag even when it's also the destination register
 	switch (opcode & 0x000F)
 	{
 		case 0x0000:
 		{
-			m_CpuState->V[(opcode & 0x0F00) >> 8] = m_CpuState->V[(opcode & 0x00F0) >> 4];
-
-			m_CpuState->PC += 2;
+			vx = vy;
 			break;
 		}
 		case 0x0001:
 		{
-			m_CpuState->V[(opcode & 0x00F00) >> 8] |= m_CpuState->V[(opcode & 0x00F0) >> 4];
-			
-			m_CpuState->PC += 2;
+			vx |= vy;
+
+			if constexpr (Quirks::k_bResetVfOnLogic)
+				m_CpuState->V[0xF] = 0;
+
 			break;
 		}
 		case 0x0002:
 		{
-			m_CpuState->V[(opcode & 0x0F00) >> 8] &= m_CpuState->V[(opcode & 0x00F0) >> 4];
+			vx &= vy;
 
-			m_CpuState->PC += 2;
+			if constexpr (Quirks::k_bResetVfOnLogic)
+				m_CpuState->V[0xF] = 0;
 
 			break;
 		}
 		case 0x0003:
 		{
-			m_CpuState->V[(opcode & 0x0F00) >> 8] ^= m_CpuState->V[(opcode & 0x00F0) >> 4];
+			vx ^= vy;
 
-			m_CpuState->PC += 2;
+			if constexpr (Quirks::k_bResetVfOnLogic)
+				m_CpuState->V[0xF] = 0;
 
 			break;
 		}
 		case 0x0004:
 		{
-			m_CpuState->V[(opcode & 0x0F00) >> 8] += m_CpuState->V[(opcode & 0x00F0) >> 4];
-
-			if (m_CpuState->V[(opcode & 0x00F0) >> 4] > (0xFF - m_CpuState->V[(opcode & 0x0F00) >> 8]))
-			{
-				m_CpuState->V[0xF] = 1;
-			}
-			else
-			{
-				m_CpuState->V[0xF] = 0;
-			}
-
-			m_CpuState->PC += 2;
+			const uint16_t sum = vx + vy;
 
+			vx = static_cast<uint8_t>(sum);
+			m_CpuState->V[0xF] = sum > 0xFF ? 1 : 0;
 			break;
 		}
 		case 0x0005:
 		{
-			if (m_CpuState->V[(opcode & 0x00F0) >> 4] > m_CpuState->V[(opcode & 0x0F00) >> 8])
-			{
-				m_CpuState->V[0xF] = 0;
-			}
-			else
-			{
-				m_CpuState->V[0xF] = 1;
-			}
-			
-			m_CpuState->V[(opcode & 0x0F00) >> 8] -= m_CpuState->V[(opcode & 0x00F0) >> 4];
+			const uint8_t noBorrow = vx >= vy ? 1 : 0;
 
-			m_CpuState->PC += 2;
+			vx -= vy;
+			m_CpuState->V[0xF] = noBorrow;
 			break;
 		}
 		case 0x0006:
 		{
-			m_CpuState->V[0xF] = m_CpuState->V[(opcode & 0x0F00) >> 8] & 0x1;
-
-			m_CpuState->V[(opcode & 0x0F00) >> 8] >>= 1;
-
-			m_CpuState->PC += 2;
+			const uint8_t source = Quirks::k_bShiftUsesVy ? vy : vx;
 
+			vx = source >> 1;
+			m_CpuState->V[0xF] = source & 0x1;
 			break;
 		}
 		case 0x0007:
 		{
-			if (m_CpuState->V[(opcode & 0x0F00) >> 8] > m_CpuState->V[(opcode & 0x00F0) >> 4])
-			{
-				m_CpuState->V[0xF] = 0;
-			}
-			else
-			{
-				m_CpuState->V[0xF] = 1;
-			}
-
-			m_CpuState->V[(opcode & 0x0F00) >> 8] = m_CpuState->V[(opcode & 0x00F0) >> 4] - m_CpuState->V[(opcode & 0x0F00) >> 8];
-
-			m_CpuState->PC += 2;
+			const uint8_t noBorrow = vy >= vx ? 1 : 0;
 
+			vx = vy - vx;
+			m_CpuState->V[0xF] = noBorrow;
 			break;
 		}
 		case 0x000E:
 		{
-			m_CpuState->V[0xF] = m_CpuState->V[(opcode & 0x0F00) >> 8] >> 7;
-			m_CpuState->V[(opcode & 0x0F00) >> 8] <<= 1;
-
-			m_CpuState->PC += 2;
+			const uint8_t source = Quirks::k_bShiftUsesVy ? vy : vx;
 
+			vx = static_cast<uint8_t>(source << 1);
+			m_CpuState->V[0xF] = source >> 7;
 			break;
 		}
 		default:
 		{
-			std::cout << "ERROR: Unknown operation for Op8: 0x" << std::hex << std::setw(2) << static_cast<int>(opcode) << std::endl;
-			Stop();
+			StopOnUnknownOpCode(opcode);
 
 			return;
 		}
 	}
+
+	m_CpuState->PC += 2;
 }
 
+template<typename Quirks>
 void CPU::Op9(uint16_t opcode)
 {
 	if (m_CpuState->V[(opcode & 0x0F00) >> 8] != m_CpuState->V[(opcode & 0x00F0) >> 4])
 	{
-		m_CpuState->PC += 4;
+		SkipNextInstruction<Quirks>();
 	}
 	else
 	{
@@ -382,54 +1324,124 @@ void CPU::OpA(uint16_t opcode)
 	m_CpuState->PC += 2;
 }
 
+template<typename Quirks>
 void CPU::OpB(uint16_t opcode)
 {
-	uint16_t address = (opcode & 0x0FFF) + m_CpuState->V[0];
+	const uint8_t offsetRegister = Quirks::k_bJumpUsesVx ? (opcode & 0x0F00) >> 8 : 0;
 
-	m_CpuState->PC = address;
+	m_CpuState->PC = (opcode & 0x0FFF) + m_CpuState->V[offsetRegister];
 }
 
 void CPU::OpC(uint16_t opcode)
 {
-	m_CpuState->V[(opcode & 0x0F00) >> 8] = (rand() % (0xFF + 1)) & (opcode & 0x00FF);
+	m_CpuState->V[(opcode & 0x0F00) >> 8] = NextRandomByte() & (opcode & 0x00FF);
 
 	m_CpuState->PC += 2;
 }
 
+template<typename Quirks>
 void CPU::OpD(uint16_t opcode)
 {
-	uint16_t spriteX = m_CpuState->V[(opcode & 0x0F00) >> 8];
-	uint16_t spriteY = m_CpuState->V[(opcode & 0x00F0) >> 4];
+	const uint16_t displayWidth = static_cast<uint16_t>(m_CpuState->DisplayWidth());
+	const uint16_t displayHeight = static_cast<uint16_t>(m_CpuState->DisplayHeight());
+
+	// The starting position always wraps, whichever quirks are in use
+	uint16_t spriteX = m_CpuState->V[(opcode & 0x0F00) >> 8] % displayWidth;
+	uint16_t spriteY = m_CpuState->V[(opcode & 0x00F0) >> 4] % displayHeight;
 
 	uint16_t height = opcode & 0x000F;
 
-	m_CpuState->V[0xF] = 0;
+	// Dxy0 draws a 16x16 sprite on SCHIP, 2 bytes per row
+	const bool bIsLargeSprite = Quirks::k_bSuperChipOpCodes && height == 0;
+
+	if (bIsLargeSprite)
+		height = 16;
+
+	// Bytes of sprite data per plane
+	const uint16_t spriteSize = bIsLargeSprite ? 32 : height;
+
+	// Each selected plane draws the next sprite's worth of data from I, lowest plane first
+	uint16_t spriteAddress = m_CpuState->I;
 
-	for (int row = 0; row < height; row++)
+	const uint32_t planeCount = (m_CpuState->SelectedPlanes & 1) + ((m_CpuState->SelectedPlanes >> 1) & 1);
+
+	if (!IsMemoryAccessValid<Quirks>(spriteAddress, spriteSize * planeCount, opcode))
+		return;
+
+	bool bHasCollided = false;
+
+	for (int plane = 0; plane < ChipState::k_PlaneCount; plane++)
 	{
-		uint16_t pixel = m_CpuState->Memory[m_CpuState->I + row];
-		
-		for (int col = 0; col < 8; col++)
+		if ((m_CpuState->SelectedPlanes & (1 << plane)) == 0)
+			continue;
+
+		for (int row = 0; row < height; row++)
 		{
-			if ((pixel & (0x80 >> col)) != 0)
+			uint16_t y = spriteY + row;
+
+			if (Quirks::k_bClipSprites && y >= displayHeight)
+				break;
+
+			y %= displayHeight;
+
+			// Sprite row with its leftmost pixel in the top bit, ready to be shifted into place
+			uint64_t spriteRow;
+
+			if (bIsLargeSprite)
+				spriteRow = static_cast<uint64_t>(MemoryAt(spriteAddress + row * 2) << 8 | MemoryAt(spriteAddress + row * 2 + 1)) << 48;
+			else
+				spriteRow = static_cast<uint64_t>(MemoryAt(spriteAddress + row)) << 56;
+
+			// The sprite row shifted across the two words of a 128 pixel display row. Anything past the right edge of the high resolution display drops off the end.
+			uint64_t left = spriteX < 64 ? spriteRow >> spriteX : 0;
+			uint64_t right = spriteX == 0 ? 0 : (spriteX < 64 ? spriteRow << (64 - spriteX) : spriteRow >> (spriteX - 64));
+
+			if (displayWidth == 64)
 			{
-				if (m_CpuState->VideoMemory[(spriteX + col + ((spriteY + row) * 64))] == 1)
-				{
-					m_CpuState->V[0xF] = 1;
-				}
-				m_CpuState->VideoMemory[spriteX + col + ((spriteY + row) * 64)] ^= 1;
+				// In low resolution the second word is entirely past the right edge, so it either wraps around into the first word or is clipped
+				if (!Quirks::k_bClipSprites)
+					left |= right;
+
+				right = 0;
+			}
+			else if (!Quirks::k_bClipSprites && spriteX > 64)
+			{
+				// Wrap the pixels that dropped off the right edge of the high resolution display
+				left |= spriteRow << (128 - spriteX);
 			}
+
+			uint64_t* displayRow = m_CpuState->VideoMemory[plane][y];
+
+			bHasCollided |= ((displayRow[0] & left) | (displayRow[1] & right)) != 0;
+
+			displayRow[0] ^= left;
+			displayRow[1] ^= right;
+
+			if ((left | right) != 0)
+				m_CpuState->DirtyRows |= 1ull << y;
 		}
+
+		spriteAddress += spriteSize;
 	}
 
+	m_CpuState->V[0xF] = bHasCollided ? 1 : 0;
+
+	m_CpuState->VideoMemoryVersion++;
+
 	m_CpuState->PC += 2;
 }
 
+template<typename Quirks>
 void CPU::OpE(uint16_t opcode)
 {
 	uint8_t registerIdx = (opcode & 0x0F00) >> 8;
 
-	uint8_t keyState = m_CpuState->KeyState[m_CpuState->V[registerIdx]];
+	const uint8_t key = m_CpuState->V[registerIdx];
+
+	if (!IsKeyValid<Quirks>(key, opcode))
+		return;
+
+	uint8_t keyState = m_CpuState->KeyState[key & 0xF];
 
 	uint16_t lowByte = opcode & 0x00FF;
 
@@ -439,7 +1451,8 @@ void CPU::OpE(uint16_t opcode)
 		{
 			if (keyState != 0)
 			{
-				m_CpuState->PC += 2;
+				SkipNextInstruction<Quirks>();
+				return;
 			}
 			break;
 		}
@@ -447,14 +1460,14 @@ void CPU::OpE(uint16_t opcode)
 		{
 			if (keyState == 0)
 			{
-				m_CpuState->PC += 2;
+				SkipNextInstruction<Quirks>();
+				return;
 			}
 			break;
 		}
 		default:
 		{
-			std::cout << "ERROR: Unknown operation for OpE: 0x" << std::hex << std::setw(2) << static_cast<int>(opcode) << std::endl;
-			Stop();
+			StopOnUnknownOpCode(opcode);
 
 			return;
 		}
@@ -463,6 +1476,7 @@ void CPU::OpE(uint16_t opcode)
 	m_CpuState->PC += 2;
 }
 
+template<typename Quirks>
 void CPU::OpF(uint16_t opcode)
 {
 	uint16_t registerIdx = (opcode & 0x0F00) >> 8;
@@ -471,6 +1485,50 @@ void CPU::OpF(uint16_t opcode)
 
 	switch (lowByte)
 	{
+		case 0x0000:
+		case 0x0001:
+		case 0x0002:
+		{
+			if constexpr (Quirks::k_bXoChipOpCodes)
+			{
+				if (opcode == 0xF000)
+				{
+					// The address is the whole of the next word, which is skipped over
+					const uint32_t next = m_CpuState->PC + 2u;
+
+					if (!IsMemoryAccessValid<Quirks>(next, 2, opcode))
+						return;
+
+					m_CpuState->I = static_cast<uint16_t>(MemoryAt(next) << 8 | MemoryAt(next + 1));
+
+					m_CpuState->PC += 4;
+					return;
+				}
+
+				if (lowByte == 0x0001)
+				{
+					m_CpuState->SelectedPlanes = registerIdx & 0x3;
+					break;
+				}
+
+				if (opcode == 0xF002)
+				{
+					if (!IsMemoryAccessValid<Quirks>(m_CpuState->I, sizeof(m_CpuState->AudioPattern), opcode))
+						return;
+
+					for (uint32_t i = 0; i < sizeof(m_CpuState->AudioPattern); i++)
+					{
+						m_CpuState->AudioPattern[i] = MemoryAt(m_CpuState->I + i);
+					}
+
+					m_CpuState->bHasAudioPattern = true;
+					break;
+				}
+			}
+
+			StopOnUnknownOpCode(opcode);
+			return;
+		}
 		case 0x0007:
 		{
 			m_CpuState->V[registerIdx] = m_CpuState->Delay;
@@ -519,7 +1577,8 @@ void CPU::OpF(uint16_t opcode)
 		}
 		case 0x001E:
 		{
-			if (m_CpuState->I + m_CpuState->V[registerIdx] > 0xFFF)
+			// VF flags I going past the end of the interpreter's memory (0xFFFF with XO-CHIP's 64KB)
+			if (static_cast<uint32_t>(m_CpuState->I) + m_CpuState->V[registerIdx] > Quirks::k_MemorySize - 1)
 			{
 				m_CpuState->V[0xF] = 1;
 			}
@@ -536,26 +1595,65 @@ void CPU::OpF(uint16_t opcode)
 			m_CpuState->I = Sprites::FONT_START + (m_CpuState->V[registerIdx] * 0x5);
 			break;
 		}
+		case 0x0030:
+		{
+			if constexpr (Quirks::k_bSuperChipOpCodes)
+			{
+				m_CpuState->I = Sprites::BIG_FONT_START + ((m_CpuState->V[registerIdx] & 0xF) * 10);
+			}
+			else
+			{
+				StopOnUnknownOpCode(opcode);
+				return;
+			}
+			break;
+		}
 		case 0x0033:
 		{
 			uint8_t value = m_CpuState->V[registerIdx];
 
-			m_CpuState->Memory[m_CpuState->I] = value / 100;
-			m_CpuState->Memory[m_CpuState->I + 1] = (value / 10) % 10;
-			m_CpuState->Memory[m_CpuState->I + 2] = value % 10;
+			if (!IsMemoryAccessValid<Quirks>(m_CpuState->I, 3, opcode))
+				return;
+
+			MemoryAt(m_CpuState->I) = value / 100;
+			MemoryAt(m_CpuState->I + 1) = (value / 10) % 10;
+			MemoryAt(m_CpuState->I + 2) = value % 10;
 
+			OnMemoryWritten(m_CpuState->I, 3);
+
+			break;
+		}
+		case 0x003A:
+		{
+			if constexpr (Quirks::k_bXoChipOpCodes)
+			{
+				m_CpuState->Pitch = m_CpuState->V[registerIdx];
+			}
+			else
+			{
+				StopOnUnknownOpCode(opcode);
+				return;
+			}
 			break;
 		}
 		case 0x0055:
 		{
 			uint16_t offset = m_CpuState->I;
 
+			if (!IsMemoryAccessValid<Quirks>(offset, registerIdx + 1, opcode))
+				return;
+
 			for (uint8_t i = 0; i <= registerIdx; i++)
 			{
-				m_CpuState->Memory[offset + i] = m_CpuState->V[i];
+				MemoryAt(offset + i) = m_CpuState->V[i];
 			}
 
-			m_CpuState->I += (registerIdx + 1);
+			OnMemoryWritten(offset, registerIdx + 1);
+
+			if constexpr (Quirks::k_LoadStoreIncrement == LoadStoreIncrement::XPlusOne)
+				m_CpuState->I += (registerIdx + 1);
+			else if constexpr (Quirks::k_LoadStoreIncrement == LoadStoreIncrement::X)
+				m_CpuState->I += registerIdx;
 
 			break;
 		}
@@ -563,18 +1661,43 @@ void CPU::OpF(uint16_t opcode)
 		{
 			uint16_t offset = m_CpuState->I;
 
+			if (!IsMemoryAccessValid<Quirks>(offset, registerIdx + 1, opcode))
+				return;
+
 			for (uint8_t i = 0; i <= registerIdx; i++)
 			{
-				m_CpuState->V[i] = m_CpuState->Memory[offset + i];
+				m_CpuState->V[i] = MemoryAt(offset + i);
 			}
 
-			m_CpuState->I += (registerIdx + 1);
+			if constexpr (Quirks::k_LoadStoreIncrement == LoadStoreIncrement::XPlusOne)
+				m_CpuState->I += (registerIdx + 1);
+			else if constexpr (Quirks::k_LoadStoreIncrement == LoadStoreIncrement::X)
+				m_CpuState->I += registerIdx;
+			break;
+		}
+		case 0x0075:
+		case 0x0085:
+		{
+			if constexpr (Quirks::k_bSuperChipOpCodes)
+			{
+				for (uint8_t i = 0; i <= registerIdx; i++)
+				{
+					if (lowByte == 0x0075)
+						m_CpuState->FlagRegisters[i] = m_CpuState->V[i];
+					else
+						m_CpuState->V[i] = m_CpuState->FlagRegisters[i];
+				}
+			}
+			else
+			{
+				StopOnUnknownOpCode(opcode);
+				return;
+			}
 			break;
 		}
 		default:
 		{
-			std::cout << "ERROR: Unknown operation for OpF: 0x" << std::hex << std::setw(2) << static_cast<int>(opcode) << std::endl;
-			Stop();
+			StopOnUnknownOpCode(opcode);
 
 			return;
 		}
@@ -5,17 +5,65 @@
 
 #include <errno.h>
 
+#include "Cosmac1802.h"
+#include "Quirks.h"
 #include "Sprites.h"
 
+// The display scrolls use SSE2 where it's guaranteed to be available
+#if defined(_M_X64) || defined(__SSE2__)
+#define CHIP8_USE_SSE2
+#endif // _M_X64 || __SSE2__
+
+/**
+ * Why the CPU stopped executing instructions
+ */
+enum class CpuStopReason : uint8_t
+{
+	// Still running, or never had a program loaded
+	None,
+
+	// Stop() was called from outside the CPU
+	Requested,
+
+	// The program tried to execute an instruction the CPU doesn't recognise
+	UnknownOpCode,
+
+	// The program ran SCHIP's exit instruction (00FD)
+	Exited,
+
+	// A machine code routine called with 0nnn didn't return to the interpreter
+	MachineCodeRunaway,
+
+	// An instruction accessed memory past the end of the interpreter's memory (Checked memory access only)
+	MemoryOutOfRange,
+
+	// A call went deeper than the 16 level stack, or a return was made with nothing on it (Checked memory access only)
+	StackOverflow,
+	StackUnderflow,
+
+	// Ex9E/ExA1 tested a key past the 16 on the keypad (Checked memory access only)
+	KeyOutOfRange
+};
+
 /**
  * Represents the internal state of the CPU (Stack pointer, registers, memory etc)
  */
 struct ChipState
 {
+	// Size of the display in SCHIP's high resolution mode. The standard (low) resolution is half this in each direction.
+	static constexpr int k_DisplayWidth = 128;
+	static constexpr int k_DisplayHeight = 64;
+
+	// Number of bitplanes in the display (XO-CHIP). Each pixel's colour is made up of one bit from each plane.
+	static constexpr int k_PlaneCount = 2;
+
+	// Size of the XO-CHIP audio pattern buffer in bytes (128 one-bit samples)
+	static constexpr int k_AudioPatternSize = 16;
+
 	// 16 8-bit general purpose registers (Referred to by OpCodes as Vx, where X = the specific register the OpCode references).
 	uint8_t V[16] = { 0 };
 
-	// I register - Usually stores memory addresses, so generally only the lowest 12-bits are used
+	// I register - Stores memory addresses. Annn only sets the lowest 12-bits, XO-CHIP's F000 NNNN sets all 16.
 	uint16_t I;
 
 	// Program Counter - The current address in memory being executed
@@ -32,11 +80,37 @@ struct ChipState
 	// Sound Register
 	uint8_t Sound;
 
-	// Program memory of the loaded ROM
-	uint8_t Memory[4096];
+	// Program memory of the loaded ROM. XO-CHIP's full 64KB; CHIP-8 and SCHIP ROMs only use the first 4KB.
+	uint8_t Memory[65536];
+
+	// Video RAM for what is currently being drawn on-screen, as separate bitplanes. One bit per pixel, with each 128 pixel row held in two
+	// 64-bit words and the leftmost pixel in the top bit of the first word, so a whole sprite row is drawn with a couple of shifts and XORs.
+	// In low resolution only the first word of the first 32 rows is used. Only XO-CHIP ROMs use the second plane.
+	alignas(16) uint64_t VideoMemory[k_PlaneCount][k_DisplayHeight][2];
+
+	// Bit N is set if plane N is drawn to, cleared and scrolled (XO-CHIP's Fn01)
+	uint8_t SelectedPlanes = 1;
+
+	// Set to true when SCHIP's 128x64 mode is active (00FF). Otherwise the display is 64x32.
+	bool bIsHighResolution = false;
 
-	// Video RAM for what is currently being drawn on-screen
-	uint8_t VideoMemory[2048];
+	// Incremented whenever the Video RAM is written to, so the display only needs updating when this has changed since it was last drawn
+	uint32_t VideoMemoryVersion = 0;
+
+	// Bit N is set when row N of the Video RAM has changed, so the display only needs to re-upload those rows. Cleared by 'CPU::TakeDirtyRows'.
+	uint64_t DirtyRows = ~0ull;
+
+	// SCHIP's persistent flag registers, written and read by Fx75/Fx85 (The HP-48's RPL user flags)
+	uint8_t FlagRegisters[16] = { 0 };
+
+	// XO-CHIP's 1-bit audio samples, played while the Sound register is above zero (Loaded by F002)
+	uint8_t AudioPattern[k_AudioPatternSize] = { 0 };
+
+	// Set once F002 has loaded an audio pattern. Until then the beeper plays its square wave (A loaded pattern can be all zeroes).
+	bool bHasAudioPattern = false;
+
+	// XO-CHIP's playback rate for the audio pattern (Fx3A). The default of 64 plays at 4000 samples a second.
+	uint8_t Pitch = 64;
 
 	// Keyboard key states (0 = Up | 1 = Down). Only 16 keys are available on the CHIP-8.
 	uint8_t KeyState[16] = { 0 };
@@ -49,6 +123,33 @@ struct ChipState
 
 	// If set to true the CPU won't execute any more instructions
 	bool bIsStopped = true;
+
+	// Why the CPU was stopped, and the OpCode it stopped on if it didn't recognise one (Or it made an out of range access)
+	CpuStopReason StopReason = CpuStopReason::None;
+	uint16_t StopOpCode = 0;
+
+	// First address out of range when the CPU stopped on an out of range memory access (Or the key, for a key out of range)
+	uint32_t FaultAddress = 0;
+
+	/// <summary>
+	/// Gets the width of the display in the current resolution
+	/// </summary>
+	int DisplayWidth() const { return bIsHighResolution ? k_DisplayWidth : k_DisplayWidth / 2; }
+
+	/// <summary>
+	/// Gets the height of the display in the current resolution
+	/// </summary>
+	int DisplayHeight() const { return bIsHighResolution ? k_DisplayHeight : k_DisplayHeight / 2; }
+
+	/// <summary>
+	/// Checks if a pixel is lit on a plane. Coordinates are in the current resolution.
+	/// </summary>
+	bool IsPixelSet(int plane, int x, int y) const { return ((VideoMemory[plane][y][x >> 6] >> (63 - (x & 63))) & 1) != 0; }
+
+	/// <summary>
+	/// Gets the colour of a pixel (0-3), made up of its bit from each plane. Coordinates are in the current resolution.
+	/// </summary>
+	uint8_t PixelColour(int x, int y) const { return static_cast<uint8_t>((IsPixelSet(0, x, y) ? 1 : 0) | (IsPixelSet(1, x, y) ? 2 : 0)); }
 };
 
 /**
@@ -56,10 +157,130 @@ struct ChipState
  */
 class CPU
 {
+	// Benchmarks the scroll instructions directly (--bench-scroll)
+	friend class HeadlessRunner;
+
 private:
 	// Pointer to the current execution state of the CPU
 	ChipState* m_CpuState = nullptr;
 
+	// State of the xorshift generator used by the random number instruction. Kept per-CPU so seeded runs are reproducible.
+	uint32_t m_RandomState = 1;
+
+	// Set to false to stop the CPU writing errors and info messages to the console
+	bool m_bIsLoggingEnabled = true;
+
+	// Quirks the CPU emulates, and the instruction loop specialised for them. Selected once per ROM so instructions never check quirks themselves.
+	QuirkProfile m_QuirkProfile = QuirkProfile::CosmacVip;
+	uint32_t (CPU::*m_RunCycles)(uint32_t count) = nullptr;
+
+	// Set to true to check every memory and stack access, stopping on the first one out of range. Debug builds check by default.
+#ifdef _DEBUG
+	bool m_bIsMemoryCheckEnabled = true;
+#else
+	bool m_bIsMemoryCheckEnabled = false;
+#endif // _DEBUG
+
+	// Addresses are masked to the size of memory when they aren't checked. The stack pointer wraps at 32 rather than 16, so a full stack
+	// still has a stack pointer of 16 as it would when checked.
+	static constexpr uint32_t k_AddressMask = sizeof(ChipState::Memory) - 1;
+	static constexpr uint16_t k_StackPointerMask = 0x1F;
+
+	// Set to false to execute every instruction of an idle loop rather than skipping to the end of the batch
+	bool m_bIsIdleSkipEnabled = true;
+
+	// Instructions skipped by idle loop detection since the CPU was initialised
+	uint64_t m_IdleInstructionsSkipped = 0;
+
+	// Common instruction sequences that are executed by a single handler when fusion is enabled
+	enum class FusedOp : uint8_t
+	{
+		// The address hasn't been decoded yet
+		Undecoded,
+
+		// The instructions at the address don't start a fusable sequence
+		None,
+
+		// Annn; Dxyn - Point I at a sprite and draw it
+		LoadIDraw,
+
+		// 6xkk; 6ykk - Load two registers
+		LoadPair,
+
+		// Fx07; 3xkk - Read the delay timer and test it
+		ReadDelaySkip,
+
+		// 7x01; 3xkk; 1nnn - Increment a loop counter and jump back until it reaches a limit
+		CountedLoop
+	};
+
+	// Longest fused sequence, in instructions. A sequence is only fused when at least this many instructions are left in the batch.
+	static constexpr uint32_t k_MaxFusedLength = 3;
+
+	// Set to true to execute common instruction sequences with a single fused handler
+	bool m_bIsFusionEnabled = false;
+
+	// Fused sequence starting at each address, decoded the first time the address is executed. Entries are reset to 'Undecoded'
+	// when the memory they cover is written, so self-modifying code is decoded again.
+	FusedOp m_DecodeCache[sizeof(ChipState::Memory)] = {};
+
+	// One past the highest address decoded, so invalidating the cache doesn't have to clear all 64KB of it
+	size_t m_DecodeCacheExtent = sizeof(ChipState::Memory);
+
+	// One past the highest address of memory that might not be zero. Init only clears this much, so running a 4KB ROM after a 4KB ROM never
+	// touches the other 60KB (Which matters when each thread runs thousands of ROMs).
+	size_t m_MemoryExtent = sizeof(ChipState::Memory);
+
+	// Instructions executed as part of a fused sequence since the CPU was initialised
+	uint64_t m_FusedInstructions = 0;
+
+	// The instruction loop for the COSMAC VIP timing model, specialised for the current quirks like 'm_RunCycles'
+	uint32_t (CPU::*m_RunMachineCycles)(uint32_t cycles) = nullptr;
+
+	// Machine cycles left to run on the COSMAC VIP timing model. Goes negative when an instruction overruns the cycles it was given,
+	// and the overrun is taken out of the next call.
+	int64_t m_CycleBalance = 0;
+
+	// Machine cycles the interpreter has used since the last timer tick (The start of the frame) on the COSMAC VIP timing model
+	uint64_t m_FrameCycles = 0;
+
+	// Set when a sprite is about to be drawn on the COSMAC VIP timing model. Nothing runs until the next vertical blank (The next timer tick).
+	bool m_bIsWaitingForVBlank = false;
+
+	// Set by the vertical blank that ends a wait, so the sprite that was waiting is drawn at the start of the frame
+	bool m_bHasVBlankPassed = false;
+
+	// Machine cycles the VIP interpreter spends fetching, decoding and dispatching every instruction
+	static constexpr uint32_t k_VipFetchCycles = 40;
+
+	// Runs the machine code routines hybrid ROMs call with 0nnn
+	Cosmac1802 m_Cosmac;
+
+	// Machine cycles spent in the last 0nnn routine, charged to the COSMAC VIP timing model on top of the instruction itself
+	uint64_t m_MachineCodeCycles = 0;
+
+	// Where the VIP's interpreter kept its state in the 4KB memory map, which is where routines expect to find it
+	static constexpr uint16_t k_VipStackAddress = 0x0ECF;
+	static constexpr uint16_t k_VipVariablesAddress = 0x0EF0;
+	static constexpr uint16_t k_VipDisplayAddress = 0x0F00;
+
+	// The interpreter switches the 1802's program counter to R3 to call a routine, and the routine returns with SEP R4
+	static constexpr uint8_t k_VipRoutineRegister = 3;
+	static constexpr uint8_t k_VipReturnRegister = 4;
+
+	// Most machine cycles a routine can run for before it's treated as never returning (One second on the VIP)
+	static constexpr uint64_t k_MaxMachineCodeCycles = 60 * Cosmac1802::k_CyclesPerFrame;
+
+public:
+	// 1802 machine cycles in each 60Hz frame on the COSMAC VIP (A 1.7609MHz clock, with 8 clocks per machine cycle)
+	static constexpr uint32_t k_VipCyclesPerFrame = Cosmac1802::k_CyclesPerFrame;
+
+	// Machine cycles of each frame taken by the display DMA (8 bytes for each of the 128 scanlines) and the interrupt routine that ticks the timers
+	static constexpr uint32_t k_VipDisplayCyclesPerFrame = 1024 + 30;
+
+	// Machine cycles of each frame left for the interpreter to run instructions in
+	static constexpr uint32_t k_VipInterpreterCyclesPerFrame = k_VipCyclesPerFrame - k_VipDisplayCyclesPerFrame;
+
 public:
 	/// <summary>
 	/// Initialises the CPU and sets the initial state. Must be called before trying to load a program.
@@ -69,7 +290,20 @@ public:
 	/// <summary>
 	/// Stops the CPU executing any more instructions
 	/// </summary>
-	void Stop();
+	/// <param name="reason">Why the CPU is being stopped</param>
+	void Stop(CpuStopReason reason = CpuStopReason::Requested);
+
+	/// <summary>
+	/// Seeds the random number generator used by the 0xCxkk instruction. Init seeds it from the current time.
+	/// </summary>
+	/// <param name="seed">Seed value. The same seed always produces the same sequence of random numbers.</param>
+	void SetSeed(uint32_t seed);
+
+	/// <summary>
+	/// Enables or disables the CPU's console messages (e.g. when running lots of ROMs at once)
+	/// </summary>
+	/// <param name="bIsEnabled">True to write messages to the console, false to silence them</param>
+	void SetLoggingEnabled(bool bIsEnabled);
 
 	/// <summary>
 	/// Loads a ROM into the CPU's memory at address 0x200. CPU must be initialised before calling this function.
@@ -78,11 +312,103 @@ public:
 	/// <returns>True if the program was loaded successfully. Otherwise false</returns>
 	bool LoadProgram(const wchar_t* FilePath);
 
+	/// <summary>
+	/// Loads a ROM that's already in memory into the CPU's memory at address 0x200. CPU must be initialised before calling this function.
+	/// </summary>
+	/// <param name="data">Contents of the ROM</param>
+	/// <param name="size">Size of the ROM in bytes</param>
+	/// <returns>True if the program was loaded successfully. False if it's too large to fit in memory</returns>
+	bool LoadProgram(const uint8_t* data, size_t size);
+
 	/// <summary>
 	/// Runs a single CPU cycle, emulating the current instruction being pointed to by the program counter
 	/// </summary>
 	void RunCycle();
 
+	/// <summary>
+	/// Runs several CPU cycles back to back, stopping early if the CPU stops
+	/// </summary>
+	/// <param name="count">Maximum number of instructions to execute</param>
+	/// <returns>Number of instructions executed (Including one that stopped the CPU)</returns>
+	uint32_t RunCycles(uint32_t count);
+
+	/// <summary>
+	/// Runs instructions for a number of COSMAC VIP machine cycles, charging each instruction what it took on the VIP's interpreter rather than
+	/// treating them all the same. Sprites cost more the more rows they have and the further they are from a byte boundary. An instruction that
+	/// overruns the cycles it was given still finishes, and the overrun is taken out of the next call.
+	/// A sprite isn't drawn until the next vertical blank, as on the VIP, so nothing runs from reaching it until the timers next tick.
+	/// Instructions aren't fused. Idle skipping still applies to jumps to self and Fx0A.
+	/// </summary>
+	/// <param name="cycles">Machine cycles to run for ('k_VipInterpreterCyclesPerFrame' for a whole frame)</param>
+	/// <returns>Number of instructions executed (Including one that stopped the CPU)</returns>
+	uint32_t RunMachineCycles(uint32_t cycles);
+
+	/// <summary>
+	/// Checks if the CPU is waiting for the next vertical blank before drawing a sprite on the COSMAC VIP timing model
+	/// </summary>
+	bool IsWaitingForVBlank() const { return m_bIsWaitingForVBlank; }
+
+	/// <summary>
+	/// Selects which interpreter's quirks are emulated. Takes effect from the next instruction and is kept when the CPU is re-initialised.
+	/// </summary>
+	/// <param name="profile">Quirk profile to emulate</param>
+	void SetQuirkProfile(QuirkProfile profile);
+
+	/// <summary>
+	/// Gets the quirk profile currently being emulated
+	/// </summary>
+	QuirkProfile GetQuirkProfile() const { return m_QuirkProfile; }
+
+	/// <summary>
+	/// Enables or disables checking memory access. When enabled, an instruction that reads or writes past the end of the interpreter's memory
+	/// (4KB, or 64KB for XO-CHIP), overflows or underflows the stack, or tests a key past the 16 on the keypad, stops the CPU with the OpCode, its address and the address out of range.
+	/// When disabled, addresses wrap around the CPU's memory instead. Takes effect from the next instruction. Instructions aren't fused while checking.
+	/// </summary>
+	/// <param name="bIsEnabled">True to check every access, false to mask addresses</param>
+	void SetMemoryChecksEnabled(bool bIsEnabled);
+
+	/// <summary>
+	/// Checks if memory access is being checked
+	/// </summary>
+	bool AreMemoryChecksEnabled() const { return m_bIsMemoryCheckEnabled; }
+
+	/// <summary>
+	/// Enables or disables skipping idle loops. When enabled, RunCycles recognises loops that can't change anything until the timers
+	/// tick or a key is pressed (A jump to itself, 'Fx07; 3xkk/4xkk; 1nnn' waiting on the delay timer and Fx0A waiting for a key),
+	/// and jumps straight to the state stepping through the rest of the batch would have ended in.
+	/// </summary>
+	/// <param name="bIsEnabled">True to skip idle loops, false to execute every instruction</param>
+	void SetIdleSkipEnabled(bool bIsEnabled);
+
+	/// <summary>
+	/// Gets the number of instructions skipped by idle loop detection since the CPU was initialised. They're still counted as executed by RunCycles.
+	/// </summary>
+	uint64_t GetIdleInstructionsSkipped() const { return m_IdleInstructionsSkipped; }
+
+	/// <summary>
+	/// Enables or disables instruction fusion. When enabled, RunCycles executes common sequences of instructions ('Annn; Dxyn', '6xkk; 6ykk',
+	/// 'Fx07; 3xkk' and '7x01; 3xkk; 1nnn') with a single handler instead of dispatching each one separately. The result is always the same as
+	/// executing them one at a time; a jump into the middle of a sequence just executes from there as normal.
+	/// </summary>
+	/// <param name="bIsEnabled">True to fuse instruction sequences, false to execute every instruction separately</param>
+	void SetFusionEnabled(bool bIsEnabled);
+
+	/// <summary>
+	/// Checks if instruction fusion is enabled
+	/// </summary>
+	bool IsFusionEnabled() const { return m_bIsFusionEnabled; }
+
+	/// <summary>
+	/// Gets the number of instructions executed as part of a fused sequence since the CPU was initialised
+	/// </summary>
+	uint64_t GetFusedInstructions() const { return m_FusedInstructions; }
+
+	/// <summary>
+	/// Discards every decoded instruction sequence. Must be called after memory is changed from outside the CPU (e.g. by a memory editor),
+	/// which also makes the next Init clear all of memory.
+	/// </summary>
+	void InvalidateDecodeCache();
+
 	/// <summary>
 	/// Sets the state of the specified key as Pressed
 	/// </summary>
@@ -95,6 +421,12 @@ public:
 	/// <param name="keycode">Key being released</param>
 	void ClearKeyState(uint8_t keycode);
 
+	/// <summary>
+	/// Sets the state of all 16 keys at once
+	/// </summary>
+	/// <param name="keyMask">Bit mask where bit N is set if key N is pressed</param>
+	void SetKeyMask(uint16_t keyMask);
+
 	/// <summary>
 	/// Sets the Delay register to the specified value.
 	/// </summary>
@@ -107,20 +439,201 @@ public:
 	/// <param name="value">The new value to set the Sound register to</param>
 	void SetSoundRegister(uint8_t value);
 
+	/// <summary>
+	/// Decrements the Delay and Sound registers by one if they're above zero. Should be called at 60Hz.
+	/// Each tick is also a vertical blank, which lets a sprite waiting on the COSMAC VIP timing model be drawn.
+	/// </summary>
+	/// <param name="ticks">Number of 60Hz ticks to apply at once (The registers stop at zero)</param>
+	void TickTimers(uint32_t ticks = 1);
+
+	/// <summary>
+	/// Checks if the next instruction is a jump to itself. Many ROMs end this way, and nothing but the timers can change afterwards.
+	/// </summary>
+	bool IsHalted() const;
+
 	/// <summary>
 	/// Gets the current state of the CPU
 	/// </summary>
 	/// <returns>Current state of the CPU</returns>
 	const ChipState* GetState() const;
 
+	/// <summary>
+	/// Gets the rows of Video RAM that have changed since this was last called, and clears them
+	/// </summary>
+	/// <returns>Bit N is set if row N has changed</returns>
+	uint64_t TakeDirtyRows();
+
+	/// <summary>
+	/// Writes a byte of memory from outside the CPU (e.g. a memory editor), discarding any decoded sequences that include it
+	/// </summary>
+	/// <param name="address">Address to write</param>
+	/// <param name="value">Value to write</param>
+	void WriteMemory(uint32_t address, uint8_t value);
+
+	/// <summary>
+	/// Writes a byte of Video RAM from outside the CPU, marking its row as changed so the display picks it up
+	/// </summary>
+	/// <param name="offset">Byte offset into 'ChipState::VideoMemory'</param>
+	/// <param name="value">Value to write</param>
+	void WriteVideoMemory(size_t offset, uint8_t value);
+
 private:
+	/// <summary>
+	/// Reports an OpCode the CPU doesn't recognise and stops execution
+	/// </summary>
+	/// <param name="opcode">The unrecognised OpCode</param>
+	void StopOnUnknownOpCode(uint16_t opcode);
+
+	/// <summary>
+	/// Calls a machine code routine on the 1802 core (0nnn). The CHIP-8 registers and display are laid out in memory where the VIP's
+	/// interpreter kept them, with the 1802's registers set up as the interpreter had them, and read back when the routine returns.
+	/// Stops the CPU if the routine doesn't return.
+	/// </summary>
+	/// <param name="opcode">The 0nnn OpCode</param>
+	void RunMachineCodeRoutine(uint16_t opcode);
+
+	/// <summary>
+	/// Selects the instruction loops for a set of quirks, with or without memory checks
+	/// </summary>
+	template<typename Quirks>
+	void SelectRunLoops();
+
+	/// <summary>
+	/// Gets a byte of memory, wrapping the address around the end of memory
+	/// </summary>
+	uint8_t& MemoryAt(uint32_t address) { return m_CpuState->Memory[address & k_AddressMask]; }
+
+	/// <summary>
+	/// Reads the instruction at the Program Counter, wrapping around the end of memory
+	/// </summary>
+	uint16_t FetchOpCode() const { return static_cast<uint16_t>(m_CpuState->Memory[m_CpuState->PC] << 8 | m_CpuState->Memory[(m_CpuState->PC + 1u) & k_AddressMask]); }
+
+	/// <summary>
+	/// Checks an instruction's access to memory is inside the interpreter's memory, stopping the CPU if it isn't. Always passes without memory checks.
+	/// </summary>
+	/// <param name="address">First address accessed</param>
+	/// <param name="length">Number of bytes accessed</param>
+	/// <param name="opcode">The instruction making the access</param>
+	/// <returns>True if the access can go ahead. Otherwise false, and the CPU has stopped</returns>
+	template<typename Quirks>
+	bool IsMemoryAccessValid(uint32_t address, uint32_t length, uint16_t opcode);
+
+	/// <summary>
+	/// Checks a call has room on the stack, or a return has something to return to, stopping the CPU if not. Always passes without memory checks.
+	/// </summary>
+	/// <param name="bIsPush">True for a call, false for a return</param>
+	/// <param name="opcode">The instruction using the stack</param>
+	/// <returns>True if the access can go ahead. Otherwise false, and the CPU has stopped</returns>
+	template<typename Quirks>
+	bool IsStackAccessValid(bool bIsPush, uint16_t opcode);
+
+	/// <summary>
+	/// Checks a key tested by Ex9E/ExA1 is on the keypad, stopping the CPU if it isn't. Always passes without memory checks, where the key is masked to 0x0-0xF instead.
+	/// </summary>
+	/// <param name="key">Key being tested</param>
+	/// <param name="opcode">The instruction testing the key</param>
+	/// <returns>True if the key can be tested. Otherwise false, and the CPU has stopped</returns>
+	template<typename Quirks>
+	bool IsKeyValid(uint8_t key, uint16_t opcode);
+
+	/// <summary>
+	/// Generates the next pseudo-random byte
+	/// </summary>
+	/// <returns>Random value between 0-255</returns>
+	uint8_t NextRandomByte();
+
+	/// <summary>
+	/// Instruction loop specialised for a quirk policy (See Quirks.h). 'm_RunCycles' points at the instantiation for the current profile.
+	/// </summary>
+	/// <param name="count">Maximum number of instructions to execute</param>
+	/// <returns>Number of instructions executed</returns>
+	template<typename Quirks>
+	uint32_t RunCyclesWith(uint32_t count);
+
+	/// <summary>
+	/// Checks if the instruction just executed has left the CPU in an idle loop, and if so skips as many whole iterations of it as fit in the rest of the batch.
+	/// Only called after jumps and Fx0A, as nothing else can close a loop. Timers and keys only change between batches, so every iteration
+	/// would be identical and skipping them leaves the CPU in exactly the state executing them would have.
+	/// </summary>
+	/// <param name="opcode">The OpCode that was just executed</param>
+	/// <param name="remaining">Number of instructions left in the batch</param>
+	/// <returns>Number of instructions skipped</returns>
+	uint32_t SkipIdleLoop(uint16_t opcode, uint32_t remaining);
+
+	/// <summary>
+	/// Works out which fused sequence, if any, starts at an address
+	/// </summary>
+	/// <param name="address">Address of the first instruction</param>
+	FusedOp DecodeFusedOp(uint16_t address) const;
+
+	/// <summary>
+	/// Executes a fused sequence starting at the current PC
+	/// </summary>
+	/// <param name="fusedOp">The sequence to execute, as decoded by DecodeFusedOp</param>
+	/// <returns>Number of instructions the sequence executed (A skip can leave out the last one)</returns>
+	template<typename Quirks>
+	uint32_t RunFusedOp(FusedOp fusedOp);
+
+	/// <summary>
+	/// Executes a single instruction
+	/// </summary>
+	template<typename Quirks>
+	void ExecuteOpCode(uint16_t opcode);
+
+	/// <summary>
+	/// Runs instructions on the COSMAC VIP timing model, specialised for a set of quirks (See 'RunMachineCycles')
+	/// </summary>
+	template<typename Quirks>
+	uint32_t RunMachineCyclesWith(uint32_t cycles);
+
+	/// <summary>
+	/// Gets roughly how many machine cycles an instruction took on the COSMAC VIP's interpreter, including fetching and decoding it.
+	/// The costs are estimated from how the interpreter's routines work rather than measured, but are close enough for ROMs to run at the
+	/// pace they were written for. Skips cost the same whether or not they're taken.
+	/// </summary>
+	/// <param name="opcode">Instruction about to be executed. Costs that depend on registers (e.g. Dxyn's position) use their current values.</param>
+	uint32_t VipInstructionCycles(uint16_t opcode) const;
+
+	/// <summary>
+	/// Records a write to memory by an instruction: resets the decoded sequences that include any of the bytes written, and extends the part of memory Init has to clear
+	/// </summary>
+	/// <param name="address">First address written</param>
+	/// <param name="length">Number of bytes written</param>
+	void OnMemoryWritten(uint32_t address, uint32_t length);
+
+	/// <summary>
+	/// Skips the next instruction. XO-CHIP's F000 NNNN is 4 bytes long, so it's skipped over whole rather than landing on its second half.
+	/// </summary>
+	template<typename Quirks>
+	void SkipNextInstruction();
+
+	/// <summary>
+	/// Moves the selected planes up or down, clearing the rows scrolled in. Each row is moved as a whole rather than pixel by pixel.
+	/// </summary>
+	/// <param name="rows">Number of rows to scroll down (Negative to scroll up), in the current resolution</param>
+	void ScrollVertical(int rows);
+
+	/// <summary>
+	/// Moves the selected planes 4 pixels left or right, clearing the pixels scrolled in at the edge. Each row is shifted as a single 128-bit value.
+	/// </summary>
+	/// <param name="bIsLeft">True to scroll left, false to scroll right</param>
+	void ScrollHorizontal(bool bIsLeft);
+
 	/// <summary>
 	/// 0x0nnn instructions:
-	///		0x0nnn = Jump to a machine code routine at address 'nnn' (Only implemented on original CHIP-8 PC's. Ignored for emulators and modern interpreters).
+	///		0x0nnn = Call the 1802 machine code routine at address 'nnn' (COSMAC VIP only, and only for routines in the program's own memory from 0x200)
 	///		0x00E0 = Clear the screen
 	///		0x00EE = Return from a subroutine
+	///		0x00Cn = Scroll the display down n rows (SCHIP)
+	///		0x00Dn = Scroll the display up n rows (XO-CHIP)
+	///		0x00FB = Scroll the display right 4 pixels (SCHIP)
+	///		0x00FC = Scroll the display left 4 pixels (SCHIP)
+	///		0x00FD = Exit the interpreter (SCHIP)
+	///		0x00FE = Switch to the 64x32 low resolution display and clear it (SCHIP)
+	///		0x00FF = Switch to the 128x64 high resolution display and clear it (SCHIP)
 	/// </summary>
 	/// <param name="opcode">The OpCode to execute</param>
+	template<typename Quirks>
 	void Op0(uint16_t opcode);
 
 	/// <summary>
@@ -134,24 +647,31 @@ private:
 	/// Stack Pointer is incremented and the Program Counter saved to the stack before calling.
 	/// </summary>
 	/// <param name="opcode">The OpCode to execute</param>
+	template<typename Quirks>
 	void Op2(uint16_t opcode);
 
 	/// <summary>
 	/// Skips the next instruction if the register Vx is equal to specified value. Encoded as 0x3xkk where 'x' is the V[x] register to compare against the value 'kk'
 	/// </summary>
 	/// <param name="opcode">The OpCode to execute</param>
+	template<typename Quirks>
 	void Op3(uint16_t opcode);
 
 	/// <summary>
 	/// Skips the next instruction if the register Vx is NOT equal to kk. Encoded as 0x4xkk where 'x' is the V[x] register to compare against the value 'kk'
 	/// </summary>
 	/// <param name="opcode">The OpCode to execute</param>
+	template<typename Quirks>
 	void Op4(uint16_t opcode);
 
 	/// <summary>
 	/// Skips the next instruction if the register Vx is equal to register Vy. Encodied as 0x5xy0 where 'X' is the V[x] register and Y is the V[y] register.
+	/// XO-CHIP adds:
+	///		0x5xy2 - Store registers V[x] through to V[y] (In either order) to memory, starting at the address stored in I. I is left unchanged.
+	///		0x5xy3 - Read registers V[x] through to V[y] (In either order) from memory, starting at the address stored in I. I is left unchanged.
 	/// </summary>
 	/// <param name="opcode">The OpCode to execute</param>
+	template<typename Quirks>
 	void Op5(uint16_t opcode);
 
 	/// <summary>
@@ -178,14 +698,17 @@ private:
 	///		6 = If the least significant byte of V[y] is 1 set V[15] to 1 (Otherwise set it to 0). Divide the value stored in V[y] by 2 and store the result in V[x] (Subtraction is done as a right bit-shift)
 	///		7 = Set V[15] to 1 if the value stored in V[y] is greater than the value stored in V[x]. Subtract V[x] from V[y] and store the result in V[x]
 	///		E = If the most significant byte of V[y] is 1 set V[15] to 1 (Otherwise set it to 0). Multiply the value stored in V[y] by 2 and store the result in V[x] (Multiply is done as a left bit-shift)
+	/// Whether 1-3 reset V[15] and whether 6 and E shift V[y] or V[x] depend on the quirk policy.
 	/// </summary>
 	/// <param name="opcode">The OpCode to execute</param>
+	template<typename Quirks>
 	void Op8(uint16_t opcode);
 
 	/// <summary>
 	/// Skip the next instruction if register Vx is NOT equal to register Vy. Encoded as 0x9xy0 where 'x' is the V[x] register and 'y' is the V[y] register.
 	/// </summary>
 	/// <param name="opcode">The OpCode to execute</param>
+	template<typename Quirks>
 	void Op9(uint16_t opcode);
 
 	/// <summary>
@@ -196,8 +719,10 @@ private:
 
 	/// <summary>
 	/// Jump to address + offset stored in V0 register. Encoded as 0xBnnn where 'nnn' is the base address to jump to.
+	/// Some interpreters read it as 0xBxnn instead, adding V[x] rather than V0 (Depends on the quirk policy).
 	/// </summary>
 	/// <param name="opcode">The OpCode to execute</param>
+	template<typename Quirks>
 	void OpB(uint16_t opcode);
 
 	/// <summary>
@@ -209,8 +734,11 @@ private:
 	/// <summary>
 	/// Draw n-byte sprite stored in memory location I to the screen and V[x] V[y]. Encoded as 0xDxyn where 'x' is the V[X] register which stores the X coordinate the sprite will be drawn to, 'y' is the V[y] register which stores the Y coordinate the sprite will
 	/// be drawn to. Finally, 'n' is the number of bytes to read from memory (The memory address read is the value currently stored in I).
+	/// The starting position wraps around the screen. Parts of the sprite past the edge are clipped or wrapped depending on the quirk policy.
+	/// On SCHIP, 0xDxy0 draws a 16x16 sprite stored as 2 bytes per row.
 	/// </summary>
 	/// <param name="opcode">The OpCode to execute</param>
+	template<typename Quirks>
 	void OpD(uint16_t opcode);
 
 	/// <summary>
@@ -220,21 +748,31 @@ private:
 	///		0xA1 - Skips if the key is NOT pressed
 	/// </summary>
 	/// <param name="opcode">The OpCode to execute</param>
+	template<typename Quirks>
 	void OpE(uint16_t opcode);
 
 	/// <summary>
 	/// Multiple sub-instructions depending on the OpCode. Encoded as '0xFxnn' where 'x' is the V[x] register and 'nn' is the action to perform.
 	/// Values for 'nn' and the operation performed are:
+	///		0x00 - (0xF000 only) Set I to the 16-bit address stored in the next word, then skip over it (XO-CHIP)
+	///		0x01 - Select the bitplanes drawn to by later instructions, where 'x' is a mask of the planes (XO-CHIP)
+	///		0x02 - (0xF002 only) Copy the 16-byte audio pattern stored at I into the audio pattern buffer (XO-CHIP)
 	///		0x07 - The value of the Delay Timer is stored into V[x]
 	///		0x0A - Wait for a key press. Store the pressed keycode into V[x]
 	///		0x15 - Set the Delay Timer to the value currently in V[x]
 	///		0x18 - Set the Sound Timer to the value currently in V[x]
 	///		0x1E - Add the value stored in V[x] to I
 	///		0x29 - Set I to the location of the sprite referenced by V[x]
+	///		0x30 - Set I to the location of the large (8x10) sprite referenced by V[x] (SCHIP)
 	///		0x33 - Store BCD representation of V[x] in memory locations I, I + 1 and I + 2
+	///		0x3A - Set the pitch the audio pattern is played back at to the value currently in V[x] (XO-CHIP)
 	///		0x55 - Store registers V[0] through to V[x] to memory, starting at the address stored in I
 	///		0x65 - Read the registers V[0] through to V[x] from memory, starting at the address stored in I
+	///		0x75 - Store registers V[0] through to V[x] in the flag registers (SCHIP)
+	///		0x85 - Read registers V[0] through to V[x] from the flag registers (SCHIP)
+	/// How far 0x55 and 0x65 move I afterwards depends on the quirk policy.
 	/// </summary>
 	/// <param name="opcode">The OpCode to execute</param>
+	template<typename Quirks>
 	void OpF(uint16_t opcode);
 };
\ No newline at end of file
@@ -0,0 +1,336 @@
+#include "Cosmac1802.h"
+
+#include <algorithm>
+
+void Cosmac1802::Reset(uint8_t* memory, const uint8_t* keyState)
+{
+	m_Memory = memory;
+	m_KeyState = keyState;
+
+	m_State = Cosmac1802State();
+
+	m_Cycles = 0;
+	m_FrameOffset = 0;
+	m_SelectedKey = 0;
+
+	ClearWrittenRange();
+}
+
+uint64_t Cosmac1802::Run(uint64_t cycles, uint8_t stopRegister)
+{
+	const uint64_t startCycles = m_Cycles;
+	const uint64_t endCycles = m_Cycles + cycles;
+
+	while (m_Cycles < endCycles && m_State.P != stopRegister)
+	{
+		const uint8_t opcode = m_Memory[m_State.R[m_State.P]++];
+
+		m_Cycles += OpCycles(opcode);
+
+		k_OpTable[opcode](*this);
+	}
+
+	return m_Cycles - startCycles;
+}
+
+void Cosmac1802::SetFramePosition(uint32_t cycle)
+{
+	const uint32_t current = static_cast<uint32_t>(m_Cycles % k_CyclesPerFrame);
+
+	m_FrameOffset = (cycle % k_CyclesPerFrame + k_CyclesPerFrame - current) % k_CyclesPerFrame;
+}
+
+void Cosmac1802::ClearWrittenRange()
+{
+	m_WrittenLow = 0xFFFF + 1;
+	m_WrittenHigh = 0;
+}
+
+void Cosmac1802::GetWrittenRange(uint16_t& start, size_t& length) const
+{
+	if (m_WrittenLow > m_WrittenHigh)
+	{
+		start = 0;
+		length = 0;
+		return;
+	}
+
+	start = static_cast<uint16_t>(m_WrittenLow);
+	length = m_WrittenHigh - m_WrittenLow + 1;
+}
+
+template<uint8_t N>
+bool Cosmac1802::Condition() const
+{
+	constexpr uint8_t test = N & 0x7;
+
+	bool bResult;
+
+	if constexpr (test == 0) bResult = true;
+	else if constexpr (test == 1) bResult = m_State.bIsQSet;
+	else if constexpr (test == 2) bResult = m_State.D == 0;
+	else if constexpr (test == 3) bResult = m_State.DF != 0;
+	else bResult = IsFlagSet(test - 4);
+
+	return (N & 0x8) != 0 ? !bResult : bResult;
+}
+
+bool Cosmac1802::IsFlagSet(int flag) const
+{
+	switch (flag)
+	{
+		// EF1 - Display status, active just before and as the display starts being drawn
+		case 0: return FramePosition() < k_DisplayFlagCycles;
+
+		// EF3 - The key selected by OUT 2 is down
+		case 2: return m_KeyState[m_SelectedKey] != 0;
+
+		// EF2 (Cassette input) and EF4 (The IN button) are never active
+		default: return false;
+	}
+}
+
+void Cosmac1802::Write(uint16_t address, uint8_t value)
+{
+	m_Memory[address] = value;
+
+	m_WrittenLow = std::min<uint32_t>(m_WrittenLow, address);
+	m_WrittenHigh = std::max<uint32_t>(m_WrittenHigh, address);
+}
+
+uint8_t Cosmac1802::Add(uint8_t a, uint8_t b, uint8_t carry)
+{
+	const uint32_t result = a + b + carry;
+
+	m_State.DF = static_cast<uint8_t>(result >> 8);
+
+	return static_cast<uint8_t>(result);
+}
+
+template<uint8_t OpCode>
+void Cosmac1802::Execute(Cosmac1802& cpu)
+{
+	constexpr uint8_t N = OpCode & 0x0F;
+
+	Cosmac1802State& state = cpu.m_State;
+	uint8_t* memory = cpu.m_Memory;
+
+	uint16_t& pc = state.R[state.P];
+	uint16_t& dataPointer = state.R[state.X];
+
+	switch (OpCode >> 4)
+	{
+		case 0x0:
+		{
+			if constexpr (N == 0)
+			{
+				// IDL - Waits for DMA or an interrupt, which the VIP's display starts at the beginning of every frame
+				cpu.m_Cycles += k_CyclesPerFrame - cpu.FramePosition();
+			}
+			else
+			{
+				// LDN - Load D from the address in R(N)
+				state.D = memory[state.R[N]];
+			}
+			break;
+		}
+
+		// INC / DEC
+		case 0x1: state.R[N]++; break;
+		case 0x2: state.R[N]--; break;
+
+		case 0x3:
+		{
+			// Short branches replace the low byte of the program counter. SKP (38) is a branch that's never taken, skipping the address byte.
+			if (cpu.Condition<N>())
+				pc = static_cast<uint16_t>((pc & 0xFF00) | memory[pc]);
+			else
+				pc++;
+			break;
+		}
+
+		// LDA - Load D and advance
+		case 0x4: state.D = memory[state.R[N]++]; break;
+
+		// STR - Store D
+		case 0x5: cpu.Write(state.R[N], state.D); break;
+
+		case 0x6:
+		{
+			if constexpr (N == 0)
+			{
+				// IRX
+				dataPointer++;
+			}
+			else if constexpr (N < 8)
+			{
+				// OUT N - Puts the byte at R(X) on the bus. OUT 2 selects the keypad key EF3 reports.
+				if constexpr (N == 2)
+					cpu.m_SelectedKey = memory[dataPointer] & 0x0F;
+
+				dataPointer++;
+			}
+			else if constexpr (N > 8)
+			{
+				// INP N - Nothing on the VIP drives the bus, so it reads as zero
+				state.D = 0;
+				cpu.Write(dataPointer, 0);
+			}
+			break;
+		}
+		case 0x7:
+		{
+			if constexpr (N == 0x0 || N == 0x1)
+			{
+				// RET / DIS - Restore X and P from memory, enabling or disabling interrupts
+				const uint8_t value = memory[dataPointer++];
+
+				state.X = value >> 4;
+				state.P = value & 0x0F;
+				state.bIsInterruptEnabled = N == 0x0;
+			}
+			else if constexpr (N == 0x2)
+			{
+				// LDXA
+				state.D = memory[dataPointer++];
+			}
+			else if constexpr (N == 0x3)
+			{
+				// STXD
+				cpu.Write(dataPointer--, state.D);
+			}
+			else if constexpr (N == 0x4) state.D = cpu.Add(memory[dataPointer], state.D, state.DF);									// ADC
+			else if constexpr (N == 0x5) state.D = cpu.Add(memory[dataPointer], static_cast<uint8_t>(~state.D), state.DF);			// SDB
+			else if constexpr (N == 0x6 || N == 0xE)
+			{
+				// SHRC / SHLC - Rotate through DF
+				const uint8_t carry = state.DF;
+
+				if constexpr (N == 0x6)
+				{
+					state.DF = state.D & 0x01;
+					state.D = static_cast<uint8_t>((state.D >> 1) | (carry << 7));
+				}
+				else
+				{
+					state.DF = state.D >> 7;
+					state.D = static_cast<uint8_t>((state.D << 1) | carry);
+				}
+			}
+			else if constexpr (N == 0x7) state.D = cpu.Add(state.D, static_cast<uint8_t>(~memory[dataPointer]), state.DF);			// SMB
+			else if constexpr (N == 0x8)
+			{
+				// SAV
+				cpu.Write(dataPointer, state.T);
+			}
+			else if constexpr (N == 0x9)
+			{
+				// MARK - Save X and P to T and the stack at R2, then make X the program counter's register
+				state.T = static_cast<uint8_t>(state.X << 4 | state.P);
+
+				cpu.Write(state.R[2]--, state.T);
+
+				state.X = state.P;
+			}
+			else if constexpr (N == 0xA) state.bIsQSet = false;																	// REQ
+			else if constexpr (N == 0xB) state.bIsQSet = true;																	// SEQ
+			else if constexpr (N == 0xC)
+			{
+				// ADCI
+				const uint8_t value = memory[pc++];
+				state.D = cpu.Add(value, state.D, state.DF);
+			}
+			else if constexpr (N == 0xD)
+			{
+				// SDBI
+				const uint8_t value = memory[pc++];
+				state.D = cpu.Add(value, static_cast<uint8_t>(~state.D), state.DF);
+			}
+			else if constexpr (N == 0xF)
+			{
+				// SMBI
+				const uint8_t value = memory[pc++];
+				state.D = cpu.Add(state.D, static_cast<uint8_t>(~value), state.DF);
+			}
+			break;
+		}
+
+		// GLO / GHI / PLO / PHI
+		case 0x8: state.D = static_cast<uint8_t>(state.R[N]); break;
+		case 0x9: state.D = static_cast<uint8_t>(state.R[N] >> 8); break;
+		case 0xA: state.R[N] = static_cast<uint16_t>((state.R[N] & 0xFF00) | state.D); break;
+		case 0xB: state.R[N] = static_cast<uint16_t>((state.R[N] & 0x00FF) | state.D << 8); break;
+
+		case 0xC:
+		{
+			// Long branches (C0-C3, C9-CB) jump to the next two bytes. Long skips (C5-C8, CC-CF) skip over them. C4 is a three cycle NOP.
+			if constexpr (N == 0x4)
+			{
+			}
+			else if constexpr (N < 0x4 || (N >= 0x9 && N <= 0xB))
+			{
+				if (cpu.Condition<N>())
+					pc = static_cast<uint16_t>(memory[pc] << 8 | memory[static_cast<uint16_t>(pc + 1)]);
+				else
+					pc += 2;
+			}
+			else
+			{
+				// The skip conditions don't follow the branches' pattern
+				bool bIsSkipped;
+
+				if constexpr (N == 0x5) bIsSkipped = !state.bIsQSet;				// LSNQ
+				else if constexpr (N == 0x6) bIsSkipped = state.D != 0;			// LSNZ
+				else if constexpr (N == 0x7) bIsSkipped = state.DF == 0;			// LSNF
+				else if constexpr (N == 0x8) bIsSkipped = true;					// LSKP
+				else if constexpr (N == 0xC) bIsSkipped = state.bIsInterruptEnabled;	// LSIE
+				else if constexpr (N == 0xD) bIsSkipped = state.bIsQSet;			// LSQ
+				else if constexpr (N == 0xE) bIsSkipped = state.D == 0;			// LSZ
+				else bIsSkipped = state.DF != 0;									// LSDF
+
+				if (bIsSkipped)
+					pc += 2;
+			}
+			break;
+		}
+
+		// SEP / SEX
+		case 0xD: state.P = N; break;
+		case 0xE: state.X = N; break;
+
+		case 0xF:
+		{
+			// The low half operates on the byte at R(X), the high half (Apart from SHL) on an immediate byte following the instruction
+			if constexpr (N == 0x6)
+			{
+				// SHR
+				state.DF = state.D & 0x01;
+				state.D >>= 1;
+			}
+			else if constexpr (N == 0xE)
+			{
+				// SHL
+				state.DF = state.D >> 7;
+				state.D = static_cast<uint8_t>(state.D << 1);
+			}
+			else
+			{
+				const uint8_t value = N < 0x8 ? memory[dataPointer] : memory[pc++];
+
+				switch (N & 0x7)
+				{
+					case 0x0: state.D = value; break;													// LDX / LDI
+					case 0x1: state.D |= value; break;													// OR / ORI
+					case 0x2: state.D &= value; break;													// AND / ANI
+					case 0x3: state.D ^= value; break;													// XOR / XRI
+					case 0x4: state.D = cpu.Add(value, state.D, 0); break;								// ADD / ADI
+					case 0x5: state.D = cpu.Add(value, static_cast<uint8_t>(~state.D), 1); break;		// SD / SDI
+					case 0x7: state.D = cpu.Add(state.D, static_cast<uint8_t>(~value), 1); break;		// SM / SMI
+				}
+			}
+			break;
+		}
+	}
+}
+
+const std::array<Cosmac1802::OpHandler, 256> Cosmac1802::k_OpTable = Cosmac1802::MakeOpTable(std::make_index_sequence<256>());
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "EmulatorCommon.h"
+
+#include <array>
+#include <utility>
+
+/**
+ * Represents the internal state of the RCA 1802 (Registers and flags)
+ */
+struct Cosmac1802State
+{
+	// 16 16-bit scratchpad registers. Any of them can be the program counter (Selected by P) or the data pointer (Selected by X).
+	uint16_t R[16] = { 0 };
+
+	// Accumulator
+	uint8_t D = 0;
+
+	// Carry/borrow flag (0 or 1)
+	uint8_t DF = 0;
+
+	// Number of the register used as the program counter
+	uint8_t P = 0;
+
+	// Number of the register used as the data pointer
+	uint8_t X = 0;
+
+	// Holds X and P while an interrupt is serviced (Or after MARK)
+	uint8_t T = 0;
+
+	// Interrupt enable
+	bool bIsInterruptEnabled = true;
+
+	// Q output. Drives the beeper on the COSMAC VIP.
+	bool bIsQSet = false;
+};
+
+/*
+* RCA 1802 (COSMAC) CPU, wired up like the one in the COSMAC VIP.
+*
+* Used to run the machine code routines hybrid CHIP-8 ROMs call with 0nnn. It addresses the CHIP-8 memory directly, so routines see
+* (And can change) everything the CHIP-8 program can.
+*
+* Each of the 256 OpCodes has its own handler, specialised on the OpCode at compile time and dispatched through a table, so running an
+* instruction is one indexed call with the register numbers and conditions already baked in.
+*
+* Only the parts of the VIP that routines normally touch are emulated: the keypad (Selected with OUT 2 and read through EF3) and the
+* display status on EF1. There's no display DMA or interrupts, so IDL just waits for the start of the next frame. Where the frame starts is
+* only as accurate as the position passed to 'SetFramePosition' before each run.
+*/
+class Cosmac1802
+{
+public:
+	// Machine cycles in each 60Hz frame on the COSMAC VIP (A 1.7609MHz clock, with 8 clocks per machine cycle)
+	static constexpr uint32_t k_CyclesPerFrame = 3668;
+
+	// Passed to 'Run' to keep running until the cycles run out
+	static constexpr uint8_t k_NoStopRegister = 0xFF;
+
+public:
+	/// <summary>
+	/// Maps the memory and keypad into the CPU's address space and resets its registers. Must be called before running anything.
+	/// </summary>
+	/// <param name="memory">64KB of memory for the CPU to address</param>
+	/// <param name="keyState">16 key states (0 = Up | 1 = Down) for the VIP's hex keypad</param>
+	void Reset(uint8_t* memory, const uint8_t* keyState);
+
+	/// <summary>
+	/// Runs instructions until the cycles run out, or a SEP switches the program counter to 'stopRegister'
+	/// </summary>
+	/// <param name="cycles">Most machine cycles to run for. The last instruction can go over by a cycle.</param>
+	/// <param name="stopRegister">Register that stops execution once it becomes the program counter (e.g. 4 for a routine returning to the CHIP-8 interpreter)</param>
+	/// <returns>Number of machine cycles run</returns>
+	uint64_t Run(uint64_t cycles, uint8_t stopRegister = k_NoStopRegister);
+
+	/// <summary>
+	/// Lines the CPU up with the emulated display, so EF1 and IDL see the right point in the frame
+	/// </summary>
+	/// <param name="cycle">Machine cycles since the current frame started (From 0 to 'k_CyclesPerFrame' - 1)</param>
+	void SetFramePosition(uint32_t cycle);
+
+	/// <summary>
+	/// Gets the current state of the CPU
+	/// </summary>
+	Cosmac1802State* GetState() { return &m_State; }
+
+	/// <summary>
+	/// Forgets the range of memory written so far
+	/// </summary>
+	void ClearWrittenRange();
+
+	/// <summary>
+	/// Gets the range of memory written since 'ClearWrittenRange', so anything caching memory knows what's changed
+	/// </summary>
+	/// <param name="start">Receives the lowest address written</param>
+	/// <param name="length">Receives the number of bytes from 'start' to the highest address written. Zero if nothing was written.</param>
+	void GetWrittenRange(uint16_t& start, size_t& length) const;
+
+private:
+	using OpHandler = void (*)(Cosmac1802& cpu);
+
+	/// <summary>
+	/// Executes one instruction. Every OpCode gets its own copy, with the register number and any condition worked out at compile time.
+	/// </summary>
+	template<uint8_t OpCode>
+	static void Execute(Cosmac1802& cpu);
+
+	/// <summary>
+	/// Builds the table of handlers, one per OpCode
+	/// </summary>
+	template<size_t... OpCodes>
+	static constexpr std::array<OpHandler, 256> MakeOpTable(std::index_sequence<OpCodes...>) { return { &Execute<static_cast<uint8_t>(OpCodes)>... }; }
+
+	/// <summary>
+	/// Checks the condition tested by a short (3N) or long (CN) branch or skip. Conditions 8-F are the inverse of 0-7.
+	/// </summary>
+	template<uint8_t N>
+	bool Condition() const;
+
+	/// <summary>
+	/// Checks an external flag input (0 - 3 for EF1 - EF4)
+	/// </summary>
+	bool IsFlagSet(int flag) const;
+
+	/// <summary>
+	/// Writes a byte to memory, keeping track of the range written
+	/// </summary>
+	void Write(uint16_t address, uint8_t value);
+
+	/// <summary>
+	/// Adds two bytes and a carry, setting DF to the carry out. Subtraction adds the complement with a carry of 1 (No borrow).
+	/// </summary>
+	uint8_t Add(uint8_t a, uint8_t b, uint8_t carry);
+
+	/// <summary>
+	/// Gets the number of machine cycles since the current frame started
+	/// </summary>
+	uint32_t FramePosition() const { return static_cast<uint32_t>((m_Cycles + m_FrameOffset) % k_CyclesPerFrame); }
+
+	// Handler for each OpCode
+	static const std::array<OpHandler, 256> k_OpTable;
+
+	// Machine cycles each OpCode takes: 2, or 3 for the long branches and skips (CN)
+	static constexpr uint8_t OpCycles(uint8_t opcode) { return (opcode & 0xF0) == 0xC0 ? 3 : 2; }
+
+	// Machine cycles EF1 is active for at the start of each frame (The 8 scanlines around the start of the display's DMA, 14 cycles each)
+	static constexpr uint32_t k_DisplayFlagCycles = 8 * 14;
+
+private:
+	Cosmac1802State m_State;
+
+	uint8_t* m_Memory = nullptr;
+	const uint8_t* m_KeyState = nullptr;
+
+	// Machine cycles run since the CPU was reset
+	uint64_t m_Cycles = 0;
+
+	// Added to 'm_Cycles' to give the position in the current frame for EF1 and IDL (See 'SetFramePosition')
+	uint32_t m_FrameOffset = 0;
+
+	// Key selected by the last OUT 2, which EF3 reports the state of
+	uint8_t m_SelectedKey = 0;
+
+	// Lowest and highest addresses written since 'ClearWrittenRange'. Low is above high when nothing has been written.
+	uint32_t m_WrittenLow = 0xFFFF + 1;
+	uint32_t m_WrittenHigh = 0;
+};
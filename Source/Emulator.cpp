@@ -3,13 +3,28 @@
 bool Emulator::Initialise()
 {
 	m_GameTimer = new GameTimer();
+	m_FramePacer = new FramePacer(1.0 / k_FrameRate);
+	m_PerfMonitor = new PerformanceMonitor();
+	m_InputQueue = new InputQueue();
+	m_LatencyProbe = new LatencyProbe();
 
 	if (!InitSDL())
 		return false;
 	
 	InitCpu();
+	InitAudio();
 	InitImGui();
 
+	m_RomLibrary = new RomLibrary();
+
+	// Pick up the library from the last session. Only ROMs that have changed since then are re-read, so this is quick even for large collections.
+	if (m_RomLibrary->LoadIndex(k_RomLibraryIndexPath) && !m_RomLibrary->RootPath().empty())
+	{
+		ScanRomLibrary(m_RomLibrary->RootPath());
+	}
+
+	UpdateRomLibraryFilter();
+
 	return true;
 }
 
@@ -29,40 +44,124 @@ bool Emulator::InitSDL()
 		return false;
 	}
 
-	m_Renderer = SDL_CreateRenderer(m_GameWindow, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+	// VSync isn't requested as the frame rate is controlled by the frame pacer. Pacing on VSync would tie emulation speed to the monitor's refresh rate.
+	m_Renderer = SDL_CreateRenderer(m_GameWindow, -1, SDL_RENDERER_ACCELERATED);
 	//SDL_RenderSetLogicalSize(m_Renderer, k_WindowWidth, k_WindowHeight);
 
+	// Hosts without a GPU (e.g. remote desktops and VMs) can only provide a software renderer
+	if (m_Renderer == nullptr)
+	{
+		std::cout << "WARNING: No accelerated renderer available, falling back to software rendering: " << SDL_GetError() << std::endl;
+
+		m_Renderer = SDL_CreateRenderer(m_GameWindow, -1, SDL_RENDERER_SOFTWARE);
+	}
+
 	if (m_Renderer == nullptr)
 	{
 		std::cout << "ERROR: Failed to initialise renderer: " << SDL_GetError() << std::endl;
 		return false;
 	}
 
+	SDL_RendererInfo rendererInfo;
+
+	if (SDL_GetRendererInfo(m_Renderer, &rendererInfo) == 0)
+	{
+		m_bUseSoftwareUiRenderer = (rendererInfo.flags & SDL_RENDERER_SOFTWARE) != 0;
+	}
+
+	SDL_DisplayMode displayMode;
+
+	if (SDL_GetWindowDisplayMode(m_GameWindow, &displayMode) == 0 && displayMode.refresh_rate > 0)
+	{
+		m_DisplayRefreshRate = displayMode.refresh_rate;
+	}
+
 	SDL_SetRenderDrawColor(m_Renderer, 100, 149, 237, 255);
 
-	m_RenderTexture = SDL_CreateTexture(m_Renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, 64, 32);
+	m_RenderTexture = SDL_CreateTexture(m_Renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, ChipState::k_DisplayWidth, ChipState::k_DisplayHeight);
 
 	if (m_RenderTexture == nullptr)
 	{
 		std::cout << "ERROR: Failed to create render texture: " << SDL_GetError() << std::endl;
 		return false;
 	}
+
+	return true;
 }
 
 void Emulator::InitCpu()
 {
 	m_Cpu = new CPU();
+	s_EditedCpu = m_Cpu;
 	m_Cpu->Init();
 }
 
+bool Emulator::InitAudio()
+{
+	if (m_AudioDevice != 0)
+	{
+		// Waits for the audio thread to finish with the beeper, so it can be replaced
+		SDL_CloseAudioDevice(m_AudioDevice);
+		m_AudioDevice = 0;
+	}
+
+	delete m_Beeper;
+	m_Beeper = nullptr;
+
+	SDL_AudioSpec desiredSpec = {};
+	desiredSpec.freq = Beeper::k_DefaultSampleRate;
+	desiredSpec.format = AUDIO_S16SYS;
+	desiredSpec.channels = 1;
+	desiredSpec.samples = static_cast<Uint16>(m_AudioBufferSamples);
+	desiredSpec.callback = &Emulator::AudioCallback;
+	desiredSpec.userdata = this;
+
+	SDL_AudioSpec obtainedSpec = {};
+
+	// The beeper renders at whatever rate the device prefers rather than SDL resampling it, which would add latency
+	m_AudioDevice = SDL_OpenAudioDevice(NULL, 0, &desiredSpec, &obtainedSpec, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE);
+
+	if (m_AudioDevice == 0)
+	{
+		std::cout << "WARNING: Failed to open audio device, sound is disabled: " << SDL_GetError() << std::endl;
+		return false;
+	}
+
+	// Devices start paused, so the callback can't run until the beeper exists
+	m_Beeper = new Beeper(obtainedSpec.freq, obtainedSpec.samples);
+
+	SDL_PauseAudioDevice(m_AudioDevice, m_bIsSoundEnabled ? 0 : 1);
+
+	return true;
+}
+
+void SDLCALL Emulator::AudioCallback(void* userData, Uint8* stream, int length)
+{
+	Emulator* emulator = static_cast<Emulator*>(userData);
+
+	emulator->m_Beeper->Render(reinterpret_cast<int16_t*>(stream), length / sizeof(int16_t));
+}
+
 void Emulator::InitImGui()
 {
 	m_ImGuiContext = new ImGuiImpl();
 	m_ImGuiContext->Init(m_Renderer, k_WindowWidth, k_WindowHeight);
 
 	m_VRamWindow = new MemoryEditor();
+	m_VRamWindow->WriteFn = &Emulator::WriteVideoMemory;
 	m_StackMemoryWindow = new MemoryEditor();
 	m_SystemMemoryWindow = new MemoryEditor();
+	m_SystemMemoryWindow->WriteFn = &Emulator::WriteSystemMemory;
+}
+
+void Emulator::WriteSystemMemory(ImU8* data, size_t offset, ImU8 value)
+{
+	s_EditedCpu->WriteMemory(static_cast<uint32_t>(offset), value);
+}
+
+void Emulator::WriteVideoMemory(ImU8* data, size_t offset, ImU8 value)
+{
+	s_EditedCpu->WriteVideoMemory(offset, value);
 }
 
 void Emulator::Run()
@@ -70,32 +169,203 @@ void Emulator::Run()
 	m_bIsRunning = true;
 
 	m_GameTimer->Reset();
+	m_FramePacer->Reset();
+
+	m_InputWindowStart = Profiler::Now();
+
+	Profiler::SetThreadName("Main");
 
 	while (m_bIsRunning)
 	{
+		// While there's nothing to emulate, sleep until something happens rather than redrawing frames that haven't changed
+		if (IsIdle() && m_IdleRedrawFrames == 0)
+		{
+			if (!WaitForEvents())
+				continue;
+		}
+
+		PROFILE_SCOPE("Frame");
+
 		m_GameTimer->Tick();
 
+		// Events are handled before emulating so key presses reach the CPU in the frame they were polled in
+		bool bHandledEvents = HandleEvents();
+
+		m_InputWindowEnd = Profiler::Now();
+
 		if (m_bIsProgramLoaded && !m_bIsPaused)
 		{
-			m_Cpu->RunCycle();
-
 			if (m_bExecuteSingleInstruction)
 			{
+				FlushInput();
+
+				{
+					PROFILE_SCOPE("CPU::RunCycle");
+					m_Cpu->RunCycle();
+				}
+
+				m_PerfMonitor->AddInstructions(1);
+
 				m_bIsPaused = true;
 				m_bExecuteSingleInstruction = false;
 			}
+			else if (m_bIsFastForwarding)
+			{
+				RunFastForward();
+			}
+			else
+			{
+				RunFrame();
+			}
+		}
+		else
+		{
+			// Keep the keypad up to date while nothing is running, so it's correct when execution resumes
+			FlushInput();
+		}
+
+		m_InputWindowStart = m_InputWindowEnd;
+
+		if (bHandledEvents || !IsIdle() || ImGui::IsAnyItemActive())
+		{
+			m_IdleRedrawFrames = k_IdleRedrawFrameCount;
+		}
+		else if (m_IdleRedrawFrames > 0)
+		{
+			m_IdleRedrawFrames--;
 		}
 
-		HandleEvents();
 		Update();
 
-		Clear();
+		BeginFrame();
 		Draw();
 		Present();
+
+		// Fast-forwarding already spends a whole display refresh interval emulating, so there's nothing to wait for
+		if (!m_bIsFastForwarding || IsIdle())
+		{
+			PROFILE_SCOPE("FramePacer::Wait");
+			m_FramePacer->WaitForNextFrame();
+		}
+
+		m_PerfMonitor->EndFrame(m_GameTimer->DeltaTime());
+	}
+}
+
+void Emulator::RunFrame()
+{
+	uint32_t executed = m_InstructionsPerFrame;
+
+	{
+		PROFILE_SCOPE("CPU::RunCycle");
+
+		const int64_t inputWindowLength = m_InputWindowEnd - m_InputWindowStart;
+
+		if (m_bIsVipTimingEnabled)
+		{
+			executed = RunTimedFrame(inputWindowLength);
+		}
+		else if (m_InputQueue->IsEmpty() && !m_LatencyProbe->IsEnabled())
+		{
+			// Nothing needs to happen part-way through the frame, so it can run as one batch (Which lets the CPU skip idle loops)
+			m_Cpu->RunCycles(m_InstructionsPerFrame);
+		}
+		else
+		{
+			uint32_t videoMemoryVersion = m_Cpu->GetState()->VideoMemoryVersion;
+
+			for (uint32_t i = 0; i < m_InstructionsPerFrame; i++)
+			{
+				// Each instruction stands in for an equal slice of the real time since the previous frame
+				DeliverInput(m_InputWindowStart + (inputWindowLength * i) / m_InstructionsPerFrame);
+
+				m_Cpu->RunCycle();
+
+				if (m_Cpu->GetState()->VideoMemoryVersion != videoMemoryVersion)
+				{
+					videoMemoryVersion = m_Cpu->GetState()->VideoMemoryVersion;
+
+					if (m_LatencyProbe->IsEnabled())
+						m_LatencyProbe->OnVideoMemoryChanged(Profiler::Now());
+				}
+			}
+		}
+	}
+
+	// Any further frames emulated before the next poll (i.e. while fast-forwarding) have no new input to deliver
+	m_InputWindowStart = m_InputWindowEnd;
+
+	m_PerfMonitor->AddInstructions(executed);
+	m_PerfMonitor->AddEmulatedFrame();
+
+	// The tone for this frame is decided by the Sound register before it ticks. Fast-forwarding would only flood the queue, so it's silent.
+	if (m_Beeper != nullptr && m_bIsSoundEnabled && !m_bIsFastForwarding)
+		m_Beeper->QueueFrame(m_Cpu->GetState());
+
+	UpdateTimers();
+}
+
+uint32_t Emulator::RunTimedFrame(int64_t inputWindowLength)
+{
+	if (m_InputQueue->IsEmpty() && !m_LatencyProbe->IsEnabled())
+		return m_Cpu->RunMachineCycles(CPU::k_VipInterpreterCyclesPerFrame);
+
+	uint32_t executed = 0;
+	uint32_t videoMemoryVersion = m_Cpu->GetState()->VideoMemoryVersion;
+
+	for (uint32_t i = 0; i < k_TimedInputSlices; i++)
+	{
+		// Slices of the frame's cycles stand in for equal slices of the real time since the previous frame
+		DeliverInput(m_InputWindowStart + (inputWindowLength * i) / k_TimedInputSlices);
+
+		const uint32_t sliceStart = (CPU::k_VipInterpreterCyclesPerFrame * i) / k_TimedInputSlices;
+		const uint32_t sliceEnd = (CPU::k_VipInterpreterCyclesPerFrame * (i + 1)) / k_TimedInputSlices;
+
+		executed += m_Cpu->RunMachineCycles(sliceEnd - sliceStart);
+
+		if (m_Cpu->GetState()->VideoMemoryVersion != videoMemoryVersion)
+		{
+			videoMemoryVersion = m_Cpu->GetState()->VideoMemoryVersion;
+
+			if (m_LatencyProbe->IsEnabled())
+				m_LatencyProbe->OnVideoMemoryChanged(Profiler::Now());
+		}
 	}
+
+	return executed;
+}
+
+void Emulator::RunFastForward()
+{
+	PROFILE_SCOPE("RunFastForward");
+
+	// Emulate as many frames as fit into one display refresh, so the screen is redrawn at most once per refresh
+	int64_t sliceEndTime = Profiler::Now() + static_cast<int64_t>(1e9 / m_DisplayRefreshRate);
+
+	do
+	{
+		RunFrame();
+	}
+	while (Profiler::Now() < sliceEndTime && !m_Cpu->GetState()->bIsStopped);
+}
+
+bool Emulator::LoadRom(const RomLibrary::RomEntry& rom)
+{
+	// The probe's measurements only make sense for the probe ROM
+	m_LatencyProbe->SetEnabled(false);
+
+	m_Cpu->Init();
+	m_Cpu->SetQuirkProfile(RomLibrary::DefaultQuirkProfile(rom.Platform));
+
+	m_bIsProgramLoaded = m_Cpu->LoadProgram(rom.Path.c_str());
+	m_bIsPaused = true;
+
+	m_InstructionsPerFrame = rom.InstructionsPerFrame;
+
+	return m_bIsProgramLoaded;
 }
 
-bool Emulator::LoadRom()
+bool Emulator::BrowseForRomFolder()
 {
 	bool success = false;
 
@@ -105,8 +375,14 @@ bool Emulator::LoadRom()
 	{
 		if (SUCCEEDED(CoCreateInstance(CLSID_FileOpenDialog, NULL, CLSCTX_ALL, IID_IFileOpenDialog, reinterpret_cast<void**>(&fileOpenDialog))))
 		{
-			fileOpenDialog->SetFileTypes(3, k_FileFilterSpec);
-			fileOpenDialog->SetTitle(L"Open ROM");
+			FILEOPENDIALOGOPTIONS options;
+
+			if (SUCCEEDED(fileOpenDialog->GetOptions(&options)))
+			{
+				fileOpenDialog->SetOptions(options | FOS_PICKFOLDERS);
+			}
+
+			fileOpenDialog->SetTitle(L"Choose ROM Folder");
 
 			// Get the window handle from SDL. Need to obtain the SDL_Version first as for some reason it's required :|
 			SDL_SysWMinfo windowInfo;
@@ -121,12 +397,12 @@ bool Emulator::LoadRom()
 
 				if (SUCCEEDED(fileOpenDialog->GetResult(&item)))
 				{
-					PWSTR filePath;
+					PWSTR folderPath;
 
-					if (SUCCEEDED(item->GetDisplayName(SIGDN_FILESYSPATH, &filePath)))
+					if (SUCCEEDED(item->GetDisplayName(SIGDN_FILESYSPATH, &folderPath)))
 					{
-						success = m_Cpu->LoadProgram(filePath);
-						m_bIsProgramLoaded = success;
+						success = ScanRomLibrary(folderPath);
+						CoTaskMemFree(folderPath);
 					}
 					item->Release();
 				}
@@ -138,12 +414,53 @@ bool Emulator::LoadRom()
 	return success;
 }
 
-void Emulator::HandleEvents()
+bool Emulator::ScanRomLibrary(const std::filesystem::path& folderPath)
+{
+	PROFILE_SCOPE("RomLibrary::Scan");
+
+	if (!m_RomLibrary->Scan(folderPath))
+		return false;
+
+	m_RomLibrary->SaveIndex(k_RomLibraryIndexPath);
+
+	UpdateRomLibraryFilter();
+
+	return true;
+}
+
+void Emulator::UpdateRomLibraryFilter()
 {
+	const std::vector<RomLibrary::RomEntry>& roms = m_RomLibrary->Entries();
+
+	m_FilteredRoms.clear();
+
+	for (size_t i = 0; i < roms.size(); i++)
+	{
+		if (m_RomLibraryFilter.PassFilter(roms[i].Name.c_str()))
+		{
+			m_FilteredRoms.push_back(i);
+		}
+	}
+}
+
+bool Emulator::HandleEvents()
+{
+	PROFILE_SCOPE("HandleEvents");
+
+	bool bHandledEvents = false;
+
+	// SDL timestamps events in milliseconds since it was initialised. They're converted to the profiler clock to compare them with frame times.
+	const int64_t pollTime = Profiler::Now();
+	const Uint32 pollTicks = SDL_GetTicks();
+
 	SDL_Event sdlEvent;
 
 	while (SDL_PollEvent(&sdlEvent))
 	{
+		bHandledEvents = true;
+
+		m_ImGuiContext->HandleEvent(&sdlEvent);
+
 		switch (sdlEvent.type)
 		{
 			case SDL_QUIT:
@@ -151,99 +468,275 @@ void Emulator::HandleEvents()
 				Stop();
 				break;
 			}
+			case SDL_WINDOWEVENT:
+			{
+				// The window contents may have been lost (e.g. it was uncovered, resized or restored), so the next frame has to be drawn
+				m_bForceRedraw = true;
+				break;
+			}
+			case SDL_KEYDOWN:
+			case SDL_KEYUP:
+			{
+				if (sdlEvent.key.repeat != 0)
+					break;
+
+				bool bIsPressed = sdlEvent.type == SDL_KEYDOWN;
+
+				if (bIsPressed && sdlEvent.key.keysym.scancode == k_FastForwardKey)
+				{
+					ToggleFastForward();
+				}
+
+				// Pumping the queue can add events stamped after 'pollTicks'. The signed difference keeps them from wrapping to ~49 days ago,
+				// and they're clamped to the poll time rather than ending up in the future.
+				const int32_t ticksAgo = static_cast<int32_t>(pollTicks - sdlEvent.key.timestamp);
+				const int64_t timestamp = pollTime - static_cast<int64_t>(ticksAgo > 0 ? ticksAgo : 0) * 1000000;
+
+				for (uint8_t key = 0; key < 16; key++)
+				{
+					if (k_KeyCodes[key] != sdlEvent.key.keysym.scancode)
+						continue;
+
+					m_LatencyProbe->OnKeyEvent(key, bIsPressed, timestamp);
+
+					if (bIsPressed)
+					{
+						m_InputQueue->PressKey(key, timestamp);
+					}
+					else
+					{
+						m_InputQueue->ReleaseKey(key, timestamp);
+					}
+				}
+				break;
+			}
 		}
 	}
 
-	m_ImGuiContext->HandleEvent(&sdlEvent);
+	return bHandledEvents;
 }
 
-void Emulator::Update()
+bool Emulator::WaitForEvents()
 {
-	m_ImGuiContext->Update(m_GameTimer->DeltaTime());
+	PROFILE_SCOPE("WaitForEvents");
+
+	// Stop the game timer so the time spent blocked isn't reported as one very long frame
+	m_GameTimer->Stop();
 
-	m_KeyStates = const_cast<Uint8*>(SDL_GetKeyboardState(0));
+	// Passing a null event leaves the event in the queue for 'HandleEvents()' to process
+	bool bHasEvent = SDL_WaitEventTimeout(nullptr, k_IdleWaitTimeoutMs) != 0;
 
-	for (Uint8 i = 0; i < 16; i++)
+	m_GameTimer->Start();
+
+	if (bHasEvent)
 	{
-		if (m_KeyStates[k_KeyCodes[i]] == 1)
-		{
-			m_Cpu->SetKeyState(i);
-		}
-		else
-		{
-			m_Cpu->ClearKeyState(i);
-		}
+		// The previous frame deadline is long gone, start pacing from now
+		m_FramePacer->Reset();
 	}
 
-	UpdateTimers();
+	return bHasEvent;
 }
 
-void Emulator::Clear()
+void Emulator::ToggleFastForward()
 {
-	SDL_RenderClear(m_Renderer);
+	m_bIsFastForwarding = !m_bIsFastForwarding;
 
-	ImGui::NewFrame();
+	// Resume normal pacing from now rather than from a deadline that passed while fast-forwarding
+	m_FramePacer->Reset();
 }
 
-void Emulator::Draw()
+void Emulator::ToggleLatencyProbe()
 {
-	for (int i = 0; i < 2048; i++)
+	if (m_LatencyProbe->IsEnabled())
 	{
-		uint8_t pixel = m_Cpu->GetState()->VideoMemory[i];
+		m_LatencyProbe->SetEnabled(false);
+		return;
+	}
+
+	m_Cpu->Init();
+
+	m_bIsProgramLoaded = m_Cpu->LoadProgram(LatencyProbe::k_ProbeRom, LatencyProbe::k_ProbeRomSize);
+	m_InstructionsPerFrame = k_InstructionsPerFrame;
+
+	if (!m_bIsProgramLoaded)
+		return;
+
+	m_bIsPaused = false;
+	m_bShowPerformanceView = true;
+
+	m_LatencyProbe->SetEnabled(true);
+}
+
+bool Emulator::IsIdle() const
+{
+	return !m_bIsProgramLoaded || m_bIsPaused;
+}
 
-		m_PixelBuffer[i] = (0x00FFFFFF * pixel) | 0xFF000000;
+void Emulator::Update()
+{
+	PROFILE_SCOPE("Update");
+
+	m_ImGuiContext->Update(m_GameTimer->DeltaTime());
+}
+
+void Emulator::DeliverInput(int64_t time)
+{
+	bool bIsNewPress = false;
+	bool bHasChanged = false;
+
+	while (m_InputQueue->PopTransition(time, m_DeliveredKeyMask, bIsNewPress))
+	{
+		bHasChanged = true;
 	}
 
-	SDL_UpdateTexture(m_RenderTexture, NULL, m_PixelBuffer, 64 * sizeof(uint32_t));
-	SDL_RenderCopy(m_Renderer, m_RenderTexture, NULL, NULL);
+	if (bHasChanged)
+	{
+		m_Cpu->SetKeyMask(m_DeliveredKeyMask);
+	}
+}
+
+void Emulator::FlushInput()
+{
+	m_InputQueue->Clear();
+
+	m_DeliveredKeyMask = m_InputQueue->KeyMask();
+	m_Cpu->SetKeyMask(m_DeliveredKeyMask);
+}
+
+void Emulator::BeginFrame()
+{
+	PROFILE_SCOPE("BeginFrame");
+
+	ImGui::NewFrame();
+}
+
+void Emulator::Draw()
+{
+	PROFILE_SCOPE("Draw");
 
 	DrawMainMenu();
 
 	if (m_bShowDebugOverlay)
 		DrawDebugOverlay();
 
+	if (m_bShowPerformanceView)
+		DrawPerformanceWindow();
+
+	if (m_bShowRomLibrary)
+		DrawRomLibraryWindow();
+
 	if (m_bShowVRamView)
-		m_VRamWindow->DrawWindow("VRAM View", (void *)&m_Cpu->GetState()->VideoMemory, 2048);
+		m_VRamWindow->DrawWindow("VRAM View", (void *)&m_Cpu->GetState()->VideoMemory, sizeof(ChipState::VideoMemory));
 
 	if (m_bShowSystemMemoryView)
-		m_SystemMemoryWindow->DrawWindow("System Memory", (void*)&m_Cpu->GetState()->Memory, 4096);
+		m_SystemMemoryWindow->DrawWindow("System Memory", (void*)&m_Cpu->GetState()->Memory, sizeof(ChipState::Memory));
 
 	if (m_bShowStackView)
 		m_StackMemoryWindow->DrawWindow("Stack",(void *)& m_Cpu->GetState()->Stack, 16);
 
 	ImGui::Render();
-	ImGuiSDL::Render(ImGui::GetDrawData());
-}
 
-void Emulator::Present()
-{
-	SDL_RenderPresent(m_Renderer);
-}
+	const uint64_t uiFingerprint = ImGuiSDL::Fingerprint(ImGui::GetDrawData());
+	const uint32_t videoMemoryVersion = m_Cpu->GetState()->VideoMemoryVersion;
 
-void Emulator::UpdateTimers()
-{
-	static float timeElapsed = 0.0f;
+	// If nothing on screen would change, keep showing the last frame that was presented rather than drawing an identical one
+	m_bSkippedDraw = !m_bForceRedraw && uiFingerprint == m_LastUiFingerprint && videoMemoryVersion == m_LastVideoMemoryVersion;
 
-	if (m_GameTimer->TotalTime() - timeElapsed >= 1.0f)
+	if (m_bSkippedDraw)
 	{
-		const ChipState* cpuState = m_Cpu->GetState();
+		m_PerfMonitor->AddSkippedUiFrame();
+		return;
+	}
 
-		if (cpuState->Delay > 0)
-		{
-			uint8_t newValue = cpuState->Delay - ((cpuState->Delay < 60 ) ? cpuState->Delay : 60);
+	SDL_RenderClear(m_Renderer);
 
-			m_Cpu->SetDelayRegister(newValue);
-		}
+	if (m_bForceRedraw || videoMemoryVersion != m_LastVideoMemoryVersion)
+	{
+		const ChipState* state = m_Cpu->GetState();
 
-		if (cpuState->Sound > 0)
+		// 1 in high resolution, 2 in low resolution
+		const int pixelScale = ChipState::k_DisplayWidth / state->DisplayWidth();
+
+		// Only rows the CPU has changed need uploading, unless the whole texture is out of date
+		uint64_t dirtyRows = m_Cpu->TakeDirtyRows();
+
+		if (m_bForceRedraw)
+			dirtyRows = ~0ull;
+
+		// Upload each run of consecutive dirty rows as one rectangle
+		for (int firstRow = 0; firstRow < state->DisplayHeight(); firstRow++)
 		{
-			uint8_t newValue = cpuState->Sound - ((cpuState->Sound < 60) ? cpuState->Sound : 60);
+			if ((dirtyRows & (1ull << firstRow)) == 0)
+				continue;
+
+			int endRow = firstRow + 1;
+
+			while (endRow < state->DisplayHeight() && (dirtyRows & (1ull << endRow)) != 0)
+			{
+				endRow++;
+			}
+
+			for (int y = firstRow * pixelScale; y < endRow * pixelScale; y++)
+			{
+				for (int x = 0; x < ChipState::k_DisplayWidth; x++)
+				{
+					m_PixelBuffer[x + (y * ChipState::k_DisplayWidth)] = k_Palette[state->PixelColour(x / pixelScale, y / pixelScale)];
+				}
+			}
+
+			const SDL_Rect uploadRect = { 0, firstRow * pixelScale, ChipState::k_DisplayWidth, (endRow - firstRow) * pixelScale };
 
-			m_Cpu->SetSoundRegister(newValue);
+			SDL_UpdateTexture(m_RenderTexture, &uploadRect, &m_PixelBuffer[uploadRect.y * ChipState::k_DisplayWidth], ChipState::k_DisplayWidth * sizeof(uint32_t));
+
+			firstRow = endRow;
 		}
 
-		timeElapsed += 1.0f;
+		m_PerfMonitor->AddTextureUpload();
 	}
+
+	SDL_RenderCopy(m_Renderer, m_RenderTexture, NULL, NULL);
+
+	m_LastUiFingerprint = uiFingerprint;
+	m_LastVideoMemoryVersion = videoMemoryVersion;
+	m_bForceRedraw = false;
+
+	PROFILE_SCOPE("ImGuiSDL::Render");
+
+	int64_t renderStartTime = Profiler::Now();
+	if (m_bUseSoftwareUiRenderer)
+	{
+		ImGuiSDL::RenderSoftware(ImGui::GetDrawData());
+	}
+	else
+	{
+		ImGuiSDL::Render(ImGui::GetDrawData());
+	}
+
+	m_PerfMonitor->AddImGuiRenderTime((Profiler::Now() - renderStartTime) / 1e9f);
+}
+
+void Emulator::Present()
+{
+	if (m_bSkippedDraw)
+		return;
+
+	PROFILE_SCOPE("Present");
+
+	SDL_RenderPresent(m_Renderer);
+
+	if (m_LatencyProbe->IsEnabled())
+		m_LatencyProbe->OnPresent(Profiler::Now());
+}
+
+void Emulator::UpdateTimers()
+{
+	// Timers are part of the emulated machine, so they're frozen along with the CPU
+	if (IsIdle())
+		return;
+
+	m_Cpu->TickTimers();
+
+	m_PerfMonitor->AddTimerTick();
 }
 
 void Emulator::DrawMainMenu()
@@ -252,9 +745,9 @@ void Emulator::DrawMainMenu()
 	{
 		if (ImGui::BeginMenu("File"))
 		{
-			if (ImGui::MenuItem("Load ROM"))
+			if (ImGui::MenuItem("ROM Library", NULL, m_bShowRomLibrary))
 			{
-				LoadRom();
+				m_bShowRomLibrary = !m_bShowRomLibrary;
 			}
 
 			ImGui::EndMenu();
@@ -273,16 +766,111 @@ void Emulator::DrawMainMenu()
 				m_bExecuteSingleInstruction = !m_bExecuteSingleInstruction;
 			}
 
+			ImGui::Separator();
+
+			if (ImGui::MenuItem("Fast-Forward", "F9", m_bIsFastForwarding))
+			{
+				ToggleFastForward();
+			}
+
+			// Picked automatically when a ROM is loaded from the library, but can be changed at any time
+			if (ImGui::BeginMenu("Quirks"))
+			{
+				for (int i = 0; i < k_QuirkProfileCount; i++)
+				{
+					const QuirkProfile profile = static_cast<QuirkProfile>(i);
+
+					if (ImGui::MenuItem(QuirkProfileName(profile), NULL, m_Cpu->GetQuirkProfile() == profile))
+					{
+						m_Cpu->SetQuirkProfile(profile);
+					}
+				}
+
+				ImGui::EndMenu();
+			}
+
+			// Runs instructions for as long as they took on the VIP rather than a fixed number per frame. Nothing is fused while it's on.
+			if (ImGui::MenuItem("COSMAC VIP Timing", NULL, m_bIsVipTimingEnabled))
+			{
+				m_bIsVipTimingEnabled = !m_bIsVipTimingEnabled;
+			}
+
+			if (ImGui::MenuItem("Fuse Instructions", NULL, m_Cpu->IsFusionEnabled(), !m_bIsVipTimingEnabled && !m_Cpu->AreMemoryChecksEnabled()))
+			{
+				m_Cpu->SetFusionEnabled(!m_Cpu->IsFusionEnabled());
+			}
+
+			// Stops the ROM on the first access past the end of memory or the stack, rather than wrapping around. On by default in debug builds.
+			if (ImGui::MenuItem("Check Memory Access", NULL, m_Cpu->AreMemoryChecksEnabled()))
+			{
+				m_Cpu->SetMemoryChecksEnabled(!m_Cpu->AreMemoryChecksEnabled());
+			}
+
+			ImGui::Separator();
+
+			if (ImGui::MenuItem("Sound", NULL, m_bIsSoundEnabled, m_AudioDevice != 0))
+			{
+				m_bIsSoundEnabled = !m_bIsSoundEnabled;
+
+				SDL_PauseAudioDevice(m_AudioDevice, m_bIsSoundEnabled ? 0 : 1);
+			}
+
+			if (ImGui::BeginMenu("Audio Buffer", m_AudioDevice != 0))
+			{
+				// Reopening the device replaces the beeper (Or leaves none if it fails), so the rate is read once up front
+				const uint32_t sampleRate = m_Beeper != nullptr ? m_Beeper->SampleRate() : Beeper::k_DefaultSampleRate;
+
+				for (uint32_t bufferSamples : k_AudioBufferSizes)
+				{
+					char label[32];
+					snprintf(label, sizeof(label), "%u samples (%.1f ms)", bufferSamples, 1000.0 * bufferSamples / sampleRate);
+
+					if (ImGui::MenuItem(label, NULL, m_AudioBufferSamples == bufferSamples))
+					{
+						const uint32_t previousBufferSamples = m_AudioBufferSamples;
+
+						m_AudioBufferSamples = bufferSamples;
+
+						// Go back to the size that worked rather than leaving sound (And this menu) disabled for good
+						if (!InitAudio())
+						{
+							m_AudioBufferSamples = previousBufferSamples;
+							InitAudio();
+						}
+						break;
+					}
+				}
+
+				ImGui::EndMenu();
+			}
+
 			ImGui::EndMenu();
 		}
 
 		if (ImGui::BeginMenu("Debug"))
 		{
 			ImGui::MenuItem("Show Debug Overlay",       NULL,  &m_bShowDebugOverlay);
+			ImGui::MenuItem("Show Performance",         NULL,  &m_bShowPerformanceView);
 			ImGui::MenuItem("Show Stack",               NULL,  &m_bShowStackView);
 			ImGui::MenuItem("Show Full System Memory",  NULL,  &m_bShowSystemMemoryView);
 			ImGui::MenuItem("Show VRAM",                NULL,  &m_bShowVRamView);
 
+			ImGui::Separator();
+
+			ImGui::MenuItem("Software UI Compositor",   NULL,  &m_bUseSoftwareUiRenderer);
+
+			if (ImGui::MenuItem("Measure Input Latency", NULL, m_LatencyProbe->IsEnabled()))
+			{
+				ToggleLatencyProbe();
+			}
+
+			ImGui::Separator();
+
+			if (ImGui::MenuItem("Export Timeline Trace"))
+			{
+				Profiler::ExportChromeTrace(k_TraceFilePath);
+			}
+
 			ImGui::EndMenu();
 		}
 	}
@@ -379,12 +967,172 @@ void Emulator::DrawDebugOverlay()
 	ImGui::End();
 }
 
+void Emulator::DrawPerformanceWindow()
+{
+	ImGui::SetNextWindowSize(ImVec2(420.0f, 0.0f), ImGuiCond_FirstUseEver);
+
+	if (ImGui::Begin("Performance", &m_bShowPerformanceView))
+	{
+		const RingBuffer<float, PerformanceMonitor::k_FrameHistorySize>& frameTimes = m_PerfMonitor->FrameTimes();
+
+		float lastFrameTime = (frameTimes.Size() > 0) ? frameTimes.Newest() : 0.0f;
+
+		ImGui::Text("Frame Time:      %6.2f ms", lastFrameTime);
+		ImGui::Text("p50 / p99:       %6.2f ms / %6.2f ms", m_PerfMonitor->FrameTimePercentile(50.0f), m_PerfMonitor->FrameTimePercentile(99.0f));
+
+		ImGui::PlotLines("##FrameTimes", frameTimes.Data(), static_cast<int>(frameTimes.Size()), static_cast<int>(frameTimes.Offset()),
+			"Frame Time (ms)", 0.0f, 50.0f, ImVec2(0.0f, 60.0f));
+
+		const std::array<float, PerformanceMonitor::k_HistogramBuckets>& histogram = m_PerfMonitor->FrameTimeHistogram();
+
+		ImGui::PlotHistogram("##FrameTimeHistogram", histogram.data(), static_cast<int>(histogram.size()), 0,
+			"Frame Time Histogram (1 ms buckets)", 0.0f, FLT_MAX, ImVec2(0.0f, 60.0f));
+
+		ImGui::Separator();
+
+		uint64_t instructionsPerSecond = m_PerfMonitor->InstructionsPerSecond();
+
+		const uint32_t targetInstructionsPerSecond = m_InstructionsPerFrame * k_FrameRate;
+
+		ImGui::Text("Instructions/s:  %8llu (Target %u, %.0f%%)", static_cast<unsigned long long>(instructionsPerSecond), targetInstructionsPerSecond,
+			(instructionsPerSecond * 100.0f) / targetInstructionsPerSecond);
+
+		ImGui::Text("Timer Ticks/s:   %8u (Target %u)", m_PerfMonitor->TimerTicksPerSecond(), k_TargetTimerTickRate);
+		ImGui::Text("Emulation Speed: %8.1fx%s", static_cast<float>(m_PerfMonitor->EmulatedFramesPerSecond()) / k_FrameRate, m_bIsFastForwarding ? " (Fast-Forward)" : "");
+		ImGui::Text("Texture Uploads: %8u /s", m_PerfMonitor->TextureUploadsPerSecond());
+		ImGui::Text("Skipped Frames:  %8u /s (Total %llu)", m_PerfMonitor->SkippedUiFramesPerSecond(), static_cast<unsigned long long>(m_PerfMonitor->SkippedUiFrames()));
+
+		ImGui::Separator();
+
+		ImGui::Text("ImGui Render:    %6.2f ms (Avg %6.2f ms)", m_PerfMonitor->LastImGuiRenderTime(), m_PerfMonitor->AverageImGuiRenderTime());
+
+		if (m_bUseSoftwareUiRenderer)
+		{
+			const ImGuiSDL::SoftwareRenderStats uiStats = ImGuiSDL::GetSoftwareRenderStats();
+
+			ImGui::Text("UI Redrawn:      %6.1f %% (%d rects, %d tiles on %d threads)", (uiStats.TotalPixels > 0) ? (uiStats.DirtyPixels * 100.0f) / uiStats.TotalPixels : 0.0f,
+				uiStats.DirtyRects, uiStats.Tiles, uiStats.Threads);
+		}
+
+		ImGui::Separator();
+
+		ImGui::Text("Pacer Jitter:    %6.3f ms (Max %6.3f ms)", m_FramePacer->AverageJitter(), m_FramePacer->MaxJitter());
+		ImGui::Text("Process CPU:     %6.1f %%", m_FramePacer->CpuUsage());
+
+		if (m_LatencyProbe->IsEnabled() || m_LatencyProbe->Total().Size() > 0)
+		{
+			ImGui::Separator();
+
+			ImGui::Text("Input Latency (%u samples%s)", static_cast<uint32_t>(m_LatencyProbe->Total().Size()), m_LatencyProbe->IsEnabled() ? ", press keypad keys" : "");
+
+			const struct { const char* Label; const RingBuffer<float, LatencyProbe::k_SampleHistorySize>& Samples; } stages[] =
+			{
+				{ "Event -> VRAM:  ", m_LatencyProbe->EventToVideoMemory() },
+				{ "VRAM -> Present:", m_LatencyProbe->VideoMemoryToPresent() },
+				{ "Total:          ", m_LatencyProbe->Total() }
+			};
+
+			for (const auto& stage : stages)
+			{
+				ImGui::Text("%s p50 %6.2f ms  p99 %6.2f ms  Max %6.2f ms", stage.Label, m_LatencyProbe->Percentile(stage.Samples, 50.0f),
+					m_LatencyProbe->Percentile(stage.Samples, 99.0f), m_LatencyProbe->Percentile(stage.Samples, 100.0f));
+			}
+
+			const std::array<float, LatencyProbe::k_HistogramBuckets>& latencyHistogram = m_LatencyProbe->TotalHistogram();
+
+			ImGui::PlotHistogram("##LatencyHistogram", latencyHistogram.data(), static_cast<int>(latencyHistogram.size()), 0,
+				"Total Latency Histogram (1 ms buckets)", 0.0f, FLT_MAX, ImVec2(0.0f, 60.0f));
+		}
+	}
+	ImGui::End();
+}
+
+void Emulator::DrawRomLibraryWindow()
+{
+	ImGui::SetNextWindowSize(ImVec2(640.0f, 480.0f), ImGuiCond_FirstUseEver);
+
+	if (ImGui::Begin("ROM Library", &m_bShowRomLibrary))
+	{
+		if (ImGui::Button("Choose Folder..."))
+		{
+			BrowseForRomFolder();
+		}
+
+		ImGui::SameLine();
+
+		if (ImGui::Button("Rescan") && !m_RomLibrary->RootPath().empty())
+		{
+			ScanRomLibrary(m_RomLibrary->RootPath());
+		}
+
+		ImGui::SameLine();
+		ImGui::TextUnformatted(m_RomLibrary->RootPath().empty() ? "No folder chosen" : m_RomLibrary->RootPath().u8string().c_str());
+
+		const std::vector<RomLibrary::RomEntry>& roms = m_RomLibrary->Entries();
+		const RomLibrary::ScanStats& lastScan = m_RomLibrary->LastScan();
+
+		ImGui::Text("%zu ROMs (Last scan: %zu hashed, %zu removed in %.1f ms)", roms.size(), lastScan.Hashed, lastScan.Removed, lastScan.Milliseconds);
+
+		if (m_RomLibraryFilter.Draw("Search"))
+		{
+			UpdateRomLibraryFilter();
+		}
+
+		ImGui::BeginChild("##RomList", ImVec2(0.0f, 0.0f), true);
+
+		ImGui::Columns(4, "##RomColumns");
+		ImGui::Text("Name");     ImGui::NextColumn();
+		ImGui::Text("Platform"); ImGui::NextColumn();
+		ImGui::Text("Size");     ImGui::NextColumn();
+		ImGui::Text("Hash");     ImGui::NextColumn();
+		ImGui::Separator();
+
+		// Only the visible rows are submitted, so the list stays cheap however large the library is
+		ImGuiListClipper clipper(static_cast<int>(m_FilteredRoms.size()));
+
+		while (clipper.Step())
+		{
+			for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++)
+			{
+				const RomLibrary::RomEntry& rom = roms[m_FilteredRoms[row]];
+
+				ImGui::PushID(row);
+
+				if (ImGui::Selectable(rom.Name.c_str(), false, ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_AllowDoubleClick) && ImGui::IsMouseDoubleClicked(0))
+				{
+					LoadRom(rom);
+				}
+
+				ImGui::NextColumn();
+
+				ImGui::Text("%s (%u/frame)", RomLibrary::PlatformName(rom.Platform), rom.InstructionsPerFrame);
+				ImGui::NextColumn();
+
+				ImGui::Text("%llu B", static_cast<unsigned long long>(rom.Size));
+				ImGui::NextColumn();
+
+				ImGui::Text("%016llX", static_cast<unsigned long long>(rom.Hash));
+				ImGui::NextColumn();
+
+				ImGui::PopID();
+			}
+		}
+
+		ImGui::Columns(1);
+		ImGui::EndChild();
+	}
+	ImGui::End();
+}
+
 void Emulator::Stop()
 {
 	m_bIsRunning = false;
 
 	m_Cpu->Stop();
 
+	if (m_AudioDevice != 0)
+		SDL_CloseAudioDevice(m_AudioDevice);
+
 	if (m_RenderTexture != nullptr)
 		SDL_DestroyTexture(m_RenderTexture);
 
@@ -6,9 +6,16 @@
 #include <SDL_syswm.h>
 #include <shobjidl.h>
 
+#include "Beeper.h"
 #include "CPU.h"
+#include "FramePacer.h"
 #include "GameTimer.h"
 #include "ImGuiImpl.h"
+#include "InputQueue.h"
+#include "LatencyProbe.h"
+#include "PerformanceMonitor.h"
+#include "Profiler.h"
+#include "RomLibrary.h"
 #include "imgui_memory_editor.h"
 
 /*
@@ -45,44 +52,137 @@ private:
 	/// </summary>
 	void InitCpu();
 
+	/// <summary>
+	/// Opens the audio device with the current buffer size and starts the beeper playing through it. Closes the device first if it's already open.
+	/// </summary>
+	/// <returns>True if the audio device was opened. False if there's no audio device, in which case the emulator runs silently</returns>
+	bool InitAudio();
+
+	/// <summary>
+	/// Fills an audio device buffer from the beeper. Called by SDL on its audio thread.
+	/// </summary>
+	static void SDLCALL AudioCallback(void* userData, Uint8* stream, int length);
+
+	/// <summary>
+	/// Writes a byte edited in the System Memory view through the CPU, so its decoded instructions stay up to date
+	/// </summary>
+	static void WriteSystemMemory(ImU8* data, size_t offset, ImU8 value);
+
+	/// <summary>
+	/// Writes a byte edited in the VRAM view through the CPU, so the edited row is redrawn
+	/// </summary>
+	static void WriteVideoMemory(ImU8* data, size_t offset, ImU8 value);
+
 	/// <summary>
 	/// Initialises Dear ImGui integration
 	/// </summary>
 	void InitImGui();
 
 	/// <summary>
-	/// Displays a 'File Browse Dialog' for the end-user to select a ROM to load from disk.
+	/// Resets the CPU and loads a ROM from the library, ready to be executed at the ROM's preferred speed
 	/// </summary>
-	/// <returns>True if a ROM was selected and loaded successfully. False if either no ROM was selected or nothing loading failed.</returns>
-	bool LoadRom();
+	/// <param name="rom">ROM to load</param>
+	/// <returns>True if the ROM was loaded successfully. Otherwise false</returns>
+	bool LoadRom(const RomLibrary::RomEntry& rom);
+
+	/// <summary>
+	/// Displays a 'Folder Browse Dialog' for the end-user to select the folder their ROMs are in, then scans it into the ROM library.
+	/// </summary>
+	/// <returns>True if a folder was selected and scanned. False if no folder was selected or it couldn't be scanned.</returns>
+	bool BrowseForRomFolder();
+
+	/// <summary>
+	/// Brings the ROM library up to date with the ROMs under a folder and saves its index
+	/// </summary>
+	/// <param name="folderPath">Folder to scan</param>
+	/// <returns>True if the folder was scanned. Otherwise false</returns>
+	bool ScanRomLibrary(const std::filesystem::path& folderPath);
+
+	/// <summary>
+	/// Rebuilds the list of library ROMs that match the search text
+	/// </summary>
+	void UpdateRomLibraryFilter();
 
 	/// <summary>
 	/// Handles any pending SDL or Windows window events
 	/// </summary>
-	void HandleEvents();
+	/// <returns>True if any events were handled. Otherwise false</returns>
+	bool HandleEvents();
 
 	/// <summary>
-	/// Checks for key press events and if found 
+	/// Blocks until an event is waiting to be handled or 'k_IdleWaitTimeoutMs' passes. Used while idle to avoid redrawing frames that haven't changed.
+	/// </summary>
+	/// <returns>True if an event is waiting to be handled. False if the wait timed out</returns>
+	bool WaitForEvents();
+
+	/// <summary>
+	/// Checks if the emulator has nothing to execute (No ROM is loaded or the CPU is paused)
+	/// </summary>
+	/// <returns>True if the emulator is idle. Otherwise false</returns>
+	bool IsIdle() const;
+
+	/// <summary>
+	/// Updates Dear ImGui's mouse state and frame time ready for a new frame
 	/// </summary>
 	void Update();
 
 	/// <summary>
-	/// Clears the display and prepares to draw a new frame
+	/// Passes key transitions that happened at or before the specified time to the CPU.
+	/// Stops after a transition that presses a new key, so the press is seen by at least one instruction before it can be released again.
+	/// </summary>
+	/// <param name="time">Time (From 'Profiler::Now()') up to which transitions are delivered</param>
+	void DeliverInput(int64_t time);
+
+	/// <summary>
+	/// Passes every pending key transition to the CPU at once. Used when the CPU isn't running a full frame.
+	/// </summary>
+	void FlushInput();
+
+	/// <summary>
+	/// Emulates a single 60Hz frame: Executes 'k_InstructionsPerFrame' instructions (Or a frame's worth of machine cycles with COSMAC VIP timing) and then ticks the delay and sound timers
+	/// </summary>
+	void RunFrame();
+
+	/// <summary>
+	/// Runs the CPU for one frame's worth of COSMAC VIP machine cycles, delivering input part-way through if any is waiting
+	/// </summary>
+	/// <param name="inputWindowLength">Real time the frame stands in for (ns)</param>
+	/// <returns>Number of instructions executed</returns>
+	uint32_t RunTimedFrame(int64_t inputWindowLength);
+
+	/// <summary>
+	/// Emulates frames as fast as the host allows for one display refresh interval. Timers still tick once per emulated frame so ROMs see normal timing.
+	/// </summary>
+	void RunFastForward();
+
+	/// <summary>
+	/// Turns fast-forward mode on or off
+	/// </summary>
+	void ToggleFastForward();
+
+	/// <summary>
+	/// Starts or stops measuring input latency. Starting loads and runs the bundled probe ROM and opens the performance panel to show the results.
 	/// </summary>
-	void Clear();
+	void ToggleLatencyProbe();
 
 	/// <summary>
-	/// Draws the emulator VRAM and Dear ImGui UI to screen
+	/// Starts a new Dear ImGui frame, ready for the UI to be built
+	/// </summary>
+	void BeginFrame();
+
+	/// <summary>
+	/// Builds the Dear ImGui UI and draws it and the emulator VRAM to screen.
+	/// Drawing is skipped if neither the UI nor the VRAM have changed since the last frame that was drawn.
 	/// </summary>
 	void Draw();
 
 	/// <summary>
-	/// Pushes the current back buffer to screen to be drawn
+	/// Pushes the current back buffer to screen to be drawn, unless drawing was skipped this frame
 	/// </summary>
 	void Present();
 
 	/// <summary>
-	/// Decrements the CPU's 'Sound' and/or 'Delay' timers each second if they're currently greater than 0
+	/// Decrements the CPU's 'Sound' and/or 'Delay' timers by one if they're currently greater than 0. Called once per emulated 60Hz frame while the CPU is running.
 	/// </summary>
 	void UpdateTimers();
 
@@ -97,6 +197,16 @@ private:
 	/// </summary>
 	void DrawDebugOverlay();
 
+	/// <summary>
+	/// Draws the ImGui performance panel showing frame times, emulation speed and rendering statistics
+	/// </summary>
+	void DrawPerformanceWindow();
+
+	/// <summary>
+	/// Draws the ImGui ROM library window, listing every ROM in the library folder. Double-clicking a ROM loads it.
+	/// </summary>
+	void DrawRomLibraryWindow();
+
 private:
 	// Set to true if the emulator is currently running (Not including the CPU)
 	bool m_bIsRunning = false;
@@ -107,11 +217,21 @@ private:
 	// Set to true if a ROM has been loaded into the CPU's memory ready for execution. False if no ROM has been loaded.
 	bool m_bIsProgramLoaded = false;
 
-	// Buffer for uploading VRAM to the GPU for rendering
-	uint32_t m_PixelBuffer[2048];
+	// Number of instructions the CPU executes each frame. Set from the library when a ROM is loaded.
+	uint32_t m_InstructionsPerFrame = k_InstructionsPerFrame;
+
+	// Buffer for uploading VRAM to the GPU for rendering. Always high resolution; low resolution pixels are drawn as 2x2 blocks.
+	uint32_t m_PixelBuffer[ChipState::k_DisplayWidth * ChipState::k_DisplayHeight];
+
+	// Timestamped CHIP-8 key transitions waiting to be delivered to the CPU
+	InputQueue* m_InputQueue = nullptr;
 
-	// State of each keyboard key (i.e. Is it pressed or not)
-	Uint8* m_KeyStates = nullptr;
+	// Key mask most recently delivered to the CPU
+	uint16_t m_DeliveredKeyMask = 0;
+
+	// Span of real time (From 'Profiler::Now()') the current frame's instructions stand in for. Key transitions within it are delivered at the matching instruction.
+	int64_t m_InputWindowStart = 0;
+	int64_t m_InputWindowEnd = 0;
 
 	// Main application window for the emulator
 	SDL_Window* m_GameWindow = nullptr;
@@ -125,12 +245,34 @@ private:
 	// Pointer to the CPU instance that will be used for emulation
 	CPU* m_Cpu = nullptr;
 
+	// Synthesises the sound timer's tone. Fed by the main loop and rendered by the audio thread.
+	Beeper* m_Beeper = nullptr;
+
+	// Audio device the beeper plays through (0 if none could be opened)
+	SDL_AudioDeviceID m_AudioDevice = 0;
+
 	// Game timer class used for handling timer-related emulation tasks
 	GameTimer* m_GameTimer = nullptr;
 
+	// Paces the main loop so each frame takes 'k_FrameRate' of a second
+	FramePacer* m_FramePacer = nullptr;
+
 	// ImGui implementation. Handles key presses and state for the ImGui integration
 	ImGuiImpl* m_ImGuiContext = nullptr;
 
+	// Collects frame timing and throughput statistics for the performance panel
+	PerformanceMonitor* m_PerfMonitor = nullptr;
+
+	// Measures the time from key events to VRAM changes and presents while the probe ROM is running
+	LatencyProbe* m_LatencyProbe = nullptr;
+
+	// Every ROM in the library folder, with cached hashes and metadata
+	RomLibrary* m_RomLibrary = nullptr;
+
+	// Search text for the ROM library window, and the indices of the library entries that match it
+	ImGuiTextFilter m_RomLibraryFilter;
+	std::vector<size_t> m_FilteredRoms;
+
 private:
 
 	/*ImGui Memory Viewers*/
@@ -144,6 +286,9 @@ private:
 	// Memory viewer for the CPU's full memory view
 	MemoryEditor* m_SystemMemoryWindow = nullptr;
 
+	// CPU the memory viewers edit. The viewers' write handlers don't take any user data, so this is how they find it.
+	static inline CPU* s_EditedCpu = nullptr;
+
 	/* ImGui State variables */
 
 	// Set to true if the ImGui VRAM memory viewer should be displayed on-screen
@@ -158,9 +303,47 @@ private:
 	// Set to true if the ImGui registers overlay should be displayed on-screen
 	bool m_bShowDebugOverlay = true;
 
+	// Set to true if the ImGui performance panel should be displayed on-screen
+	bool m_bShowPerformanceView = false;
+
+	// Set to true if the ImGui ROM library window should be displayed on-screen
+	bool m_bShowRomLibrary = false;
+
 	// If set to true the CPU will execute a single instruction and then pause again
 	bool m_bExecuteSingleInstruction = false;
 
+	// Set to true if the CPU is running unthrottled, only redrawing once per display refresh
+	bool m_bIsFastForwarding = false;
+
+	// Set to true if each frame runs for the machine cycles the COSMAC VIP had rather than a fixed number of instructions
+	bool m_bIsVipTimingEnabled = false;
+
+	// Set to true if the sound timer's tone is played
+	bool m_bIsSoundEnabled = true;
+
+	// Samples in each audio device buffer. Smaller buffers start and stop the tone sooner but are more likely to crackle on a busy host.
+	uint32_t m_AudioBufferSamples = k_DefaultAudioBufferSamples;
+
+	// Set to true if the UI is rasterized on the CPU and only changed regions are uploaded, rather than drawn triangle by triangle through the renderer.
+	// Defaults to on when SDL could only create a software renderer.
+	bool m_bUseSoftwareUiRenderer = false;
+
+	// Refresh rate of the display the main window is on (Hz). Limits how often the screen is redrawn while fast-forwarding.
+	int m_DisplayRefreshRate = 60;
+
+	// Fingerprint of the UI draw data and the VRAM version of the last frame that was drawn. Used to skip drawing frames that wouldn't change anything.
+	uint64_t m_LastUiFingerprint = 0;
+	uint32_t m_LastVideoMemoryVersion = 0;
+
+	// Set to true when the window needs to be redrawn even if nothing in it changed (e.g. it was uncovered or resized)
+	bool m_bForceRedraw = true;
+
+	// Set to true if drawing was skipped this frame, so there's nothing new to present
+	bool m_bSkippedDraw = false;
+
+	// Number of frames still to be drawn while idle before the emulator goes back to waiting for events. Reset whenever something may have changed the UI.
+	uint32_t m_IdleRedrawFrames = 0;
+
 private:
 
 	/* Constants */
@@ -172,13 +355,39 @@ private:
 	// Title displayed for the main appliaction window
 	const char* k_WindowTitle = "CHIP-8 Emulator";
 
-	// List of file types selectable on the 'Open File Dialog' when browsing to a ROM file on disk.
-	const COMDLG_FILTERSPEC k_FileFilterSpec[3] =
-	{
-		{ L"CHIP-8 Program", L"*.ch8" },
-		{ L"Binary Files",   L"*.bin" },
-		{ L"All Files",      L"*.*" }
-	};
+	// Number of frames per second the main loop is paced to. The delay and sound timers tick once per frame.
+	static constexpr uint32_t k_FrameRate = 60;
+
+	// Frames drawn after an event while idle. ImGui needs a couple of frames to settle hover and focus state after input.
+	const uint32_t k_IdleRedrawFrameCount = 3;
+
+	// Longest time the emulator blocks waiting for events while idle
+	const int k_IdleWaitTimeoutMs = 250;
+
+	// ARGB colour of each pixel value (Plane 0 is bit 0, plane 1 is bit 1). CHIP-8 and SCHIP ROMs only draw to plane 0, so they stay black and white.
+	static constexpr uint32_t k_Palette[4] = { 0xFF000000, 0xFFFFFFFF, 0xFFFF6600, 0xFF662200 };
+
+	// Number of instructions the CPU executes each frame, unless the loaded ROM prefers a different speed
+	static constexpr uint32_t k_InstructionsPerFrame = 10;
+
+	// Number of slices a frame's machine cycles are split into with COSMAC VIP timing when input has to be delivered part-way through the frame
+	static constexpr uint32_t k_TimedInputSlices = 16;
+
+	// Audio buffer sizes offered in the 'Run' menu. The default of 256 samples is around 5ms at 48kHz.
+	static constexpr uint32_t k_AudioBufferSizes[4] = { 128, 256, 512, 1024 };
+	static constexpr uint32_t k_DefaultAudioBufferSamples = 256;
+
+	// Rate the delay and sound timers are expected to tick at (Hz)
+	const uint32_t k_TargetTimerTickRate = k_FrameRate;
+
+	// File the profiler timeline is written to when exported from the 'Debug' menu
+	const char* k_TraceFilePath = "chip8_trace.json";
+
+	// File the ROM library index is kept in between sessions
+	const char* k_RomLibraryIndexPath = "rom_library.tsv";
+
+	// Key that toggles fast-forward mode
+	const SDL_Scancode k_FastForwardKey = SDL_SCANCODE_F9;
 
 	// Map of SDL2 keycodes for the various keyboard keys the CHIP-8 can handle/react to
 	const Uint8 k_KeyCodes[16] =
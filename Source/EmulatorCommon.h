@@ -1,13 +1,21 @@
 #pragma once
 
+#ifdef _WIN32
 #ifndef WIN32_LEAN_AND_MEAN
 #define WIN32_LEAN_AND_MEAN
 #endif // !WIN32_LEAN_AND_MEAN
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif // !NOMINMAX
 #include <Windows.h>
+#endif // _WIN32
 
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <iomanip>
-#include <stdint.h>
\ No newline at end of file
+#include <stdint.h>
+#include <cstring>
+#include <cstdlib>
+#include <ctime>
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include "FramePacer.h"
+
+#include <thread>
+
+#ifndef _WIN32
+#include <time.h>
+#endif // !_WIN32
+
+FramePacer::FramePacer(double targetFrameTime)
+{
+	SetTargetFrameTime(targetFrameTime);
+	Reset();
+}
+
+void FramePacer::SetTargetFrameTime(double targetFrameTime)
+{
+	m_TargetFrameTime = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(targetFrameTime));
+}
+
+double FramePacer::TargetFrameTime() const
+{
+	return std::chrono::duration<double>(m_TargetFrameTime).count();
+}
+
+void FramePacer::SetSpinTime(double spinTime)
+{
+	m_SpinTime = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(spinTime));
+}
+
+void FramePacer::Reset()
+{
+	Clock::time_point now = Clock::now();
+
+	m_Deadline = now + m_TargetFrameTime;
+
+	m_CpuSampleWallTime = now;
+	m_CpuSampleProcessTime = ProcessCpuTime();
+}
+
+void FramePacer::WaitForNextFrame()
+{
+	Clock::time_point now = Clock::now();
+
+	// Sleep for the bulk of the wait. The OS may wake us up late, which is what the spin time allows for.
+	if (m_Deadline - now > m_SpinTime)
+	{
+		std::this_thread::sleep_for(m_Deadline - now - m_SpinTime);
+	}
+
+	// Spin out the rest of the frame to hit the deadline precisely
+	now = Clock::now();
+
+	while (now < m_Deadline)
+	{
+		std::this_thread::yield();
+		now = Clock::now();
+	}
+
+	m_Jitter.Push(std::chrono::duration<float, std::milli>(now - m_Deadline).count());
+
+	m_Deadline += m_TargetFrameTime;
+
+	// If we've fallen more than a frame behind (e.g. the window was being dragged) don't try to catch up with a burst of frames
+	if (now > m_Deadline)
+	{
+		m_Deadline = now + m_TargetFrameTime;
+	}
+
+	UpdateCpuUsage(now);
+}
+
+float FramePacer::MaxJitter() const
+{
+	float maxJitter = 0.0f;
+
+	for (size_t i = 0; i < m_Jitter.Size(); i++)
+	{
+		if (m_Jitter[i] > maxJitter)
+			maxJitter = m_Jitter[i];
+	}
+
+	return maxJitter;
+}
+
+float FramePacer::AverageJitter() const
+{
+	if (m_Jitter.Size() == 0)
+		return 0.0f;
+
+	float total = 0.0f;
+
+	for (size_t i = 0; i < m_Jitter.Size(); i++)
+	{
+		total += m_Jitter[i];
+	}
+
+	return total / m_Jitter.Size();
+}
+
+void FramePacer::UpdateCpuUsage(Clock::time_point now)
+{
+	double wallTime = std::chrono::duration<double>(now - m_CpuSampleWallTime).count();
+
+	if (wallTime < 1.0)
+		return;
+
+	double processTime = ProcessCpuTime();
+
+	m_CpuUsage = static_cast<float>(((processTime - m_CpuSampleProcessTime) / wallTime) * 100.0);
+
+	m_CpuSampleWallTime = now;
+	m_CpuSampleProcessTime = processTime;
+}
+
+double FramePacer::ProcessCpuTime()
+{
+#ifdef _WIN32
+	FILETIME creationTime, exitTime, kernelTime, userTime;
+
+	if (!::GetProcessTimes(::GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime))
+		return 0.0;
+
+	// FILETIME values are in 100 nanosecond intervals
+	uint64_t kernel = (static_cast<uint64_t>(kernelTime.dwHighDateTime) << 32) | kernelTime.dwLowDateTime;
+	uint64_t user = (static_cast<uint64_t>(userTime.dwHighDateTime) << 32) | userTime.dwLowDateTime;
+
+	return (kernel + user) * 1e-7;
+#else
+	timespec cpuTime;
+
+	if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpuTime) != 0)
+		return 0.0;
+
+	return cpuTime.tv_sec + cpuTime.tv_nsec * 1e-9;
+#endif // _WIN32
+}
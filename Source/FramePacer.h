@@ -0,0 +1,116 @@
+#pragma once
+
+#include "EmulatorCommon.h"
+
+#include <chrono>
+
+#include "RingBuffer.h"
+
+/*
+* Paces the main loop to a fixed target frame time.
+*
+* Waiting is split into two stages: The thread sleeps until it is close to the deadline (Which costs no CPU time but wakes
+* up with scheduler-dependant accuracy) and then spins for the remaining fraction of a millisecond to hit the deadline precisely.
+* Measured wake-up jitter and the process CPU usage are recorded so they can be shown on the performance panel.
+*/
+class FramePacer
+{
+public:
+	// Number of frames of wake-up jitter history kept
+	static constexpr size_t k_JitterHistorySize = 240;
+
+public:
+	/// <summary>
+	/// Creates a frame pacer
+	/// </summary>
+	/// <param name="targetFrameTime">Time each frame should take, in seconds</param>
+	explicit FramePacer(double targetFrameTime);
+
+	/// <summary>
+	/// Changes the time each frame should take
+	/// </summary>
+	/// <param name="targetFrameTime">Time each frame should take, in seconds</param>
+	void SetTargetFrameTime(double targetFrameTime);
+
+	/// <summary>
+	/// Gets the time each frame should take
+	/// </summary>
+	/// <returns>Target frame time in seconds</returns>
+	double TargetFrameTime() const;
+
+	/// <summary>
+	/// Sets how long before the deadline the pacer stops sleeping and starts spinning.
+	/// Larger values are more accurate on hosts with coarse sleep granularity but use more CPU time.
+	/// </summary>
+	/// <param name="spinTime">Spin time in seconds</param>
+	void SetSpinTime(double spinTime);
+
+	/// <summary>
+	/// Starts pacing from the current time. Should be called before the main loop and after long stalls.
+	/// </summary>
+	void Reset();
+
+	/// <summary>
+	/// Blocks until the deadline of the current frame has been reached and then starts the next frame.
+	/// If the deadline has already been missed by more than a frame the pacer resynchronises to the current time instead of trying to catch up.
+	/// </summary>
+	void WaitForNextFrame();
+
+	/// <summary>
+	/// Gets the history of how late the pacer woke up after each deadline
+	/// </summary>
+	/// <returns>Ring buffer of wake-up jitter in milliseconds</returns>
+	const RingBuffer<float, k_JitterHistorySize>& Jitter() const { return m_Jitter; }
+
+	/// <summary>
+	/// Gets the largest wake-up jitter in the recorded history
+	/// </summary>
+	/// <returns>Maximum jitter in milliseconds</returns>
+	float MaxJitter() const;
+
+	/// <summary>
+	/// Gets the average wake-up jitter in the recorded history
+	/// </summary>
+	/// <returns>Average jitter in milliseconds</returns>
+	float AverageJitter() const;
+
+	/// <summary>
+	/// Gets the CPU time used by the whole process during the last full second, as a percentage of a single core
+	/// </summary>
+	/// <returns>CPU usage percentage</returns>
+	float CpuUsage() const { return m_CpuUsage; }
+
+private:
+	/// <summary>
+	/// Gets the total CPU time used by all threads of the process so far
+	/// </summary>
+	/// <returns>CPU time in seconds</returns>
+	static double ProcessCpuTime();
+
+	/// <summary>
+	/// Updates the CPU usage measurement once a full second has passed since it was last updated
+	/// </summary>
+	void UpdateCpuUsage(std::chrono::steady_clock::time_point now);
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	// Time each frame should take
+	Clock::duration m_TargetFrameTime;
+
+	// Time before the deadline at which the pacer switches from sleeping to spinning
+	Clock::duration m_SpinTime = std::chrono::microseconds(2000);
+
+	// Time the current frame should end
+	Clock::time_point m_Deadline;
+
+	// How late (in milliseconds) the pacer woke up after each of the recent deadlines
+	RingBuffer<float, k_JitterHistorySize> m_Jitter;
+
+	// Wall clock and process CPU time at the start of the current CPU usage sampling window
+	Clock::time_point m_CpuSampleWallTime;
+	double m_CpuSampleProcessTime = 0.0;
+
+	// CPU usage calculated over the last full sampling window
+	float m_CpuUsage = 0.0f;
+};
@@ -3,10 +3,14 @@
 GameTimer::GameTimer()
 	: m_SecondsPerCount(0), m_DeltaTime(-1.0), m_BaseTime(0), m_PausedTime(0), m_StopTime(0), m_PrevTime(0), m_CurrentTime(0), m_bIsStopped(false)
 {
-	__int64 countsPerSecond;
-	::QueryPerformanceFrequency((LARGE_INTEGER*)&countsPerSecond);
+	using Period = std::chrono::steady_clock::period;
 
-	m_SecondsPerCount = 1.0 / (double)countsPerSecond;
+	m_SecondsPerCount = static_cast<double>(Period::num) / static_cast<double>(Period::den);
+}
+
+int64_t GameTimer::QueryCounter()
+{
+	return static_cast<int64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
 }
 
 float GameTimer::TotalTime() const
@@ -26,12 +30,13 @@ float GameTimer::DeltaTime() const
 
 void GameTimer::Reset()
 {
-	__int64 currentTime;
-	::QueryPerformanceCounter((LARGE_INTEGER*)&currentTime);
+	int64_t currentTime = QueryCounter();
 
 	m_BaseTime = currentTime;
 	m_PrevTime = currentTime;
+	m_CurrentTime = currentTime;
 
+	m_PausedTime = 0;
 	m_StopTime = 0;
 
 	m_bIsStopped = false;
@@ -39,8 +44,7 @@ void GameTimer::Reset()
 
 void GameTimer::Start()
 {
-	__int64 startTime;
-	::QueryPerformanceCounter((LARGE_INTEGER*)&startTime);
+	int64_t startTime = QueryCounter();
 
 	if (m_bIsStopped)
 	{
@@ -57,8 +61,7 @@ void GameTimer::Stop()
 {
 	if (!m_bIsStopped)
 	{
-		__int64 currentTime;
-		::QueryPerformanceCounter((LARGE_INTEGER*)&currentTime);
+		int64_t currentTime = QueryCounter();
 
 		m_StopTime = currentTime;
 
@@ -74,10 +77,7 @@ void GameTimer::Tick()
 		return;
 	}
 
-	__int64 currentTime;
-	::QueryPerformanceCounter((LARGE_INTEGER*)&currentTime);
-
-	m_CurrentTime = currentTime;
+	m_CurrentTime = QueryCounter();
 
 	m_DeltaTime = (m_CurrentTime - m_PrevTime) * m_SecondsPerCount;
 
@@ -2,8 +2,11 @@
 
 #include "EmulatorCommon.h"
 
+#include <chrono>
+
 /*
-* High resolution timer for accurately emulating clock cycles
+* High resolution timer for accurately emulating clock cycles.
+* Built on std::chrono::steady_clock so it's monotonic and portable across platforms.
 */
 class GameTimer
 {
@@ -45,6 +48,12 @@ public:
 	/// </summary>
 	void Tick();
 
+	/// <summary>
+	/// Reads the current time of the underlying monotonic clock
+	/// </summary>
+	/// <returns>Current clock time in counts (See 'm_SecondsPerCount' for the resolution)</returns>
+	static int64_t QueryCounter();
+
 private:
 	// Resolution of the timer
 	double m_SecondsPerCount;
@@ -53,19 +62,19 @@ private:
 	double m_DeltaTime;
 
 	// Time when the timer started counting/ticking
-	__int64 m_BaseTime;
+	int64_t m_BaseTime;
 
 	// Time when the timer was paused
-	__int64 m_PausedTime;
+	int64_t m_PausedTime;
 
 	// Time when the timer was stopped
-	__int64 m_StopTime;
+	int64_t m_StopTime;
 
 	// Previous start time of the timer
-	__int64 m_PrevTime;
+	int64_t m_PrevTime;
 
 	// The current elapsed time
-	__int64 m_CurrentTime;
+	int64_t m_CurrentTime;
 
 	// True if the timer is stopped and not running
 	bool m_bIsStopped;
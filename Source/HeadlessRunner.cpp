@@ -0,0 +1,913 @@
+#include "HeadlessRunner.h"
+
+#include "WavWriter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <limits>
+#include <thread>
+
+bool HeadlessRunner::ParseArguments(int argc, char* args[])
+{
+	std::filesystem::path inputScriptPath;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string argument = args[i];
+
+		// Every option other than --help and the switches below takes a value
+		const bool bHasValue = i + 1 < argc;
+
+		if (argument == "-h" || argument == "--help")
+		{
+			m_bShowUsage = true;
+			return true;
+		}
+		else if (argument == "--bench-scroll")
+		{
+			m_bBenchmarkScrolls = true;
+			return true;
+		}
+		else if (argument == "--no-idle-skip")
+		{
+			m_bIsIdleSkipEnabled = false;
+		}
+		else if (argument == "--fusion")
+		{
+			m_bIsFusionEnabled = true;
+		}
+		else if (argument == "--vip-timing")
+		{
+			m_bIsVipTimingEnabled = true;
+		}
+		else if (argument == "--checked")
+		{
+			m_bIsMemoryCheckEnabled = true;
+		}
+		else if (argument.rfind("--", 0) == 0 && !bHasValue)
+		{
+			std::cout << "ERROR: Missing value for option '" << argument << "'" << std::endl;
+			return false;
+		}
+		else if (argument == "--cycles")
+		{
+			m_CycleLimit = std::strtoull(args[++i], nullptr, 10);
+		}
+		else if (argument == "--frames")
+		{
+			m_FrameLimit = static_cast<uint32_t>(std::strtoul(args[++i], nullptr, 10));
+		}
+		else if (argument == "--ipf")
+		{
+			m_InstructionsPerFrame = std::max(1u, static_cast<uint32_t>(std::strtoul(args[++i], nullptr, 10)));
+		}
+		else if (argument == "--seed")
+		{
+			m_Seed = static_cast<uint32_t>(std::strtoul(args[++i], nullptr, 0));
+		}
+		else if (argument == "--quirks")
+		{
+			m_bAutoQuirks = strcmp(args[++i], "auto") == 0;
+
+			if (!m_bAutoQuirks && !ParseQuirkProfile(args[i], m_QuirkProfile))
+			{
+				std::cout << "ERROR: Unknown quirk profile '" << args[i] << "'" << std::endl;
+				return false;
+			}
+		}
+		else if (argument == "--threads")
+		{
+			m_ThreadCount = static_cast<unsigned int>(std::strtoul(args[++i], nullptr, 10));
+		}
+		else if (argument == "--input")
+		{
+			inputScriptPath = std::filesystem::u8path(args[++i]);
+		}
+		else if (argument == "--pack")
+		{
+			m_PackPath = std::filesystem::u8path(args[++i]);
+		}
+		else if (argument == "--wav")
+		{
+			m_WavPath = std::filesystem::u8path(args[++i]);
+		}
+		else if (argument.rfind("--", 0) == 0)
+		{
+			std::cout << "ERROR: Unknown option '" << argument << "'" << std::endl;
+			return false;
+		}
+		else if (!AddRomPath(std::filesystem::u8path(argument)))
+		{
+			return false;
+		}
+	}
+
+	if (!inputScriptPath.empty() && !LoadInputScript(inputScriptPath))
+		return false;
+
+	if (m_Roms.empty())
+	{
+		std::cout << "ERROR: No ROMs to run" << std::endl;
+		return false;
+	}
+
+	std::error_code error;
+
+	if (!m_WavPath.empty() && !std::filesystem::is_directory(m_WavPath, error))
+	{
+		std::cout << "ERROR: WAV output folder '" << m_WavPath.u8string() << "' doesn't exist" << std::endl;
+		return false;
+	}
+
+	// Nothing is fused with COSMAC VIP timing, so there'd be nothing to compare
+	if (m_bIsFusionEnabled && m_bIsVipTimingEnabled)
+	{
+		std::cout << "ERROR: --fusion can't be used with --vip-timing" << std::endl;
+		return false;
+	}
+
+	// Nothing is fused while memory is checked either
+	if (m_bIsFusionEnabled && m_bIsMemoryCheckEnabled)
+	{
+		std::cout << "ERROR: --fusion can't be used with --checked" << std::endl;
+		return false;
+	}
+
+	if (m_CycleLimit == 0 && m_FrameLimit == 0)
+	{
+		m_FrameLimit = k_DefaultFrameLimit;
+	}
+
+	return true;
+}
+
+void HeadlessRunner::PrintUsage()
+{
+	std::cout << "Usage: Chip8 [options] <rom, bundle or directory>..." << std::endl
+		<< std::endl
+		<< "Runs each ROM without a window and prints its final state. Directories are searched for .ch8, .c8, .sc8, .xo8 and .bin files," << std::endl
+		<< "and every ROM in a bundle (" << RomBundle::k_FileExtension << ") is run." << std::endl
+		<< std::endl
+		<< "  --cycles <n>    Stop each ROM after n instructions" << std::endl
+		<< "  --frames <n>    Stop each ROM after n 60Hz frames (Default " << k_DefaultFrameLimit << " if no limit is given)" << std::endl
+		<< "  --ipf <n>       Instructions per frame (Default " << k_DefaultInstructionsPerFrame << ")" << std::endl
+		<< "  --vip-timing    Run each frame for the machine cycles the COSMAC VIP had, with each instruction costing what it did on the VIP, instead of --ipf" << std::endl
+		<< "  --seed <n>      Seed for the random number instruction (Default 0)" << std::endl
+		<< "  --quirks <name> Quirk profile: vip, chip48, schip, modern, or auto to pick one per ROM from the instructions it uses (Default auto)" << std::endl
+		<< "  --input <file>  Input script. Each line is '<frame> <key> down|up', with the key in hex" << std::endl
+		<< "  --threads <n>   Number of ROMs to run at once (Default one per core)" << std::endl
+		<< "  --no-idle-skip  Execute every instruction of idle loops instead of skipping to the next timer tick or key press" << std::endl
+		<< "  --fusion        Run each ROM with and without instruction fusion, and report how often it applied and the speedup" << std::endl
+		<< "  --checked       Run each ROM without and with memory checks, stopping on out of range memory or stack access, and report what the checks cost" << std::endl
+		<< "  --wav <folder>  Write each ROM's audio to a WAV file (" << Beeper::k_DefaultSampleRate << "Hz mono) named after the ROM in this folder" << std::endl
+		<< "  --pack <file>   Pack the ROM files into a bundle (" << RomBundle::k_FileExtension << ") instead of running them" << std::endl
+		<< "  --bench-scroll  Benchmark the SCHIP scroll instructions against a byte-per-pixel framebuffer" << std::endl;
+}
+
+bool HeadlessRunner::AddRomPath(const std::filesystem::path& path)
+{
+	std::error_code error;
+
+	if (std::filesystem::is_directory(path, error))
+	{
+		std::vector<std::filesystem::path> directoryRoms;
+
+		for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(path, error))
+		{
+			if (!entry.is_regular_file(error))
+				continue;
+
+			std::string extension = entry.path().extension().string();
+			std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+
+			for (const char* romExtension : k_RomExtensions)
+			{
+				if (extension == romExtension)
+				{
+					directoryRoms.push_back(entry.path());
+					break;
+				}
+			}
+		}
+
+		// Directory order isn't defined, so sort to keep the table the same between runs
+		std::sort(directoryRoms.begin(), directoryRoms.end());
+
+		for (const std::filesystem::path& romPath : directoryRoms)
+		{
+			m_Roms.push_back({ romPath.filename().u8string(), romPath });
+		}
+
+		return true;
+	}
+
+	if (std::filesystem::is_regular_file(path, error))
+	{
+		if (path.extension() != RomBundle::k_FileExtension)
+		{
+			m_Roms.push_back({ path.filename().u8string(), path });
+			return true;
+		}
+
+		std::unique_ptr<RomBundle> bundle = std::make_unique<RomBundle>();
+
+		if (!bundle->Open(path))
+			return false;
+
+		const std::string bundleName = path.filename().u8string();
+
+		for (size_t i = 0; i < bundle->RomCount(); i++)
+		{
+			const RomBundle::RomView rom = bundle->GetRom(i);
+
+			m_Roms.push_back({ bundleName + ":" + std::string(rom.Name, rom.NameLength), path, bundle.get(), i });
+		}
+
+		m_Bundles.push_back(std::move(bundle));
+		return true;
+	}
+
+	std::cout << "ERROR: '" << path.u8string() << "' is not a ROM or directory" << std::endl;
+	return false;
+}
+
+bool HeadlessRunner::LoadInputScript(const std::filesystem::path& path)
+{
+	std::ifstream scriptFile(path);
+
+	if (!scriptFile.is_open())
+	{
+		std::cout << "ERROR: Failed to open input script '" << path.u8string() << "'" << std::endl;
+		return false;
+	}
+
+	std::string line;
+	int lineNumber = 0;
+
+	while (std::getline(scriptFile, line))
+	{
+		lineNumber++;
+
+		std::istringstream lineStream(line);
+
+		uint32_t frame;
+		uint32_t key;
+		std::string action;
+
+		if (!(lineStream >> frame))
+		{
+			// Blank lines and comments
+			lineStream.clear();
+
+			std::string firstWord;
+
+			if (!(lineStream >> firstWord) || firstWord[0] == '#')
+				continue;
+
+			std::cout << "ERROR: Input script line " << lineNumber << " should start with a frame number" << std::endl;
+			return false;
+		}
+
+		if (!(lineStream >> std::hex >> key >> action) || key > 0xF || (action != "down" && action != "up"))
+		{
+			std::cout << "ERROR: Input script line " << lineNumber << " should be '<frame> <key> down|up'" << std::endl;
+			return false;
+		}
+
+		m_InputScript.push_back({ frame, static_cast<uint8_t>(key), action == "down" });
+	}
+
+	// Stable so events on the same frame are applied in the order they're written
+	std::stable_sort(m_InputScript.begin(), m_InputScript.end(), [](const ScriptedKeyEvent& a, const ScriptedKeyEvent& b) { return a.Frame < b.Frame; });
+
+	return true;
+}
+
+int HeadlessRunner::Run()
+{
+	if (m_bShowUsage)
+	{
+		PrintUsage();
+		return 0;
+	}
+
+	if (m_bBenchmarkScrolls)
+		return BenchmarkScrolls();
+
+	if (!m_PackPath.empty())
+	{
+		std::vector<std::filesystem::path> romPaths;
+
+		for (const RomSource& rom : m_Roms)
+		{
+			if (rom.Bundle != nullptr)
+			{
+				std::cout << "ERROR: ROMs can't be packed from another bundle" << std::endl;
+				return 1;
+			}
+
+			romPaths.push_back(rom.Path);
+		}
+
+		if (!RomBundle::Build(m_PackPath, romPaths))
+			return 1;
+
+		std::cout << "Packed " << romPaths.size() << " ROM file(s) into '" << m_PackPath.u8string() << "'" << std::endl;
+		return 0;
+	}
+
+	std::vector<RomResult> results(m_Roms.size());
+
+	for (size_t i = 0; i < m_Roms.size(); i++)
+	{
+		results[i].Source = m_Roms[i];
+	}
+
+	unsigned int threadCount = m_ThreadCount != 0 ? m_ThreadCount : std::max(1u, std::thread::hardware_concurrency());
+	threadCount = static_cast<unsigned int>(std::min<size_t>(threadCount, results.size()));
+
+	// ROMs can take very different amounts of time to stop, so each thread takes the next one as it finishes rather than a fixed share
+	std::atomic<size_t> nextRom(0);
+
+	auto worker = [this, &results, &nextRom]()
+	{
+		CPU cpu;
+
+		for (size_t i = nextRom++; i < results.size(); i = nextRom++)
+		{
+			if (m_bIsFusionEnabled)
+			{
+				// The run without fusion gives the baseline time, and the state fusion has to match
+				RomResult unfused;
+				unfused.Source = results[i].Source;
+
+				RunRom(unfused, cpu, false, false);
+				RunRom(results[i], cpu, true, false);
+
+				results[i].UnfusedRunTime = unfused.RunTime;
+				results[i].bFusionMismatch = unfused.StateHash != results[i].StateHash || unfused.Instructions != results[i].Instructions;
+			}
+			else if (m_bIsMemoryCheckEnabled)
+			{
+				// The unchecked run gives the baseline time. The states only differ if the checked run stopped on a bad access.
+				RomResult unchecked;
+				unchecked.Source = results[i].Source;
+
+				RunRom(unchecked, cpu, false, false);
+				RunRom(results[i], cpu, false, true);
+
+				results[i].UncheckedRunTime = unchecked.RunTime;
+			}
+			else
+			{
+				RunRom(results[i], cpu, false, false);
+			}
+		}
+	};
+
+	const auto startTime = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> threads;
+
+	for (unsigned int i = 1; i < threadCount; i++)
+	{
+		threads.emplace_back(worker);
+	}
+
+	worker();
+
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	const double wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	PrintResults(results, threadCount, wallTime);
+
+	for (const RomResult& result : results)
+	{
+		if (result.StopReason == RunStopReason::FailedToLoad || result.bFusionMismatch)
+			return 1;
+	}
+
+	return 0;
+}
+
+int HeadlessRunner::BenchmarkScrolls()
+{
+	constexpr int k_Iterations = 200000;
+
+	// Each iteration scrolls down 1 row, right, left and right again. The screen is refilled every few iterations, before everything has scrolled off it.
+	constexpr int k_ScrollsPerIteration = 4;
+	constexpr int k_RefillInterval = 8;
+
+	constexpr int k_Width = ChipState::k_DisplayWidth;
+	constexpr int k_Height = ChipState::k_DisplayHeight;
+
+	CPU cpu;
+	cpu.Init();
+	cpu.SetLoggingEnabled(false);
+
+	ChipState* state = cpu.m_CpuState;
+	state->bIsHighResolution = true;
+
+	// Random starting screen, in both layouts
+	uint64_t packedScreen[k_Height][2];
+	static uint8_t byteScreen[k_Height][k_Width];
+	static uint8_t byteDisplay[k_Height][k_Width];
+
+	uint32_t random = 0x2545F491;
+
+	for (int y = 0; y < k_Height; y++)
+	{
+		for (int word = 0; word < 2; word++)
+		{
+			random ^= random << 13;
+			random ^= random >> 17;
+			random ^= random << 5;
+			const uint64_t high = random;
+
+			random ^= random << 13;
+			random ^= random >> 17;
+			random ^= random << 5;
+
+			packedScreen[y][word] = high << 32 | random;
+		}
+
+		for (int x = 0; x < k_Width; x++)
+		{
+			byteScreen[y][x] = (packedScreen[y][x >> 6] >> (63 - (x & 63))) & 1;
+		}
+	}
+
+	auto startTime = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < k_Iterations; i++)
+	{
+		if (i % k_RefillInterval == 0)
+			memcpy(state->VideoMemory[0], packedScreen, sizeof(packedScreen));
+
+		cpu.ScrollVertical(1);
+		cpu.ScrollHorizontal(false);
+		cpu.ScrollHorizontal(true);
+		cpu.ScrollHorizontal(false);
+	}
+
+	const double packedTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	// The straightforward version: a row-by-row move for scrolling down, and every pixel copied one at a time for scrolling sideways
+	auto scrollBytesDown = [](int rows)
+	{
+		memmove(byteDisplay[rows], byteDisplay[0], (k_Height - rows) * sizeof(byteDisplay[0]));
+		memset(byteDisplay[0], 0, rows * sizeof(byteDisplay[0]));
+	};
+
+	auto scrollBytesHorizontal = [](bool bIsLeft)
+	{
+		for (int y = 0; y < k_Height; y++)
+		{
+			if (bIsLeft)
+			{
+				for (int x = 0; x < k_Width; x++)
+				{
+					byteDisplay[y][x] = x + 4 < k_Width ? byteDisplay[y][x + 4] : 0;
+				}
+			}
+			else
+			{
+				for (int x = k_Width - 1; x >= 0; x--)
+				{
+					byteDisplay[y][x] = x >= 4 ? byteDisplay[y][x - 4] : 0;
+				}
+			}
+		}
+	};
+
+	startTime = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < k_Iterations; i++)
+	{
+		if (i % k_RefillInterval == 0)
+			memcpy(byteDisplay, byteScreen, sizeof(byteScreen));
+
+		scrollBytesDown(1);
+		scrollBytesHorizontal(false);
+		scrollBytesHorizontal(true);
+		scrollBytesHorizontal(false);
+	}
+
+	const double byteTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	bool bIsMatch = true;
+
+	for (int y = 0; y < k_Height; y++)
+	{
+		for (int x = 0; x < k_Width; x++)
+		{
+			bIsMatch &= state->IsPixelSet(0, x, y) == (byteDisplay[y][x] != 0);
+		}
+	}
+
+	const double scrollCount = static_cast<double>(k_Iterations) * k_ScrollsPerIteration;
+
+#ifdef CHIP8_USE_SSE2
+	const char* packedName = "Packed (SSE2)";
+#else
+	const char* packedName = "Packed";
+#endif // CHIP8_USE_SSE2
+
+	std::cout << "Scroll benchmark: " << k_Width << "x" << k_Height << ", " << static_cast<uint64_t>(scrollCount) << " scrolls each" << std::endl
+		<< std::fixed << std::setprecision(1)
+		<< "  " << std::left << std::setw(16) << packedName << std::right << std::setw(10) << packedTime * 1e9 / scrollCount << " ns/scroll" << std::endl
+		<< "  " << std::left << std::setw(16) << "Byte per pixel" << std::right << std::setw(10) << byteTime * 1e9 / scrollCount << " ns/scroll" << std::endl
+		<< "  " << std::left << std::setw(16) << "Speedup" << std::right << std::setw(10) << std::setprecision(2) << (packedTime > 0.0 ? byteTime / packedTime : 0.0) << "x" << std::endl
+		<< "  " << std::left << std::setw(16) << "Screens match" << std::right << std::setw(10) << (bIsMatch ? "Yes" : "No") << std::endl;
+
+	return bIsMatch ? 0 : 1;
+}
+
+void HeadlessRunner::RunRom(RomResult& result, CPU& cpu, bool bIsFusionEnabled, bool bIsMemoryCheckEnabled) const
+{
+	cpu.Init();
+	cpu.SetLoggingEnabled(false);
+	cpu.SetSeed(m_Seed);
+
+	std::vector<uint8_t> romFileData;
+
+	const uint8_t* romData = nullptr;
+	size_t romSize = 0;
+
+	if (result.Source.Bundle != nullptr)
+	{
+		// Copied straight from the mapped bundle into program memory
+		const RomBundle::RomView rom = result.Source.Bundle->GetRom(result.Source.BundleIndex);
+
+		romData = rom.Data;
+		romSize = rom.Size;
+	}
+	else
+	{
+		std::ifstream romFile(result.Source.Path, std::ios::binary);
+
+		if (!romFile.is_open())
+			return;
+
+		romFileData.assign(std::istreambuf_iterator<char>(romFile), std::istreambuf_iterator<char>());
+
+		romData = romFileData.data();
+		romSize = romFileData.size();
+	}
+
+	result.Quirks = m_bAutoQuirks ? RomLibrary::DefaultQuirkProfile(RomLibrary::DetectPlatform(romData, romSize)) : m_QuirkProfile;
+
+	cpu.SetQuirkProfile(result.Quirks);
+	cpu.SetIdleSkipEnabled(m_bIsIdleSkipEnabled);
+	cpu.SetFusionEnabled(bIsFusionEnabled);
+	cpu.SetMemoryChecksEnabled(bIsMemoryCheckEnabled);
+
+	if (!cpu.LoadProgram(romData, romSize))
+		return;
+
+	const ChipState* state = cpu.GetState();
+
+	Beeper beeper;
+	WavWriter wavWriter;
+	std::vector<int16_t> samples;
+
+	if (!m_WavPath.empty() && !bIsFusionEnabled && !bIsMemoryCheckEnabled)
+	{
+		// Bundle entries are named '<bundle>:<rom>', which isn't a valid file name on Windows
+		std::string wavName = result.Source.Name;
+		std::replace_if(wavName.begin(), wavName.end(), [](char c) { return c == ':' || c == '/' || c == '\\'; }, '_');
+
+		wavWriter.Open(m_WavPath / std::filesystem::u8path(wavName + ".wav"), beeper.SampleRate());
+	}
+
+	// Ticks the timers for a number of frames, rendering the audio for them first if it's being written
+	auto tickTimers = [&](uint32_t frameCount)
+	{
+		while (frameCount > 0)
+		{
+			// Rendered a chunk at a time, so skipping a long idle stretch doesn't build up a huge buffer
+			const uint32_t chunkFrames = wavWriter.IsOpen() ? std::min(frameCount, k_AudioChunkFrames) : frameCount;
+
+			if (wavWriter.IsOpen())
+			{
+				samples.clear();
+				beeper.RenderFrames(state, chunkFrames, samples);
+
+				wavWriter.Write(samples.data(), samples.size());
+			}
+
+			cpu.TickTimers(chunkFrames);
+			frameCount -= chunkFrames;
+		}
+	};
+
+	const auto startTime = std::chrono::steady_clock::now();
+
+	size_t nextKeyEvent = 0;
+	uint16_t keyMask = 0;
+
+	result.StopReason = RunStopReason::FrameLimit;
+
+	while (m_FrameLimit == 0 || result.Frames < m_FrameLimit)
+	{
+		while (nextKeyEvent < m_InputScript.size() && m_InputScript[nextKeyEvent].Frame <= result.Frames)
+		{
+			const ScriptedKeyEvent& keyEvent = m_InputScript[nextKeyEvent++];
+
+			if (keyEvent.bIsPressed)
+				keyMask |= 1 << keyEvent.Key;
+			else
+				keyMask &= ~(1 << keyEvent.Key);
+		}
+
+		cpu.SetKeyMask(keyMask);
+
+		if (m_bIsVipTimingEnabled)
+		{
+			// The last frame can go past the cycle limit, as frames aren't a fixed number of instructions
+			result.Instructions += cpu.RunMachineCycles(CPU::k_VipInterpreterCyclesPerFrame);
+		}
+		else
+		{
+			uint32_t instructions = m_InstructionsPerFrame;
+
+			if (m_CycleLimit != 0)
+			{
+				instructions = static_cast<uint32_t>(std::min<uint64_t>(instructions, m_CycleLimit - result.Instructions));
+			}
+
+			result.Instructions += cpu.RunCycles(instructions);
+		}
+
+		tickTimers(1);
+		result.Frames++;
+
+		if (state->bIsStopped)
+		{
+			switch (state->StopReason)
+			{
+				case CpuStopReason::UnknownOpCode: result.StopReason = RunStopReason::UnknownOpCode; break;
+				case CpuStopReason::MachineCodeRunaway: result.StopReason = RunStopReason::MachineCodeRunaway; break;
+				case CpuStopReason::MemoryOutOfRange: result.StopReason = RunStopReason::MemoryOutOfRange; break;
+				case CpuStopReason::StackOverflow: result.StopReason = RunStopReason::StackOverflow; break;
+				case CpuStopReason::StackUnderflow: result.StopReason = RunStopReason::StackUnderflow; break;
+				case CpuStopReason::KeyOutOfRange: result.StopReason = RunStopReason::KeyOutOfRange; break;
+				case CpuStopReason::Exited: result.StopReason = RunStopReason::Exited; break;
+				default: result.StopReason = RunStopReason::CpuStopped; break;
+			}
+
+			result.StopOpCode = state->StopOpCode;
+			result.FaultAddress = state->FaultAddress;
+			break;
+		}
+
+		// Nothing else will happen if the ROM is blocked on 0xFx0A and the script has no more key presses to give it
+		if (state->bIsWaitingForKeyPress && nextKeyEvent == m_InputScript.size())
+		{
+			result.StopReason = RunStopReason::WaitingForKey;
+			break;
+		}
+
+		if (m_CycleLimit != 0 && result.Instructions >= m_CycleLimit)
+		{
+			result.StopReason = RunStopReason::CycleLimit;
+			break;
+		}
+
+		// A ROM that's jumped to itself or is waiting for a key can't change anything but its timers until the next scripted key event,
+		// so skip whole frames up to the one before that (Or before a limit is reached) and let it run normally from there.
+		// With COSMAC VIP timing the instructions in a frame depend on where the CPU's cycle balance is, so it's left to skip within each frame instead.
+		if (m_bIsIdleSkipEnabled && !m_bIsVipTimingEnabled && (cpu.IsHalted() || state->bIsWaitingForKeyPress))
+		{
+			uint64_t idleFrames = std::numeric_limits<uint64_t>::max();
+
+			if (m_FrameLimit != 0)
+				idleFrames = m_FrameLimit - result.Frames;
+
+			if (m_CycleLimit != 0)
+				idleFrames = std::min(idleFrames, (m_CycleLimit - result.Instructions) / m_InstructionsPerFrame);
+
+			if (nextKeyEvent < m_InputScript.size())
+				idleFrames = std::min<uint64_t>(idleFrames, m_InputScript[nextKeyEvent].Frame - result.Frames);
+
+			if (idleFrames > 1)
+			{
+				const uint32_t skippedFrames = static_cast<uint32_t>(std::min<uint64_t>(idleFrames - 1, std::numeric_limits<uint32_t>::max()));
+
+				tickTimers(skippedFrames);
+
+				result.Frames += skippedFrames;
+				result.Instructions += static_cast<uint64_t>(skippedFrames) * m_InstructionsPerFrame;
+				result.IdleInstructions += static_cast<uint64_t>(skippedFrames) * m_InstructionsPerFrame;
+			}
+		}
+	}
+
+	result.IdleInstructions += cpu.GetIdleInstructionsSkipped();
+	result.FusedInstructions = cpu.GetFusedInstructions();
+
+	result.RunTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	result.StateHash = HashState(state, cpu.m_MemoryExtent);
+
+	if (wavWriter.IsOpen() && !wavWriter.Close())
+		std::cout << "ERROR: Failed to write the audio for '" << result.Source.Name << "'" << std::endl;
+}
+
+void HeadlessRunner::PrintResults(const std::vector<RomResult>& results, unsigned int threadCount, double wallTime) const
+{
+	size_t nameWidth = 3;
+
+	for (const RomResult& result : results)
+	{
+		nameWidth = std::max(nameWidth, result.Source.Name.size());
+	}
+
+	std::cout << std::left << std::setw(nameWidth) << "ROM" << "  "
+		<< std::setw(16) << "State Hash" << "  "
+		<< std::right << std::setw(12) << "Instructions" << "  "
+		<< std::setw(8) << "Frames" << "  "
+		<< std::left << std::setw(24) << "Stop Reason" << "  "
+		<< std::setw(10) << "Quirks" << "  "
+		<< std::right << std::setw(7) << "Idle %" << "  "
+		<< std::setw(10) << "MIPS";
+
+	if (m_bIsFusionEnabled)
+		std::cout << "  " << std::setw(7) << "Fused %" << "  " << std::setw(8) << "Speedup";
+
+	if (m_bIsMemoryCheckEnabled)
+		std::cout << "  " << std::setw(10) << "Check Cost";
+
+	if (m_bIsVipTimingEnabled)
+		std::cout << "  " << std::setw(8) << "Avg IPF" << "  " << std::setw(9) << "Realtime";
+
+	std::cout << std::endl;
+
+	uint64_t totalInstructions = 0;
+	uint64_t totalIdleInstructions = 0;
+	uint64_t totalFusedInstructions = 0;
+	double totalUnfusedRunTime = 0.0;
+	double totalUncheckedRunTime = 0.0;
+	double totalRunTime = 0.0;
+
+	for (const RomResult& result : results)
+	{
+		std::cout << std::left << std::setw(nameWidth) << result.Source.Name << "  ";
+
+		if (result.StopReason == RunStopReason::FailedToLoad)
+		{
+			std::cout << StopReasonName(result) << std::endl;
+			continue;
+		}
+
+		const double mips = result.RunTime > 0.0 ? result.Instructions / result.RunTime / 1000000.0 : 0.0;
+		const double idlePercent = result.Instructions > 0 ? 100.0 * result.IdleInstructions / result.Instructions : 0.0;
+
+		std::cout << std::right << std::hex << std::setfill('0') << std::setw(16) << result.StateHash << std::dec << std::setfill(' ') << "  "
+			<< std::setw(12) << result.Instructions << "  "
+			<< std::setw(8) << result.Frames << "  "
+			<< std::left << std::setw(24) << StopReasonName(result) << "  "
+			<< std::setw(10) << QuirkProfileName(result.Quirks) << "  "
+			<< std::right << std::fixed << std::setprecision(1) << std::setw(7) << idlePercent << "  "
+			<< std::setw(10) << std::setprecision(2) << mips;
+
+		if (m_bIsFusionEnabled)
+		{
+			const double fusedPercent = result.Instructions > 0 ? 100.0 * result.FusedInstructions / result.Instructions : 0.0;
+
+			std::cout << "  " << std::setw(7) << std::setprecision(1) << fusedPercent << "  ";
+
+			if (result.bFusionMismatch)
+				std::cout << "MISMATCH";
+			else
+				std::cout << std::setw(7) << std::setprecision(2) << (result.RunTime > 0.0 ? result.UnfusedRunTime / result.RunTime : 0.0) << "x";
+		}
+
+		if (m_bIsMemoryCheckEnabled)
+			std::cout << "  " << std::setw(9) << std::setprecision(2) << (result.UncheckedRunTime > 0.0 ? result.RunTime / result.UncheckedRunTime : 0.0) << "x";
+
+		if (m_bIsVipTimingEnabled)
+		{
+			// How fast the ROM ran on the VIP, and how many times faster than the VIP it was emulated
+			const double averageIpf = result.Frames > 0 ? static_cast<double>(result.Instructions) / result.Frames : 0.0;
+			const double realtime = result.RunTime > 0.0 ? result.Frames / 60.0 / result.RunTime : 0.0;
+
+			std::cout << "  " << std::setw(8) << std::setprecision(1) << averageIpf << "  " << std::setw(8) << std::setprecision(0) << realtime << "x";
+		}
+
+		std::cout << std::endl;
+
+		totalInstructions += result.Instructions;
+		totalIdleInstructions += result.IdleInstructions;
+		totalFusedInstructions += result.FusedInstructions;
+		totalUnfusedRunTime += result.UnfusedRunTime;
+		totalUncheckedRunTime += result.UncheckedRunTime;
+		totalRunTime += result.RunTime;
+	}
+
+	const double totalMips = wallTime > 0.0 ? totalInstructions / wallTime / 1000000.0 : 0.0;
+
+	std::cout << std::endl
+		<< results.size() << " ROM(s), " << totalInstructions << " instructions in " << std::setprecision(3) << wallTime << "s on "
+		<< threadCount << " thread(s) (" << std::setprecision(2) << totalMips << " MIPS overall, "
+		<< std::setprecision(3) << totalRunTime << "s of emulation, " << std::setprecision(1)
+		<< (totalInstructions > 0 ? 100.0 * totalIdleInstructions / totalInstructions : 0.0) << "% skipped as idle)" << std::endl;
+
+	if (m_bIsFusionEnabled)
+	{
+		std::cout << "Fusion: " << std::setprecision(1) << (totalInstructions > 0 ? 100.0 * totalFusedInstructions / totalInstructions : 0.0)
+			<< "% of instructions fused, " << std::setprecision(2) << (totalRunTime > 0.0 ? totalUnfusedRunTime / totalRunTime : 0.0)
+			<< "x speedup over running unfused" << std::endl;
+	}
+
+	if (m_bIsMemoryCheckEnabled)
+	{
+		std::cout << "Memory checks: " << std::setprecision(2) << (totalUncheckedRunTime > 0.0 ? totalRunTime / totalUncheckedRunTime : 0.0)
+			<< "x the time of running unchecked (" << std::setprecision(3) << totalUncheckedRunTime << "s unchecked)" << std::endl;
+	}
+}
+
+uint64_t HeadlessRunner::HashState(const ChipState* state, size_t memoryExtent)
+{
+	// FNV-1a. Each field is hashed separately so padding between them doesn't affect the result.
+	uint64_t hash = 14695981039346656037ull;
+
+	auto hashBytes = [&hash](const void* data, size_t size)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+		for (size_t i = 0; i < size; i++)
+		{
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+		}
+	};
+
+	hashBytes(state->V, sizeof(state->V));
+	hashBytes(&state->I, sizeof(state->I));
+	hashBytes(&state->PC, sizeof(state->PC));
+	hashBytes(&state->SP, sizeof(state->SP));
+	hashBytes(state->Stack, sizeof(state->Stack));
+	hashBytes(&state->Delay, sizeof(state->Delay));
+	hashBytes(&state->Sound, sizeof(state->Sound));
+	// Trailing zeros are left out, so the hash only depends on what's in memory and not on how much of it might have been written
+	size_t memorySize = std::min(memoryExtent, sizeof(state->Memory));
+
+	while (memorySize > 0 && state->Memory[memorySize - 1] == 0)
+	{
+		memorySize--;
+	}
+
+	hashBytes(state->Memory, memorySize);
+	hashBytes(state->VideoMemory, sizeof(state->VideoMemory));
+	hashBytes(&state->bIsHighResolution, sizeof(state->bIsHighResolution));
+	hashBytes(state->FlagRegisters, sizeof(state->FlagRegisters));
+	hashBytes(&state->SelectedPlanes, sizeof(state->SelectedPlanes));
+	hashBytes(state->AudioPattern, sizeof(state->AudioPattern));
+	hashBytes(&state->bHasAudioPattern, sizeof(state->bHasAudioPattern));
+	hashBytes(&state->Pitch, sizeof(state->Pitch));
+
+	return hash;
+}
+
+std::string HeadlessRunner::StopReasonName(const RomResult& result)
+{
+	switch (result.StopReason)
+	{
+		case RunStopReason::FailedToLoad: return "Failed to load";
+		case RunStopReason::CpuStopped: return "CPU stopped";
+		case RunStopReason::Exited: return "Exited";
+		case RunStopReason::WaitingForKey: return "Waiting for key";
+		case RunStopReason::StackOverflow: return "Stack overflow";
+		case RunStopReason::StackUnderflow: return "Stack underflow";
+		case RunStopReason::MemoryOutOfRange:
+		case RunStopReason::KeyOutOfRange:
+		{
+			std::ostringstream name;
+
+			if (result.StopReason == RunStopReason::MemoryOutOfRange)
+				name << "Out of range 0x" << std::hex << std::uppercase << std::setw(4) << std::setfill('0') << result.FaultAddress;
+			else
+				name << "Key out of range 0x" << std::hex << std::uppercase << std::setw(2) << std::setfill('0') << result.FaultAddress;
+
+			return name.str();
+		}
+		case RunStopReason::CycleLimit: return "Cycle limit";
+		case RunStopReason::FrameLimit: return "Frame limit";
+		case RunStopReason::UnknownOpCode:
+		case RunStopReason::MachineCodeRunaway:
+		{
+			std::ostringstream name;
+			name << (result.StopReason == RunStopReason::UnknownOpCode ? "Unknown OpCode 0x" : "Runaway routine 0x")
+				<< std::hex << std::uppercase << std::setw(4) << std::setfill('0') << result.StopOpCode;
+
+			return name.str();
+		}
+	}
+
+	return "";
+}
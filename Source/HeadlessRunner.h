@@ -0,0 +1,233 @@
+#pragma once
+
+#include "EmulatorCommon.h"
+
+#include "Beeper.h"
+#include "CPU.h"
+#include "RomBundle.h"
+#include "RomLibrary.h"
+
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+/*
+* Runs ROMs from the command line without a window.
+*
+* Each ROM is emulated in 60Hz frames (A fixed number of instructions followed by a timer tick) until it stops, waits for a key press that
+* the input script will never send, or reaches the cycle/frame limit. ROMs are spread across one worker thread per core and the results are
+* printed as a table once they've all finished, so batches of ROMs can be compared between builds by their final state hashes.
+*
+* ROMs can be individual files or packed into a 'RomBundle', which is much quicker to load for large collections.
+*/
+class HeadlessRunner
+{
+public:
+	/// <summary>
+	/// Reads the command line options and collects the ROMs to run
+	/// </summary>
+	/// <param name="argc">Number of command line arguments</param>
+	/// <param name="args">Command line arguments (UTF-8), including the program name</param>
+	/// <returns>True if the options were valid and there's at least one ROM to run. Otherwise false</returns>
+	bool ParseArguments(int argc, char* args[]);
+
+	/// <summary>
+	/// Runs every ROM and prints the results (Or packs them into a bundle, or runs the scroll benchmark, if those were asked for)
+	/// </summary>
+	/// <returns>Process exit code: 0 if every ROM was loaded and run, otherwise 1. With --fusion, a ROM whose fused and unfused runs
+	/// didn't match also returns 1. So does a bundle that couldn't be packed, and the scroll benchmark returns its own result.</returns>
+	int Run();
+
+	/// <summary>
+	/// Prints the command line options to the console
+	/// </summary>
+	static void PrintUsage();
+
+	/// <summary>
+	/// Times the SCHIP scroll instructions on the packed Video RAM against a byte-per-pixel framebuffer scrolled pixel by pixel, and checks both end up with the same screen
+	/// </summary>
+	/// <returns>Process exit code: 0 if the results matched, otherwise 1</returns>
+	static int BenchmarkScrolls();
+
+private:
+	// Why a ROM stopped running
+	enum class RunStopReason
+	{
+		FailedToLoad,
+		UnknownOpCode,
+		MachineCodeRunaway,
+		MemoryOutOfRange,
+		StackOverflow,
+		StackUnderflow,
+		KeyOutOfRange,
+		CpuStopped,
+		Exited,
+		WaitingForKey,
+		CycleLimit,
+		FrameLimit
+	};
+
+	// Key press or release from the input script
+	struct ScriptedKeyEvent
+	{
+		// Frame (Counting from 0) the key changes state at the start of
+		uint32_t Frame;
+
+		// CHIP-8 key (0x0 - 0xF)
+		uint8_t Key;
+
+		bool bIsPressed;
+	};
+
+	// Where to load a ROM from: either a file, or an entry in one of the open bundles
+	struct RomSource
+	{
+		// Shown in the results table
+		std::string Name;
+
+		std::filesystem::path Path;
+
+		const RomBundle* Bundle = nullptr;
+		size_t BundleIndex = 0;
+	};
+
+	struct RomResult
+	{
+		RomSource Source;
+
+		// Hash of the registers, stack, timers, memory and video memory when the ROM stopped running
+		uint64_t StateHash = 0;
+
+		uint64_t Instructions = 0;
+		uint32_t Frames = 0;
+
+		// Instructions (Included in the total) that were skipped over rather than executed, as the ROM was idling
+		uint64_t IdleInstructions = 0;
+
+		// Instructions executed as part of a fused sequence
+		uint64_t FusedInstructions = 0;
+
+		RunStopReason StopReason = RunStopReason::FailedToLoad;
+
+		// Quirks the ROM was run with
+		QuirkProfile Quirks = QuirkProfile::CosmacVip;
+
+		// OpCode the CPU stopped on, if it didn't recognise it
+		uint16_t StopOpCode = 0;
+
+		// First address out of range, if the ROM stopped on an out of range memory access
+		uint32_t FaultAddress = 0;
+
+		// Time spent emulating the ROM, in seconds
+		double RunTime = 0.0;
+
+		// Time spent emulating the ROM without fusion, when comparing against it
+		double UnfusedRunTime = 0.0;
+
+		// Set if the ROM finished in a different state with fusion than without it
+		bool bFusionMismatch = false;
+
+		// Time spent emulating the ROM without memory checks, when comparing against them
+		double UncheckedRunTime = 0.0;
+	};
+
+private:
+	/// <summary>
+	/// Adds a ROM path, every ROM in a bundle, or every ROM in a directory, to the list of ROMs to run
+	/// </summary>
+	/// <returns>True if the path exists. Otherwise false</returns>
+	bool AddRomPath(const std::filesystem::path& path);
+
+	/// <summary>
+	/// Loads key presses and releases from the input script. Each line is a frame number, a key (In hex) and 'down' or 'up', e.g. '120 5 down'. Lines starting with '#' are ignored.
+	/// </summary>
+	/// <returns>True if the script was loaded. Otherwise false</returns>
+	bool LoadInputScript(const std::filesystem::path& path);
+
+	/// <summary>
+	/// Emulates a single ROM until it stops or reaches a limit
+	/// </summary>
+	/// <param name="result">Has the ROM source on input. Receives the results of the run.</param>
+	/// <param name="cpu">CPU to run the ROM on. It's re-initialised first, so one CPU can be reused for every ROM a thread runs.</param>
+	/// <param name="bIsFusionEnabled">True to execute common instruction sequences with fused handlers. The ROM's audio is only written on runs without fusion
+	/// or memory checks, so it's written once when comparing.</param>
+	/// <param name="bIsMemoryCheckEnabled">True to check every memory and stack access, stopping the ROM on the first one out of range</param>
+	void RunRom(RomResult& result, CPU& cpu, bool bIsFusionEnabled, bool bIsMemoryCheckEnabled) const;
+
+	/// <summary>
+	/// Prints the results of every ROM as a table, followed by the totals
+	/// </summary>
+	void PrintResults(const std::vector<RomResult>& results, unsigned int threadCount, double wallTime) const;
+
+	/// <summary>
+	/// Hashes everything in the CPU state that a ROM can change (Registers, stack, timers, memory, video memory, SCHIP flags and XO-CHIP state)
+	/// </summary>
+	/// <param name="state">State to hash</param>
+	/// <param name="memoryExtent">Size of the part of memory that might not be zero. Everything past it is known to be zero, so isn't read.</param>
+	static uint64_t HashState(const ChipState* state, size_t memoryExtent);
+
+	/// <summary>
+	/// Gets the name of a stop reason as shown in the results table
+	/// </summary>
+	static std::string StopReasonName(const RomResult& result);
+
+private:
+	// Frames run when neither a cycle nor a frame limit is given (One minute of emulated time)
+	static constexpr uint32_t k_DefaultFrameLimit = 3600;
+
+	// Matches the emulator's 'k_InstructionsPerFrame'
+	static constexpr uint32_t k_DefaultInstructionsPerFrame = 10;
+
+	// Most frames of audio rendered at once when skipping idle frames (10 seconds)
+	static constexpr uint32_t k_AudioChunkFrames = 600;
+
+	// Extensions of the files picked up when a directory is passed in
+	const char* k_RomExtensions[5] = { ".ch8", ".c8", ".sc8", ".xo8", ".bin" };
+
+	std::vector<RomSource> m_Roms;
+
+	// Bundles stay mapped until every ROM has run, as their ROMs are loaded straight from the mapping
+	std::vector<std::unique_ptr<RomBundle>> m_Bundles;
+
+	// If set, the ROM files are packed into a bundle at this path instead of being run
+	std::filesystem::path m_PackPath;
+
+	// If set, each ROM's audio is written to a WAV file named after it in this folder
+	std::filesystem::path m_WavPath;
+
+	// Sorted by frame
+	std::vector<ScriptedKeyEvent> m_InputScript;
+
+	// Limits for each ROM. Zero means no limit.
+	uint64_t m_CycleLimit = 0;
+	uint32_t m_FrameLimit = 0;
+
+	uint32_t m_InstructionsPerFrame = k_DefaultInstructionsPerFrame;
+
+	uint32_t m_Seed = 0;
+
+	// Quirks every ROM is run with, unless they're picked for each ROM from the platform it appears to be written for
+	bool m_bAutoQuirks = true;
+	QuirkProfile m_QuirkProfile = QuirkProfile::CosmacVip;
+
+	// Set to false to execute every instruction, e.g. to check idle skipping doesn't change the state hashes
+	bool m_bIsIdleSkipEnabled = true;
+
+	// If set, each ROM is run both with and without instruction fusion to measure how much it helps
+	bool m_bIsFusionEnabled = false;
+
+	// If set, each ROM is run both without and with memory checks, to find out of range accesses and measure what the checks cost
+	bool m_bIsMemoryCheckEnabled = false;
+
+	// If set, each frame runs for the machine cycles the COSMAC VIP had rather than 'm_InstructionsPerFrame' instructions
+	bool m_bIsVipTimingEnabled = false;
+
+	// Zero uses one thread per core
+	unsigned int m_ThreadCount = 0;
+
+	// Set when the usage was asked for, so Run doesn't do anything else
+	bool m_bShowUsage = false;
+
+	// Set when the scroll benchmark was asked for, so Run doesn't do anything else
+	bool m_bBenchmarkScrolls = false;
+};
@@ -44,7 +44,6 @@ void ImGuiImpl::Destroy()
 void ImGuiImpl::HandleEvent(SDL_Event* sdlEvent)
 {
 	ImGuiIO& io = ImGui::GetIO();
-	io.MouseWheel = 0.0f;
 
 	switch (sdlEvent->type)
 	{
@@ -59,7 +58,7 @@ void ImGuiImpl::HandleEvent(SDL_Event* sdlEvent)
 		}
 		case SDL_MOUSEWHEEL:
 		{
-			io.MouseWheel = static_cast<float>(sdlEvent->wheel.y);
+			m_MouseWheel += static_cast<float>(sdlEvent->wheel.y);
 			break;
 		}
 		case SDL_KEYDOWN:
@@ -103,6 +102,9 @@ void ImGuiImpl::Update(float deltaTime)
 
 	io.DeltaTime = deltaTime;
 
+	io.MouseWheel = m_MouseWheel;
+	m_MouseWheel = 0.0f;
+
 	io.MousePos = ImVec2(static_cast<float>(mouseX), static_cast<float>(mouseY));
 
 	io.MouseDown[0] = buttons & SDL_BUTTON(SDL_BUTTON_LEFT);
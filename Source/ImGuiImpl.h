@@ -42,5 +42,9 @@ public:
 	/// </summary>
 	/// <param name="deltaTime">Time (in seconds) since 'Update()' was last called</param>
 	void Update(float deltaTime);
+
+private:
+	// Mouse wheel movement from every event since the last update
+	float m_MouseWheel = 0.0f;
 };
 
@@ -0,0 +1,72 @@
+#include "InputQueue.h"
+
+#include <algorithm>
+
+void InputQueue::PressKey(uint8_t key, int64_t timestamp)
+{
+	uint16_t keyBit = static_cast<uint16_t>(1 << (key & 0xF));
+
+	if ((m_KeyMask & keyBit) != 0)
+		return;
+
+	m_KeyMask |= keyBit;
+
+	Push(timestamp);
+}
+
+void InputQueue::ReleaseKey(uint8_t key, int64_t timestamp)
+{
+	uint16_t keyBit = static_cast<uint16_t>(1 << (key & 0xF));
+
+	if ((m_KeyMask & keyBit) == 0)
+		return;
+
+	m_KeyMask &= ~keyBit;
+
+	Push(timestamp);
+}
+
+bool InputQueue::PopTransition(int64_t time, uint16_t& keyMask, bool& bIsNewPress)
+{
+	if (m_Count == 0 || bIsNewPress)
+		return false;
+
+	const KeyTransition& transition = m_Transitions[m_Head];
+
+	if (transition.Timestamp > time)
+		return false;
+
+	bIsNewPress = (transition.KeyMask & ~keyMask) != 0;
+	keyMask = transition.KeyMask;
+
+	m_Head = (m_Head + 1) % k_Capacity;
+	m_Count--;
+
+	return true;
+}
+
+void InputQueue::Clear()
+{
+	m_Head = 0;
+	m_Count = 0;
+}
+
+void InputQueue::Push(int64_t timestamp)
+{
+	// Keep the queue in time order even if the host reports events out of order
+	if (m_Count > 0)
+	{
+		const KeyTransition& newest = m_Transitions[(m_Head + m_Count - 1) % k_Capacity];
+
+		timestamp = std::max(timestamp, newest.Timestamp);
+	}
+
+	if (m_Count == k_Capacity)
+	{
+		m_Head = (m_Head + 1) % k_Capacity;
+		m_Count--;
+	}
+
+	m_Transitions[(m_Head + m_Count) % k_Capacity] = KeyTransition{ timestamp, m_KeyMask };
+	m_Count++;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "EmulatorCommon.h"
+
+#include <array>
+
+/*
+* Queue of timestamped changes to the CHIP-8 keypad.
+*
+* Every key transition is recorded with the time it happened and the state of all 16 keys (As a bit mask) after the change.
+* The emulator delivers each change at the instruction matching the time it happened, so taps shorter than a frame still reach the ROM.
+*/
+class InputQueue
+{
+public:
+	// Number of transitions held before the oldest ones are dropped. A dropped transition is only ever superseded, as each one carries the full key mask.
+	static constexpr size_t k_Capacity = 256;
+
+public:
+	/// <summary>
+	/// Records a key being pressed
+	/// </summary>
+	/// <param name="key">CHIP-8 key (0x0 - 0xF)</param>
+	/// <param name="timestamp">Time (From 'Profiler::Now()') the key was pressed</param>
+	void PressKey(uint8_t key, int64_t timestamp);
+
+	/// <summary>
+	/// Records a key being released
+	/// </summary>
+	/// <param name="key">CHIP-8 key (0x0 - 0xF)</param>
+	/// <param name="timestamp">Time (From 'Profiler::Now()') the key was released</param>
+	void ReleaseKey(uint8_t key, int64_t timestamp);
+
+	/// <summary>
+	/// Removes the oldest transition if it happened at or before the specified time.
+	/// Stops at a transition that presses a new key, so a press is always seen by at least one instruction before a following release is delivered.
+	/// </summary>
+	/// <param name="time">Time (From 'Profiler::Now()') up to which transitions are delivered</param>
+	/// <param name="keyMask">Receives the key mask after the transition</param>
+	/// <param name="bIsNewPress">Set to true if the transition pressed a key. Once true, no further transitions are returned until it's reset to false.</param>
+	/// <returns>True if a transition was removed. False if there are no transitions up to that time</returns>
+	bool PopTransition(int64_t time, uint16_t& keyMask, bool& bIsNewPress);
+
+	/// <summary>
+	/// Removes every pending transition. The current key mask is kept.
+	/// </summary>
+	void Clear();
+
+	/// <summary>
+	/// Gets the state of every key after all recorded transitions
+	/// </summary>
+	/// <returns>Bit mask where bit N is set if key N is pressed</returns>
+	uint16_t KeyMask() const { return m_KeyMask; }
+
+	/// <summary>
+	/// Checks if there are transitions waiting to be delivered
+	/// </summary>
+	/// <returns>True if the queue is empty. Otherwise false</returns>
+	bool IsEmpty() const { return m_Count == 0; }
+
+private:
+	/// <summary>
+	/// Queues the current key mask as a transition that happened at the specified time
+	/// </summary>
+	void Push(int64_t timestamp);
+
+private:
+	struct KeyTransition
+	{
+		// Time (From 'Profiler::Now()') the transition happened
+		int64_t Timestamp;
+
+		// State of every key after the transition
+		uint16_t KeyMask;
+	};
+
+	std::array<KeyTransition, k_Capacity> m_Transitions = {};
+
+	// Index of the oldest queued transition and number of transitions queued
+	size_t m_Head = 0;
+	size_t m_Count = 0;
+
+	// State of every key after the newest transition
+	uint16_t m_KeyMask = 0;
+};
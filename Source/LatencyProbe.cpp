@@ -0,0 +1,127 @@
+#include "LatencyProbe.h"
+
+#include <algorithm>
+
+#include "SampleStats.h"
+
+// Source of the probe ROM. V1 holds the key being measured and the block is an 8x8 sprite drawn at (0, 0).
+//
+//	200: A216	I = 0x216 (Block sprite)
+//	202: 6200	V2 = 0
+//	204: 6300	V3 = 0
+//	206: F10A	Wait for a key press, V1 = key
+//	208: D238	Draw the block
+//	20A: E19E	Skip the next instruction if key V1 is pressed
+//	20C: 1210	Jump to 0x210 (Key released)
+//	20E: 120A	Jump to 0x20A (Key still pressed)
+//	210: D238	Erase the block
+//	212: 1206	Jump to 0x206
+//	214: 0000	Padding
+//	216: FF x8	Block sprite
+const uint8_t LatencyProbe::k_ProbeRom[] =
+{
+	0xA2, 0x16, 0x62, 0x00, 0x63, 0x00, 0xF1, 0x0A,
+	0xD2, 0x38, 0xE1, 0x9E, 0x12, 0x10, 0x12, 0x0A,
+	0xD2, 0x38, 0x12, 0x06, 0x00, 0x00, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+
+const size_t LatencyProbe::k_ProbeRomSize = sizeof(LatencyProbe::k_ProbeRom);
+
+void LatencyProbe::SetEnabled(bool bEnabled)
+{
+	m_bIsEnabled = bEnabled;
+
+	m_PendingEventCount = 0;
+	m_PendingPresentCount = 0;
+	m_MeasuredKey = k_NoKey;
+
+	if (bEnabled)
+	{
+		m_EventToVideoMemory.Clear();
+		m_VideoMemoryToPresent.Clear();
+		m_Total.Clear();
+	}
+}
+
+void LatencyProbe::OnKeyEvent(uint8_t key, bool bIsPressed, int64_t timestamp)
+{
+	if (!m_bIsEnabled)
+		return;
+
+	// Follows the probe ROM, so only events that will change VRAM are queued. Anything else would be matched with a later event's change.
+	if (bIsPressed && m_MeasuredKey == k_NoKey)
+	{
+		m_MeasuredKey = key;
+	}
+	else if (!bIsPressed && m_MeasuredKey == key)
+	{
+		m_MeasuredKey = k_NoKey;
+	}
+	else
+	{
+		return;
+	}
+
+	if (m_PendingEventCount == k_MaxPending)
+		return;
+
+	m_PendingEvents[m_PendingEventCount++] = timestamp;
+}
+
+void LatencyProbe::OnVideoMemoryChanged(int64_t time)
+{
+	// VRAM changes that weren't caused by a key event (e.g. the ROM starting up) aren't measured
+	if (!m_bIsEnabled || m_PendingEventCount == 0)
+		return;
+
+	int64_t eventTime = m_PendingEvents[0];
+
+	std::copy(m_PendingEvents.begin() + 1, m_PendingEvents.begin() + m_PendingEventCount, m_PendingEvents.begin());
+	m_PendingEventCount--;
+
+	const float eventToVideoMemory = (time - eventTime) / 1e6f;
+
+	// A bad event timestamp would skew every percentile, so the whole measurement is dropped
+	if (!IsValidSample(eventToVideoMemory))
+		return;
+
+	m_EventToVideoMemory.Push(eventToVideoMemory);
+
+	if (m_PendingPresentCount < k_MaxPending)
+	{
+		m_PendingPresents[m_PendingPresentCount++] = PendingPresent{ eventTime, time };
+	}
+}
+
+void LatencyProbe::OnPresent(int64_t time)
+{
+	if (!m_bIsEnabled)
+		return;
+
+	for (size_t i = 0; i < m_PendingPresentCount; i++)
+	{
+		const float videoMemoryToPresent = (time - m_PendingPresents[i].VideoMemoryTime) / 1e6f;
+		const float total = (time - m_PendingPresents[i].EventTime) / 1e6f;
+
+		if (!IsValidSample(videoMemoryToPresent) || !IsValidSample(total))
+			continue;
+
+		m_VideoMemoryToPresent.Push(videoMemoryToPresent);
+		m_Total.Push(total);
+	}
+
+	m_PendingPresentCount = 0;
+}
+
+float LatencyProbe::Percentile(const RingBuffer<float, k_SampleHistorySize>& samples, float percentile)
+{
+	return SampleStats::Percentile(samples, m_SortScratch, percentile);
+}
+
+const std::array<float, LatencyProbe::k_HistogramBuckets>& LatencyProbe::TotalHistogram()
+{
+	SampleStats::FillHistogram(m_Total, k_HistogramBucketWidthMs, m_Histogram);
+
+	return m_Histogram;
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "EmulatorCommon.h"
+
+#include <array>
+
+#include "RingBuffer.h"
+
+/*
+* Measures end-to-end input latency in two stages: From a key event arriving in SDL to the first VRAM change it causes,
+* and from that VRAM change to 'SDL_RenderPresent()' returning with it on screen.
+*
+* Meant to be run against the bundled probe ROM ('k_ProbeRom'), which waits for a key with FX0A and draws a block as soon as it's pressed,
+* then polls it with EX9E and erases the block as soon as it's released. Every press and release therefore causes exactly one VRAM change.
+*/
+class LatencyProbe
+{
+public:
+	// Number of latency samples kept for each stage
+	static constexpr size_t k_SampleHistorySize = 512;
+
+	// Number of buckets in the total latency histogram
+	static constexpr size_t k_HistogramBuckets = 50;
+
+	// Width of each histogram bucket in milliseconds. The final bucket holds everything slower than the others.
+	static constexpr float k_HistogramBucketWidthMs = 1.0f;
+
+	// Probe ROM, loaded at 0x200
+	static const uint8_t k_ProbeRom[];
+	static const size_t k_ProbeRomSize;
+
+public:
+	/// <summary>
+	/// Starts or stops recording latency samples. Starting clears any previous samples.
+	/// </summary>
+	/// <param name="bEnabled">True to start recording, false to stop</param>
+	void SetEnabled(bool bEnabled);
+
+	/// <summary>
+	/// Checks if latency samples are being recorded
+	/// </summary>
+	/// <returns>True if recording. Otherwise false</returns>
+	bool IsEnabled() const { return m_bIsEnabled; }
+
+	/// <summary>
+	/// Records a keypad event arriving in SDL. Only events that change the probe ROM's display are measured: a press while no key is being
+	/// measured, and then the release of that key. Other keys pressed in between are ignored.
+	/// </summary>
+	/// <param name="key">Keypad key (0 - F)</param>
+	/// <param name="bIsPressed">True if the key was pressed, false if it was released</param>
+	/// <param name="timestamp">Time (From 'Profiler::Now()') the event arrived</param>
+	void OnKeyEvent(uint8_t key, bool bIsPressed, int64_t timestamp);
+
+	/// <summary>
+	/// Records the CPU changing VRAM. Matched with the oldest key event that hasn't caused a VRAM change yet.
+	/// </summary>
+	/// <param name="time">Time (From 'Profiler::Now()') the instruction that changed VRAM finished</param>
+	void OnVideoMemoryChanged(int64_t time);
+
+	/// <summary>
+	/// Records 'SDL_RenderPresent()' returning. Completes the measurement of every VRAM change drawn since the previous present.
+	/// </summary>
+	/// <param name="time">Time (From 'Profiler::Now()') the present returned</param>
+	void OnPresent(int64_t time);
+
+	// Latency from key event to VRAM change for recent samples, in milliseconds
+	const RingBuffer<float, k_SampleHistorySize>& EventToVideoMemory() const { return m_EventToVideoMemory; }
+
+	// Latency from VRAM change to present for recent samples, in milliseconds
+	const RingBuffer<float, k_SampleHistorySize>& VideoMemoryToPresent() const { return m_VideoMemoryToPresent; }
+
+	// Latency from key event to present for recent samples, in milliseconds
+	const RingBuffer<float, k_SampleHistorySize>& Total() const { return m_Total; }
+
+	/// <summary>
+	/// Gets the latency below which the specified percentage of samples fall
+	/// </summary>
+	/// <param name="samples">One of the sample histories</param>
+	/// <param name="percentile">The percentile to calculate, between 0 and 100</param>
+	/// <returns>Latency in milliseconds, or 0 if there are no samples</returns>
+	float Percentile(const RingBuffer<float, k_SampleHistorySize>& samples, float percentile);
+
+	/// <summary>
+	/// Gets the number of total latency samples that fell into each bucket
+	/// </summary>
+	/// <returns>Array of sample counts, one per bucket</returns>
+	const std::array<float, k_HistogramBuckets>& TotalHistogram();
+
+private:
+	// Maximum number of key events waiting for a VRAM change, and of VRAM changes waiting for a present
+	static constexpr size_t k_MaxPending = 16;
+
+	// 'm_MeasuredKey' when the probe ROM is waiting for a key press
+	static constexpr uint8_t k_NoKey = 0xFF;
+
+	// Longest latency in milliseconds that's believable. Anything slower (Or negative) comes from a bad timestamp rather than a slow frame.
+	static constexpr float k_MaxSampleMs = 5000.0f;
+
+	/// <summary>
+	/// Checks that a latency sample is in the range a real measurement could produce
+	/// </summary>
+	static bool IsValidSample(float latencyMs) { return latencyMs >= 0.0f && latencyMs <= k_MaxSampleMs; }
+
+	bool m_bIsEnabled = false;
+
+	// Key the probe ROM is drawing the block for, whose release will erase it
+	uint8_t m_MeasuredKey = k_NoKey;
+
+	// Arrival times of key events that haven't caused a VRAM change yet, oldest first
+	std::array<int64_t, k_MaxPending> m_PendingEvents = {};
+	size_t m_PendingEventCount = 0;
+
+	// Key event and VRAM change times of changes that haven't been presented yet
+	struct PendingPresent
+	{
+		int64_t EventTime;
+		int64_t VideoMemoryTime;
+	};
+
+	std::array<PendingPresent, k_MaxPending> m_PendingPresents = {};
+	size_t m_PendingPresentCount = 0;
+
+	RingBuffer<float, k_SampleHistorySize> m_EventToVideoMemory;
+	RingBuffer<float, k_SampleHistorySize> m_VideoMemoryToPresent;
+	RingBuffer<float, k_SampleHistorySize> m_Total;
+
+	// Scratch space the samples are copied to so percentiles can be calculated without disturbing the history
+	std::array<float, k_SampleHistorySize> m_SortScratch = {};
+
+	std::array<float, k_HistogramBuckets> m_Histogram = {};
+};
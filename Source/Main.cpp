@@ -1,7 +1,22 @@
 #include "Emulator.h"
+#include "HeadlessRunner.h"
 
 int main(int argc, char* args[])
 {
+	// Any arguments are ROMs (Or options) to run without a window
+	if (argc > 1)
+	{
+		HeadlessRunner runner;
+
+		if (!runner.ParseArguments(argc, args))
+		{
+			HeadlessRunner::PrintUsage();
+			return 1;
+		}
+
+		return runner.Run();
+	}
+
 	Emulator emulator;
 
 	if (!emulator.Initialise())
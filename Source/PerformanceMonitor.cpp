@@ -0,0 +1,62 @@
+#include "PerformanceMonitor.h"
+
+#include "SampleStats.h"
+
+void PerformanceMonitor::EndFrame(float frameTime)
+{
+	m_FrameTimes.Push(frameTime * 1000.0f);
+
+	m_SecondTimer += frameTime;
+
+	if (m_SecondTimer >= 1.0f)
+	{
+		// Scale to a per-second rate in case the window ran slightly over a second
+		m_InstructionsPerSecond = static_cast<uint64_t>(m_InstructionsThisSecond / m_SecondTimer);
+		m_TimerTicksPerSecond = static_cast<uint32_t>(m_TimerTicksThisSecond / m_SecondTimer + 0.5f);
+		m_TextureUploadsPerSecond = static_cast<uint32_t>(m_TextureUploadsThisSecond / m_SecondTimer + 0.5f);
+		m_EmulatedFramesPerSecond = static_cast<uint32_t>(m_EmulatedFramesThisSecond / m_SecondTimer + 0.5f);
+		m_SkippedUiFramesPerSecond = static_cast<uint32_t>(m_SkippedUiFramesThisSecond / m_SecondTimer + 0.5f);
+
+		m_InstructionsThisSecond = 0;
+		m_TimerTicksThisSecond = 0;
+		m_TextureUploadsThisSecond = 0;
+		m_EmulatedFramesThisSecond = 0;
+		m_SkippedUiFramesThisSecond = 0;
+
+		m_SecondTimer = 0.0f;
+	}
+}
+
+void PerformanceMonitor::AddImGuiRenderTime(float renderTime)
+{
+	m_ImGuiRenderTimes.Push(renderTime * 1000.0f);
+}
+
+float PerformanceMonitor::FrameTimePercentile(float percentile)
+{
+	return SampleStats::Percentile(m_FrameTimes, m_SortScratch, percentile);
+}
+
+const std::array<float, PerformanceMonitor::k_HistogramBuckets>& PerformanceMonitor::FrameTimeHistogram()
+{
+	SampleStats::FillHistogram(m_FrameTimes, k_HistogramBucketWidthMs, m_Histogram);
+
+	return m_Histogram;
+}
+
+float PerformanceMonitor::AverageImGuiRenderTime() const
+{
+	const size_t count = m_ImGuiRenderTimes.Size();
+
+	if (count == 0)
+		return 0.0f;
+
+	float total = 0.0f;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		total += m_ImGuiRenderTimes[i];
+	}
+
+	return total / count;
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "EmulatorCommon.h"
+
+#include <array>
+
+#include "RingBuffer.h"
+
+/*
+* Collects host and emulation performance counters for the in-app performance panel.
+*
+* All history is kept in fixed-size ring buffers and the statistics are calculated in pre-allocated scratch space,
+* so recording samples and drawing the panel never allocate.
+*/
+class PerformanceMonitor
+{
+public:
+	// Number of frames of history kept for the frame time graph and percentiles
+	static constexpr size_t k_FrameHistorySize = 240;
+
+	// Number of buckets in the frame time histogram
+	static constexpr size_t k_HistogramBuckets = 34;
+
+	// Width of each histogram bucket in milliseconds. The final bucket holds everything slower than the others.
+	static constexpr float k_HistogramBucketWidthMs = 1.0f;
+
+public:
+	/// <summary>
+	/// Records the end of a frame and updates the per-second rates once a full second has passed
+	/// </summary>
+	/// <param name="frameTime">Time taken by the frame in seconds</param>
+	void EndFrame(float frameTime);
+
+	/// <summary>
+	/// Records instructions executed by the emulated CPU
+	/// </summary>
+	/// <param name="count">Number of instructions executed</param>
+	void AddInstructions(uint64_t count) { m_InstructionsThisSecond += count; }
+
+	/// <summary>
+	/// Records a tick of the 60Hz delay/sound timers
+	/// </summary>
+	void AddTimerTick() { m_TimerTicksThisSecond++; }
+
+	/// <summary>
+	/// Records a completed emulated 60Hz frame
+	/// </summary>
+	void AddEmulatedFrame() { m_EmulatedFramesThisSecond++; }
+
+	/// <summary>
+	/// Records an upload of texture data to the GPU
+	/// </summary>
+	void AddTextureUpload() { m_TextureUploadsThisSecond++; }
+
+	/// <summary>
+	/// Records a frame where rendering and presenting were skipped because nothing on screen had changed
+	/// </summary>
+	void AddSkippedUiFrame() { m_SkippedUiFramesThisSecond++; m_SkippedUiFrames++; }
+
+	/// <summary>
+	/// Records the time taken to render the ImGui draw data
+	/// </summary>
+	/// <param name="renderTime">Time taken in seconds</param>
+	void AddImGuiRenderTime(float renderTime);
+
+	/// <summary>
+	/// Gets the frame time in milliseconds below which the specified percentage of recent frames completed
+	/// </summary>
+	/// <param name="percentile">The percentile to calculate, between 0 and 100</param>
+	/// <returns>Frame time in milliseconds, or 0 if no frames have been recorded</returns>
+	float FrameTimePercentile(float percentile);
+
+	/// <summary>
+	/// Gets the history of frame times in milliseconds
+	/// </summary>
+	/// <returns>Ring buffer of recent frame times</returns>
+	const RingBuffer<float, k_FrameHistorySize>& FrameTimes() const { return m_FrameTimes; }
+
+	/// <summary>
+	/// Gets the number of recent frames that fell into each frame time bucket
+	/// </summary>
+	/// <returns>Array of frame counts, one per bucket</returns>
+	const std::array<float, k_HistogramBuckets>& FrameTimeHistogram();
+
+	// Instructions executed by the CPU during the last full second
+	uint64_t InstructionsPerSecond() const { return m_InstructionsPerSecond; }
+
+	// Timer ticks during the last full second
+	uint32_t TimerTicksPerSecond() const { return m_TimerTicksPerSecond; }
+
+	// Texture uploads during the last full second
+	uint32_t TextureUploadsPerSecond() const { return m_TextureUploadsPerSecond; }
+
+	// Emulated frames completed during the last full second
+	uint32_t EmulatedFramesPerSecond() const { return m_EmulatedFramesPerSecond; }
+
+	// Frames that skipped rendering during the last full second
+	uint32_t SkippedUiFramesPerSecond() const { return m_SkippedUiFramesPerSecond; }
+
+	// Frames that skipped rendering since the emulator started
+	uint64_t SkippedUiFrames() const { return m_SkippedUiFrames; }
+
+	// Average time taken to render ImGui over recent frames, in milliseconds
+	float AverageImGuiRenderTime() const;
+
+	// Time taken to render ImGui on the most recent frame, in milliseconds
+	float LastImGuiRenderTime() const { return (m_ImGuiRenderTimes.Size() > 0) ? m_ImGuiRenderTimes.Newest() : 0.0f; }
+
+private:
+	// Time taken by each recent frame in milliseconds
+	RingBuffer<float, k_FrameHistorySize> m_FrameTimes;
+
+	// Time taken by ImGui rendering on each recent frame in milliseconds
+	RingBuffer<float, k_FrameHistorySize> m_ImGuiRenderTimes;
+
+	// Scratch space the frame times are copied to so percentiles can be calculated without disturbing the history
+	std::array<float, k_FrameHistorySize> m_SortScratch = {};
+
+	// Frame counts per histogram bucket, recalculated on request
+	std::array<float, k_HistogramBuckets> m_Histogram = {};
+
+	// Time accumulated towards the current one second sampling window
+	float m_SecondTimer = 0.0f;
+
+	// Counters for the sampling window that is currently in progress
+	uint64_t m_InstructionsThisSecond = 0;
+	uint32_t m_TimerTicksThisSecond = 0;
+	uint32_t m_TextureUploadsThisSecond = 0;
+	uint32_t m_EmulatedFramesThisSecond = 0;
+	uint32_t m_SkippedUiFramesThisSecond = 0;
+
+	// Counters from the last complete sampling window
+	uint64_t m_InstructionsPerSecond = 0;
+	uint32_t m_TimerTicksPerSecond = 0;
+	uint32_t m_TextureUploadsPerSecond = 0;
+	uint32_t m_EmulatedFramesPerSecond = 0;
+	uint32_t m_SkippedUiFramesPerSecond = 0;
+
+	// Total frames that skipped rendering
+	uint64_t m_SkippedUiFrames = 0;
+};
@@ -0,0 +1,116 @@
+#include "Profiler.h"
+
+std::atomic<bool> Profiler::s_bIsEnabled = { true };
+
+std::mutex Profiler::s_BufferMutex;
+
+std::vector<Profiler::ThreadBuffer*> Profiler::s_ThreadBuffers;
+
+int64_t Profiler::Now()
+{
+	static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void Profiler::Record(const char* name, int64_t startTime, int64_t endTime)
+{
+	if (!s_bIsEnabled.load(std::memory_order_relaxed))
+		return;
+
+	ThreadBuffer* buffer = GetThreadBuffer();
+
+	uint64_t writeCount = buffer->WriteCount.load(std::memory_order_relaxed);
+
+	TraceEvent& traceEvent = buffer->Events[writeCount % k_EventsPerThread];
+
+	traceEvent.Name = name;
+	traceEvent.StartTime = startTime;
+	traceEvent.Duration = endTime - startTime;
+
+	// Publish the event so an export running on another thread sees it fully written
+	buffer->WriteCount.store(writeCount + 1, std::memory_order_release);
+}
+
+void Profiler::SetThreadName(const char* name)
+{
+	ThreadBuffer* buffer = GetThreadBuffer();
+
+	std::lock_guard<std::mutex> lock(s_BufferMutex);
+	buffer->ThreadName = name;
+}
+
+void Profiler::SetEnabled(bool bIsEnabled)
+{
+	s_bIsEnabled.store(bIsEnabled, std::memory_order_relaxed);
+}
+
+Profiler::ThreadBuffer* Profiler::GetThreadBuffer()
+{
+	thread_local ThreadBuffer* threadBuffer = nullptr;
+
+	if (threadBuffer == nullptr)
+	{
+		threadBuffer = new ThreadBuffer();
+
+		std::lock_guard<std::mutex> lock(s_BufferMutex);
+
+		threadBuffer->ThreadId = static_cast<uint32_t>(s_ThreadBuffers.size()) + 1;
+		s_ThreadBuffers.push_back(threadBuffer);
+	}
+
+	return threadBuffer;
+}
+
+bool Profiler::ExportChromeTrace(const char* filePath)
+{
+	std::ofstream outputFile(filePath, std::ios::out | std::ios::trunc);
+
+	if (!outputFile.is_open())
+	{
+		std::cout << "ERROR: Failed to open trace output '" << filePath << "'" << std::endl;
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(s_BufferMutex);
+
+	outputFile << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+	bool bIsFirstEvent = true;
+
+	for (const ThreadBuffer* buffer : s_ThreadBuffers)
+	{
+		if (buffer->ThreadName != nullptr)
+		{
+			outputFile << (bIsFirstEvent ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->ThreadId
+				<< ",\"args\":{\"name\":\"" << buffer->ThreadName << "\"}}";
+
+			bIsFirstEvent = false;
+		}
+
+		// The slots aren't atomic, so reading them while the owning thread records events is a data race and the export is only
+		// valid when every other thread is idle. Only the main thread records events at the moment, and it's the one exporting.
+		uint64_t writeCount = buffer->WriteCount.load(std::memory_order_acquire);
+		uint64_t firstEvent = (writeCount > k_EventsPerThread) ? writeCount - k_EventsPerThread : 0;
+
+		for (uint64_t i = firstEvent; i < writeCount; i++)
+		{
+			const TraceEvent& traceEvent = buffer->Events[i % k_EventsPerThread];
+
+			// Chrome expects timestamps in (fractional) microseconds
+			outputFile << (bIsFirstEvent ? "" : ",") << "\n{\"name\":\"" << traceEvent.Name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->ThreadId
+				<< std::fixed << std::setprecision(3)
+				<< ",\"ts\":" << (traceEvent.StartTime / 1000.0)
+				<< ",\"dur\":" << (traceEvent.Duration / 1000.0) << "}";
+
+			bIsFirstEvent = false;
+		}
+	}
+
+	outputFile << "\n]}\n";
+	outputFile.close();
+
+	std::cout << "INFO: Timeline trace written to '" << filePath << "'" << std::endl;
+
+	return true;
+}
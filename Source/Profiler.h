@@ -0,0 +1,142 @@
+#pragma once
+
+#include "EmulatorCommon.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+/*
+* Low-overhead timing probes for building a timeline of where host time is spent each frame.
+*
+* Every thread records into its own fixed-size ring buffer, so recording a probe never takes a lock.
+* The most recent events of every thread can be dumped as Chrome trace JSON (Viewable in chrome://tracing or ui.perfetto.dev)
+*/
+class Profiler
+{
+public:
+	/// <summary>
+	/// Gets the current time on the profiler clock
+	/// </summary>
+	/// <returns>Nanoseconds elapsed since the profiler clock was first read</returns>
+	static int64_t Now();
+
+	/// <summary>
+	/// Records a completed event into the calling thread's trace buffer
+	/// </summary>
+	/// <param name="name">Name of the event. Must be a string literal (or otherwise outlive the profiler) as only the pointer is stored</param>
+	/// <param name="startTime">Time (From 'Now()') the event started</param>
+	/// <param name="endTime">Time (From 'Now()') the event finished</param>
+	static void Record(const char* name, int64_t startTime, int64_t endTime);
+
+	/// <summary>
+	/// Sets the name the calling thread is shown as in exported traces
+	/// </summary>
+	/// <param name="name">Name of the thread. Must be a string literal (or otherwise outlive the profiler)</param>
+	static void SetThreadName(const char* name);
+
+	/// <summary>
+	/// Enables or disables recording of new events. Probes still read the clock when disabled but nothing is stored.
+	/// </summary>
+	/// <param name="bIsEnabled">True to record events, false to ignore them</param>
+	static void SetEnabled(bool bIsEnabled);
+
+	/// <summary>
+	/// Writes the events currently held in every thread's trace buffer to disk in the Chrome trace event format.
+	/// No other thread can be recording events while this runs (Their buffers are read without synchronisation).
+	/// </summary>
+	/// <param name="filePath">Path of the JSON file to write</param>
+	/// <returns>True if the trace was written successfully. Otherwise false</returns>
+	static bool ExportChromeTrace(const char* filePath);
+
+private:
+	// Number of events each thread can hold before the oldest are overwritten
+	static constexpr uint64_t k_EventsPerThread = 1 << 16;
+
+	/*
+	* A single completed timing event
+	*/
+	struct TraceEvent
+	{
+		// Name of the probe that recorded the event
+		const char* Name;
+
+		// Start time of the event in nanoseconds
+		int64_t StartTime;
+
+		// Length of the event in nanoseconds
+		int64_t Duration;
+	};
+
+	/*
+	* Fixed size ring buffer of events owned by a single thread. Only the owning thread writes to it.
+	*/
+	struct ThreadBuffer
+	{
+		// Sequential ID of the thread, used as the 'tid' in exported traces
+		uint32_t ThreadId = 0;
+
+		// Name of the thread shown in exported traces (Or nullptr if it hasn't been named)
+		const char* ThreadName = nullptr;
+
+		// Total number of events ever written. The write position in 'Events' is this value modulo the capacity.
+		std::atomic<uint64_t> WriteCount = { 0 };
+
+		// Storage for the most recent events recorded by the thread
+		TraceEvent Events[k_EventsPerThread];
+	};
+
+	/// <summary>
+	/// Gets the trace buffer of the calling thread, creating and registering it on first use
+	/// </summary>
+	/// <returns>Trace buffer owned by the calling thread</returns>
+	static ThreadBuffer* GetThreadBuffer();
+
+private:
+	// Set to false to stop new events being recorded
+	static std::atomic<bool> s_bIsEnabled;
+
+	// Guards registration of new thread buffers and exporting
+	static std::mutex s_BufferMutex;
+
+	// Every thread buffer that has been created. Buffers are never freed so events from finished threads can still be exported
+	static std::vector<ThreadBuffer*> s_ThreadBuffers;
+};
+
+/*
+* Records the time between construction and destruction as a profiler event
+*/
+class ProfileScope
+{
+public:
+	explicit ProfileScope(const char* name)
+		: m_Name(name), m_StartTime(Profiler::Now())
+	{
+	}
+
+	~ProfileScope()
+	{
+		Profiler::Record(m_Name, m_StartTime, Profiler::Now());
+	}
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+	// Name of the event being timed
+	const char* m_Name;
+
+	// Time the scope was entered
+	int64_t m_StartTime;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+// Times the rest of the enclosing scope. Compiles to nothing when CHIP8_DISABLE_PROFILER is defined.
+#ifndef CHIP8_DISABLE_PROFILER
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name)
+#endif
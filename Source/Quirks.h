@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+/**
+ * Sets of behaviours that differ between CHIP-8 interpreters. ROMs written for one interpreter often misbehave on another.
+ */
+enum class QuirkProfile : uint8_t
+{
+	// The original interpreter on the RCA COSMAC VIP (1977)
+	CosmacVip,
+
+	// CHIP-48 on the HP-48 calculators (1990)
+	Chip48,
+
+	// SUPER-CHIP 1.1 on the HP-48 calculators (1991)
+	SuperChip,
+
+	// Octo and XO-CHIP, which most ROMs written in the last decade target
+	Modern
+};
+
+// What the load/store instructions (Fx55/Fx65) do to I afterwards
+enum class LoadStoreIncrement : uint8_t
+{
+	// I is left unchanged
+	None,
+
+	// I is increased by x
+	X,
+
+	// I is increased by x + 1 (I ends up just past the last register stored or loaded)
+	XPlusOne
+};
+
+/*
+* Quirk policies. Each is a set of compile-time constants the CPU's instruction handlers are specialised on, so a ROM runs through
+* handlers with its quirks baked in rather than checking them on every instruction.
+*
+*	k_bResetVfOnLogic     - 8xy1/8xy2/8xy3 set VF to 0
+*	k_bShiftUsesVy        - 8xy6/8xyE shift Vy and store the result in Vx, rather than shifting Vx in place
+*	k_LoadStoreIncrement  - What Fx55/Fx65 do to I
+*	k_bJumpUsesVx         - Bxnn jumps to xnn + Vx rather than nnn + V0
+*	k_bClipSprites        - Sprites drawn past the edge of the screen are clipped rather than wrapped around to the other side
+*	k_bSuperChipOpCodes   - The SCHIP instructions (00FD-00FF, Dxy0, Fx30, Fx75, Fx85) are available. Otherwise they're unknown OpCodes.
+*	k_bXoChipOpCodes      - The XO-CHIP instructions (00Dn, 5xy2, 5xy3, F000 nnnn, Fn01, F002, Fx3A) are available. Otherwise they're unknown OpCodes.
+*	k_bMachineCodeRoutines - 0nnn calls an 1802 machine code routine. Otherwise it's an unknown OpCode.
+*	k_MemorySize          - Bytes of memory the interpreter had. Only enforced by checked memory access (See 'CheckedMemoryAccess').
+*/
+struct CosmacVipQuirks
+{
+	static constexpr bool k_bResetVfOnLogic = true;
+	static constexpr bool k_bShiftUsesVy = true;
+	static constexpr LoadStoreIncrement k_LoadStoreIncrement = LoadStoreIncrement::XPlusOne;
+	static constexpr bool k_bJumpUsesVx = false;
+	static constexpr bool k_bClipSprites = true;
+	static constexpr bool k_bSuperChipOpCodes = false;
+	static constexpr bool k_bXoChipOpCodes = false;
+	static constexpr bool k_bMachineCodeRoutines = true;
+	static constexpr uint32_t k_MemorySize = 4096;
+};
+
+struct Chip48Quirks
+{
+	static constexpr bool k_bResetVfOnLogic = false;
+	static constexpr bool k_bShiftUsesVy = false;
+	static constexpr LoadStoreIncrement k_LoadStoreIncrement = LoadStoreIncrement::X;
+	static constexpr bool k_bJumpUsesVx = true;
+	static constexpr bool k_bClipSprites = true;
+	static constexpr bool k_bSuperChipOpCodes = false;
+	static constexpr bool k_bXoChipOpCodes = false;
+	static constexpr bool k_bMachineCodeRoutines = false;
+	static constexpr uint32_t k_MemorySize = 4096;
+};
+
+struct SuperChipQuirks
+{
+	static constexpr bool k_bResetVfOnLogic = false;
+	static constexpr bool k_bShiftUsesVy = false;
+	static constexpr LoadStoreIncrement k_LoadStoreIncrement = LoadStoreIncrement::None;
+	static constexpr bool k_bJumpUsesVx = true;
+	static constexpr bool k_bClipSprites = true;
+	static constexpr bool k_bSuperChipOpCodes = true;
+	static constexpr bool k_bXoChipOpCodes = false;
+	static constexpr bool k_bMachineCodeRoutines = false;
+	static constexpr uint32_t k_MemorySize = 4096;
+};
+
+struct ModernQuirks
+{
+	static constexpr bool k_bResetVfOnLogic = false;
+	static constexpr bool k_bShiftUsesVy = true;
+	static constexpr LoadStoreIncrement k_LoadStoreIncrement = LoadStoreIncrement::XPlusOne;
+	static constexpr bool k_bJumpUsesVx = false;
+	static constexpr bool k_bClipSprites = false;
+	static constexpr bool k_bSuperChipOpCodes = true;
+	static constexpr bool k_bXoChipOpCodes = true;
+	static constexpr bool k_bMachineCodeRoutines = false;
+	static constexpr uint32_t k_MemorySize = 65536;
+};
+
+/*
+* Memory access policies. Each is combined with a quirk policy through 'WithMemoryAccess', so the instruction handlers are specialised on both
+* and the unchecked handlers carry no trace of the checks.
+*
+*	k_bCheckMemoryAccess  - Every memory access is checked against the interpreter's 'k_MemorySize', and every call and return against the 16 level
+*	                        stack. The first one out of range stops the CPU and reports exactly what went wrong. Otherwise addresses are masked to
+*	                        the size of the CPU's memory and the stack pointer wraps, so a malformed ROM can't read or write outside the CPU state.
+*/
+struct CheckedMemoryAccess
+{
+	static constexpr bool k_bCheckMemoryAccess = true;
+};
+
+struct UncheckedMemoryAccess
+{
+	static constexpr bool k_bCheckMemoryAccess = false;
+};
+
+template<typename Quirks, typename MemoryAccess>
+struct WithMemoryAccess : Quirks, MemoryAccess
+{
+};
+
+// Number of quirk profiles, for iterating over them in menus
+constexpr int k_QuirkProfileCount = 4;
+
+/// <summary>
+/// Gets the display name of a quirk profile
+/// </summary>
+inline const char* QuirkProfileName(QuirkProfile profile)
+{
+	switch (profile)
+	{
+		case QuirkProfile::CosmacVip: return "COSMAC VIP";
+		case QuirkProfile::Chip48: return "CHIP-48";
+		case QuirkProfile::SuperChip: return "SCHIP";
+		case QuirkProfile::Modern: return "Modern";
+	}
+
+	return "";
+}
+
+/// <summary>
+/// Gets a quirk profile from its short name ('vip', 'chip48', 'schip' or 'modern'), as used on the command line
+/// </summary>
+/// <param name="name">Short name of the profile</param>
+/// <param name="profile">Receives the profile if the name was recognised</param>
+/// <returns>True if the name was recognised. Otherwise false</returns>
+inline bool ParseQuirkProfile(const char* name, QuirkProfile& profile)
+{
+	const char* k_ShortNames[k_QuirkProfileCount] = { "vip", "chip48", "schip", "modern" };
+
+	for (int i = 0; i < k_QuirkProfileCount; i++)
+	{
+		if (strcmp(name, k_ShortNames[i]) == 0)
+		{
+			profile = static_cast<QuirkProfile>(i);
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+
+/*
+* Fixed capacity ring buffer. Once full, pushing a new value overwrites the oldest one.
+*
+* Storage is inline so pushing never allocates. The layout (A flat array plus the index of the oldest value) matches what
+* ImGui::PlotLines/PlotHistogram expect for their 'values' and 'values_offset' parameters.
+*/
+template <typename T, size_t Capacity>
+class RingBuffer
+{
+public:
+	/// <summary>
+	/// Adds a value to the buffer, replacing the oldest value if the buffer is full
+	/// </summary>
+	/// <param name="value">The value to add</param>
+	void Push(const T& value)
+	{
+		m_Values[m_Head] = value;
+		m_Head = (m_Head + 1) % Capacity;
+
+		if (m_Count < Capacity)
+			m_Count++;
+	}
+
+	/// <summary>
+	/// Removes every value from the buffer
+	/// </summary>
+	void Clear()
+	{
+		m_Head = 0;
+		m_Count = 0;
+	}
+
+	/// <summary>
+	/// Gets a value by age
+	/// </summary>
+	/// <param name="index">Index of the value to get, where 0 is the oldest value still held</param>
+	/// <returns>The value at the specified index</returns>
+	const T& operator[](size_t index) const
+	{
+		return m_Values[(Offset() + index) % Capacity];
+	}
+
+	/// <summary>
+	/// Gets the most recently added value. The buffer must not be empty.
+	/// </summary>
+	/// <returns>The newest value in the buffer</returns>
+	const T& Newest() const
+	{
+		return m_Values[(m_Head + Capacity - 1) % Capacity];
+	}
+
+	/// <summary>
+	/// Gets the raw storage of the buffer. Values aren't in age order, use 'Offset()' to find the oldest one.
+	/// </summary>
+	/// <returns>Pointer to the start of the underlying storage</returns>
+	const T* Data() const
+	{
+		return m_Values;
+	}
+
+	/// <summary>
+	/// Gets the position of the oldest value in the raw storage returned by 'Data()'
+	/// </summary>
+	/// <returns>Index of the oldest value in the underlying storage</returns>
+	size_t Offset() const
+	{
+		return (m_Count < Capacity) ? 0 : m_Head;
+	}
+
+	/// <summary>
+	/// Gets the number of values currently held
+	/// </summary>
+	/// <returns>Number of values in the buffer</returns>
+	size_t Size() const
+	{
+		return m_Count;
+	}
+
+	/// <summary>
+	/// Gets the maximum number of values the buffer can hold
+	/// </summary>
+	/// <returns>Capacity of the buffer</returns>
+	static constexpr size_t MaxSize()
+	{
+		return Capacity;
+	}
+
+private:
+	// Storage for the values
+	T m_Values[Capacity] = {};
+
+	// Index the next value will be written to
+	size_t m_Head = 0;
+
+	// Number of values currently held (Up to 'Capacity')
+	size_t m_Count = 0;
+};
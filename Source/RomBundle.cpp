@@ -0,0 +1,279 @@
+#include "RomBundle.h"
+
+#include <algorithm>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // !_WIN32
+
+RomBundle::~RomBundle()
+{
+	Close();
+}
+
+bool RomBundle::Open(const std::filesystem::path& bundlePath)
+{
+	Close();
+
+#ifdef _WIN32
+	m_FileHandle = CreateFileW(bundlePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	LARGE_INTEGER fileSize = {};
+
+	if (m_FileHandle == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_FileHandle, &fileSize))
+	{
+		std::cout << "ERROR: Failed to open ROM bundle '" << bundlePath.u8string() << "'" << std::endl;
+		Close();
+		return false;
+	}
+
+	m_Size = static_cast<size_t>(fileSize.QuadPart);
+
+	if (m_Size >= sizeof(BundleHeader))
+	{
+		m_MappingHandle = CreateFileMappingW(m_FileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+
+		if (m_MappingHandle != NULL)
+		{
+			m_Data = static_cast<const uint8_t*>(MapViewOfFile(m_MappingHandle, FILE_MAP_READ, 0, 0, 0));
+		}
+	}
+#else
+	int fileDescriptor = open(bundlePath.c_str(), O_RDONLY);
+
+	struct stat fileStatus = {};
+
+	if (fileDescriptor < 0 || fstat(fileDescriptor, &fileStatus) != 0)
+	{
+		std::cout << "ERROR: Failed to open ROM bundle '" << bundlePath.u8string() << "': " << strerror(errno) << std::endl;
+
+		if (fileDescriptor >= 0)
+			close(fileDescriptor);
+
+		return false;
+	}
+
+	m_Size = static_cast<size_t>(fileStatus.st_size);
+
+	if (m_Size >= sizeof(BundleHeader))
+	{
+		void* mapping = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+
+		if (mapping != MAP_FAILED)
+		{
+			m_Data = static_cast<const uint8_t*>(mapping);
+		}
+	}
+
+	// The mapping keeps its own reference to the file
+	close(fileDescriptor);
+#endif // _WIN32
+
+	if (m_Data == nullptr)
+	{
+		std::cout << "ERROR: Failed to map ROM bundle '" << bundlePath.u8string() << "'" << std::endl;
+		Close();
+		return false;
+	}
+
+	BundleHeader header;
+	memcpy(&header, m_Data, sizeof(header));
+
+	const bool bIsValidHeader = memcmp(header.Magic, k_Magic, sizeof(k_Magic)) == 0 && header.Version == k_Version
+		&& header.IndexOffset <= m_Size && header.RomCount <= (m_Size - header.IndexOffset) / sizeof(BundleIndexEntry)
+		&& header.NamesOffset <= m_Size && header.NamesSize <= m_Size - header.NamesOffset
+		&& header.IndexOffset % alignof(BundleIndexEntry) == 0;
+
+	if (!bIsValidHeader)
+	{
+		std::cout << "ERROR: '" << bundlePath.u8string() << "' is not a valid ROM bundle" << std::endl;
+		Close();
+		return false;
+	}
+
+	m_Index = reinterpret_cast<const BundleIndexEntry*>(m_Data + header.IndexOffset);
+	m_RomCount = header.RomCount;
+	m_Names = reinterpret_cast<const char*>(m_Data + header.NamesOffset);
+
+	// Check every entry up front so GetRom never has to
+	for (size_t i = 0; i < m_RomCount; i++)
+	{
+		const BundleIndexEntry& entry = m_Index[i];
+
+		const bool bIsValidEntry = entry.DataOffset <= m_Size && entry.Size <= m_Size - entry.DataOffset
+			&& entry.NameOffset <= header.NamesSize && entry.NameLength <= header.NamesSize - entry.NameOffset
+			&& (i == 0 || m_Index[i - 1].Hash < entry.Hash);
+
+		if (!bIsValidEntry)
+		{
+			std::cout << "ERROR: ROM bundle '" << bundlePath.u8string() << "' has a corrupt index (Entry " << i << ")" << std::endl;
+			Close();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void RomBundle::Close()
+{
+#ifdef _WIN32
+	if (m_Data != nullptr)
+		UnmapViewOfFile(m_Data);
+
+	if (m_MappingHandle != NULL)
+		CloseHandle(m_MappingHandle);
+
+	if (m_FileHandle != INVALID_HANDLE_VALUE)
+		CloseHandle(m_FileHandle);
+
+	m_MappingHandle = NULL;
+	m_FileHandle = INVALID_HANDLE_VALUE;
+#else
+	if (m_Data != nullptr)
+		munmap(const_cast<uint8_t*>(m_Data), m_Size);
+#endif // _WIN32
+
+	m_Data = nullptr;
+	m_Size = 0;
+
+	m_Index = nullptr;
+	m_RomCount = 0;
+
+	m_Names = nullptr;
+}
+
+RomBundle::RomView RomBundle::GetRom(size_t index) const
+{
+	const BundleIndexEntry& entry = m_Index[index];
+
+	return { m_Data + entry.DataOffset, entry.Size, entry.Hash, m_Names + entry.NameOffset, entry.NameLength };
+}
+
+bool RomBundle::FindRom(uint64_t hash, RomView& rom) const
+{
+	const BundleIndexEntry* end = m_Index + m_RomCount;
+	const BundleIndexEntry* entry = std::lower_bound(m_Index, end, hash, [](const BundleIndexEntry& a, uint64_t b) { return a.Hash < b; });
+
+	if (entry == end || entry->Hash != hash)
+		return false;
+
+	rom = GetRom(static_cast<size_t>(entry - m_Index));
+	return true;
+}
+
+bool RomBundle::Build(const std::filesystem::path& bundlePath, const std::vector<std::filesystem::path>& romPaths)
+{
+	struct PackedRom
+	{
+		std::vector<uint8_t> Data;
+		std::string Name;
+		uint64_t Hash;
+	};
+
+	std::vector<PackedRom> roms;
+	roms.reserve(romPaths.size());
+
+	for (const std::filesystem::path& romPath : romPaths)
+	{
+		std::ifstream romFile(romPath, std::ios::binary);
+
+		if (!romFile.is_open())
+		{
+			std::cout << "ERROR: Failed to open ROM '" << romPath.u8string() << "'" << std::endl;
+			return false;
+		}
+
+		PackedRom rom;
+		rom.Data.assign(std::istreambuf_iterator<char>(romFile), std::istreambuf_iterator<char>());
+		rom.Name = romPath.filename().u8string();
+		rom.Hash = HashRom(rom.Data.data(), rom.Data.size());
+
+		roms.push_back(std::move(rom));
+	}
+
+	// Keep the first of any ROMs with the same contents
+	std::stable_sort(roms.begin(), roms.end(), [](const PackedRom& a, const PackedRom& b) { return a.Hash < b.Hash; });
+	roms.erase(std::unique(roms.begin(), roms.end(), [](const PackedRom& a, const PackedRom& b) { return a.Hash == b.Hash; }), roms.end());
+
+	auto alignUp = [](uint64_t offset) { return (offset + k_DataAlignment - 1) & ~(k_DataAlignment - 1); };
+
+	std::vector<BundleIndexEntry> index(roms.size());
+	std::string names;
+
+	BundleHeader header = {};
+	memcpy(header.Magic, k_Magic, sizeof(k_Magic));
+	header.Version = k_Version;
+	header.RomCount = static_cast<uint32_t>(roms.size());
+	header.IndexOffset = sizeof(BundleHeader);
+	header.NamesOffset = header.IndexOffset + index.size() * sizeof(BundleIndexEntry);
+
+	for (size_t i = 0; i < roms.size(); i++)
+	{
+		index[i] = {};
+		index[i].Hash = roms[i].Hash;
+		index[i].Size = static_cast<uint32_t>(roms[i].Data.size());
+		index[i].NameOffset = static_cast<uint32_t>(names.size());
+		index[i].NameLength = static_cast<uint32_t>(roms[i].Name.size());
+
+		names += roms[i].Name;
+	}
+
+	header.NamesSize = names.size();
+	header.DataOffset = alignUp(header.NamesOffset + header.NamesSize);
+
+	uint64_t dataOffset = header.DataOffset;
+
+	for (size_t i = 0; i < roms.size(); i++)
+	{
+		index[i].DataOffset = dataOffset;
+		dataOffset = alignUp(dataOffset + roms[i].Data.size());
+	}
+
+	std::ofstream bundleFile(bundlePath, std::ios::binary | std::ios::trunc);
+
+	if (!bundleFile.is_open())
+	{
+		std::cout << "ERROR: Failed to create ROM bundle '" << bundlePath.u8string() << "'" << std::endl;
+		return false;
+	}
+
+	const char padding[k_DataAlignment] = {};
+
+	bundleFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	bundleFile.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(BundleIndexEntry));
+	bundleFile.write(names.data(), names.size());
+
+	uint64_t writtenBytes = header.NamesOffset + header.NamesSize;
+
+	for (size_t i = 0; i < roms.size(); i++)
+	{
+		bundleFile.write(padding, index[i].DataOffset - writtenBytes);
+		bundleFile.write(reinterpret_cast<const char*>(roms[i].Data.data()), roms[i].Data.size());
+
+		writtenBytes = index[i].DataOffset + roms[i].Data.size();
+	}
+
+	if (!bundleFile.good())
+	{
+		std::cout << "ERROR: Failed to write ROM bundle '" << bundlePath.u8string() << "'" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+uint64_t RomBundle::HashRom(const uint8_t* data, size_t size)
+{
+	uint64_t hash = 14695981039346656037ull;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		hash = (hash ^ data[i]) * 1099511628211ull;
+	}
+
+	return hash;
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "EmulatorCommon.h"
+
+#include <filesystem>
+#include <vector>
+
+/*
+* Read-only pack of many ROMs in a single memory-mapped file.
+*
+* Loading a large collection of ROMs as individual files spends most of its time opening, seeking and reading them. A bundle is mapped
+* once and each ROM is handed to 'CPU::LoadProgram(const uint8_t*, size_t)' straight from the mapping, so loading a ROM is a single memcpy.
+*
+* File layout (All values little-endian):
+*	Header        - 64 bytes, see 'BundleHeader'
+*	Index         - One 'BundleIndexEntry' per ROM, sorted by content hash so ROMs can be looked up with a binary search
+*	Names         - UTF-8 file names of each ROM, referenced by offset and length from the index
+*	ROM data      - Contents of each ROM, every one starting on a 64-byte boundary
+*/
+class RomBundle
+{
+public:
+	// A ROM inside the bundle. Data points into the mapped file, so it's only valid while the bundle is open.
+	struct RomView
+	{
+		const uint8_t* Data;
+		size_t Size;
+
+		// FNV-1a hash of the ROM's contents
+		uint64_t Hash;
+
+		// File name the ROM was packed from (Not null-terminated)
+		const char* Name;
+		size_t NameLength;
+	};
+
+	// Extension used for bundle files
+	static constexpr const char* k_FileExtension = ".c8b";
+
+public:
+	RomBundle() = default;
+	~RomBundle();
+
+	RomBundle(const RomBundle&) = delete;
+	RomBundle& operator=(const RomBundle&) = delete;
+
+	/// <summary>
+	/// Maps a bundle file into memory and checks its header and index are valid. Closes any bundle that's already open.
+	/// </summary>
+	/// <param name="bundlePath">Path to the bundle on disk</param>
+	/// <returns>True if the bundle was opened. Otherwise false</returns>
+	bool Open(const std::filesystem::path& bundlePath);
+
+	/// <summary>
+	/// Unmaps the bundle. Any RomViews taken from it are no longer valid.
+	/// </summary>
+	void Close();
+
+	/// <summary>
+	/// Gets the number of ROMs in the bundle
+	/// </summary>
+	size_t RomCount() const { return m_RomCount; }
+
+	/// <summary>
+	/// Gets a ROM by its position in the index (ROMs are ordered by hash)
+	/// </summary>
+	/// <param name="index">Position of the ROM, less than RomCount()</param>
+	RomView GetRom(size_t index) const;
+
+	/// <summary>
+	/// Looks up a ROM by the hash of its contents
+	/// </summary>
+	/// <param name="hash">Hash of the ROM, as returned by HashRom</param>
+	/// <param name="rom">Receives the ROM if it was found</param>
+	/// <returns>True if the bundle contains a ROM with that hash. Otherwise false</returns>
+	bool FindRom(uint64_t hash, RomView& rom) const;
+
+	/// <summary>
+	/// Packs ROM files into a new bundle. ROMs with identical contents are only stored once.
+	/// </summary>
+	/// <param name="bundlePath">Path of the bundle to write. Overwritten if it exists.</param>
+	/// <param name="romPaths">ROM files to pack</param>
+	/// <returns>True if the bundle was written. Otherwise false</returns>
+	static bool Build(const std::filesystem::path& bundlePath, const std::vector<std::filesystem::path>& romPaths);
+
+	/// <summary>
+	/// Hashes the contents of a ROM (64-bit FNV-1a)
+	/// </summary>
+	static uint64_t HashRom(const uint8_t* data, size_t size);
+
+private:
+	struct BundleHeader
+	{
+		char Magic[8];
+		uint32_t Version;
+		uint32_t RomCount;
+
+		uint64_t IndexOffset;
+		uint64_t NamesOffset;
+		uint64_t NamesSize;
+		uint64_t DataOffset;
+
+		uint8_t Reserved[16];
+	};
+
+	struct BundleIndexEntry
+	{
+		uint64_t Hash;
+
+		// Offset of the ROM data from the start of the file
+		uint64_t DataOffset;
+		uint32_t Size;
+
+		// Offset of the name from the start of the names section
+		uint32_t NameOffset;
+		uint32_t NameLength;
+
+		uint32_t Reserved;
+	};
+
+	static_assert(sizeof(BundleHeader) == 64, "Bundle header layout must match the file format");
+	static_assert(sizeof(BundleIndexEntry) == 32, "Bundle index layout must match the file format");
+
+	static constexpr char k_Magic[8] = { 'C', 'H', 'I', 'P', '8', 'P', 'A', 'K' };
+	static constexpr uint32_t k_Version = 1;
+
+	// ROM data is aligned to a cache line so it can be copied with aligned loads
+	static constexpr uint64_t k_DataAlignment = 64;
+
+	// Start of the mapped file and its size in bytes
+	const uint8_t* m_Data = nullptr;
+	size_t m_Size = 0;
+
+	const BundleIndexEntry* m_Index = nullptr;
+	size_t m_RomCount = 0;
+
+	const char* m_Names = nullptr;
+
+#ifdef _WIN32
+	HANDLE m_FileHandle = INVALID_HANDLE_VALUE;
+	HANDLE m_MappingHandle = NULL;
+#endif // _WIN32
+};
@@ -0,0 +1,298 @@
+#include "RomLibrary.h"
+
+#include "RomBundle.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <unordered_map>
+
+bool RomLibrary::LoadIndex(const std::filesystem::path& indexPath)
+{
+	std::ifstream indexFile(indexPath, std::ios::binary);
+
+	if (!indexFile.is_open())
+		return false;
+
+	std::string line;
+
+	// Header: signature, version and the folder that was scanned
+	if (!std::getline(indexFile, line))
+		return false;
+
+	const size_t signatureEnd = line.find('\t');
+	const size_t versionEnd = line.find('\t', signatureEnd + 1);
+
+	if (signatureEnd == std::string::npos || versionEnd == std::string::npos || line.compare(0, signatureEnd, k_IndexSignature) != 0
+		|| std::strtoul(line.c_str() + signatureEnd + 1, nullptr, 10) != k_IndexVersion)
+	{
+		std::cout << "ERROR: '" << indexPath.u8string() << "' is not a ROM library index" << std::endl;
+		return false;
+	}
+
+	const std::filesystem::path rootPath = std::filesystem::u8path(line.substr(versionEnd + 1));
+
+	std::vector<RomEntry> entries;
+
+	// Entries: hash, size, modified time, platform, instructions per frame, path. The path is last as it's the only field that can contain spaces.
+	while (std::getline(indexFile, line))
+	{
+		const char* field = line.c_str();
+		char* fieldEnd = nullptr;
+
+		RomEntry entry;
+
+		entry.Hash = std::strtoull(field, &fieldEnd, 16);
+		entry.Size = std::strtoull(fieldEnd, &fieldEnd, 10);
+		entry.ModifiedTime = std::strtoll(fieldEnd, &fieldEnd, 10);
+		entry.Platform = static_cast<RomPlatform>(std::min(std::strtoul(fieldEnd, &fieldEnd, 10), static_cast<unsigned long>(RomPlatform::XoChip)));
+		entry.InstructionsPerFrame = static_cast<uint32_t>(std::strtoul(fieldEnd, &fieldEnd, 10));
+
+		if (*fieldEnd != '\t' || entry.InstructionsPerFrame == 0)
+			continue;
+
+		entry.Path = std::filesystem::u8path(fieldEnd + 1);
+		entry.Name = entry.Path.filename().u8string();
+
+		entries.push_back(std::move(entry));
+	}
+
+	m_Entries = std::move(entries);
+	m_RootPath = rootPath;
+
+	return true;
+}
+
+bool RomLibrary::SaveIndex(const std::filesystem::path& indexPath) const
+{
+	std::ofstream indexFile(indexPath, std::ios::binary | std::ios::trunc);
+
+	if (!indexFile.is_open())
+	{
+		std::cout << "ERROR: Failed to write ROM library index '" << indexPath.u8string() << "'" << std::endl;
+		return false;
+	}
+
+	indexFile << k_IndexSignature << '\t' << k_IndexVersion << '\t' << m_RootPath.u8string() << '\n';
+
+	for (const RomEntry& entry : m_Entries)
+	{
+		indexFile << std::hex << std::setw(16) << std::setfill('0') << entry.Hash << std::dec << std::setfill(' ') << '\t'
+			<< entry.Size << '\t'
+			<< entry.ModifiedTime << '\t'
+			<< static_cast<int>(entry.Platform) << '\t'
+			<< entry.InstructionsPerFrame << '\t'
+			<< entry.Path.u8string() << '\n';
+	}
+
+	return indexFile.good();
+}
+
+bool RomLibrary::Scan(const std::filesystem::path& rootPath)
+{
+	const auto startTime = std::chrono::steady_clock::now();
+
+	std::error_code error;
+
+	if (!std::filesystem::is_directory(rootPath, error))
+	{
+		std::cout << "ERROR: ROM library folder '" << rootPath.u8string() << "' doesn't exist" << std::endl;
+		return false;
+	}
+
+	// Entries from the last scan of this folder, looked up by path so unchanged ROMs don't need reading again
+	std::unordered_map<std::string, size_t> previousEntries;
+
+	if (rootPath == m_RootPath)
+	{
+		previousEntries.reserve(m_Entries.size());
+
+		for (size_t i = 0; i < m_Entries.size(); i++)
+		{
+			previousEntries.emplace(m_Entries[i].Path.u8string(), i);
+		}
+	}
+
+	std::vector<RomEntry> entries;
+	entries.reserve(m_Entries.size());
+
+	ScanStats stats;
+
+	// Number of ROMs from the previous scan that are still there, whether they've changed or not
+	size_t remainingEntries = 0;
+
+	const std::filesystem::directory_options options = std::filesystem::directory_options::skip_permission_denied;
+
+	for (std::filesystem::recursive_directory_iterator it(rootPath, options, error), end; it != end; it.increment(error))
+	{
+		// On Windows the size and modification time come from the directory listing, so unchanged ROMs never have their files opened
+		const std::filesystem::directory_entry& directoryEntry = *it;
+
+		if (!directoryEntry.is_regular_file(error))
+			continue;
+
+		std::string extension = directoryEntry.path().extension().u8string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+
+		if (std::find_if(std::begin(k_RomExtensions), std::end(k_RomExtensions), [&extension](const char* romExtension) { return extension == romExtension; }) == std::end(k_RomExtensions))
+			continue;
+
+		RomEntry entry;
+		entry.Path = directoryEntry.path();
+		entry.Name = entry.Path.filename().u8string();
+		entry.Size = directoryEntry.file_size(error);
+		entry.ModifiedTime = static_cast<int64_t>(directoryEntry.last_write_time(error).time_since_epoch().count());
+
+		stats.Files++;
+
+		auto previous = previousEntries.find(entry.Path.u8string());
+
+		if (previous != previousEntries.end())
+		{
+			const RomEntry& previousEntry = m_Entries[previous->second];
+
+			remainingEntries++;
+
+			if (previousEntry.Size == entry.Size && previousEntry.ModifiedTime == entry.ModifiedTime)
+			{
+				entries.push_back(previousEntry);
+				continue;
+			}
+		}
+
+		if (!HashEntry(entry))
+			continue;
+
+		stats.Hashed++;
+		entries.push_back(std::move(entry));
+	}
+
+	std::sort(entries.begin(), entries.end(), [](const RomEntry& a, const RomEntry& b) { return a.Name < b.Name; });
+
+	stats.Removed = m_Entries.size() - remainingEntries;
+	stats.Milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+	m_Entries = std::move(entries);
+	m_RootPath = rootPath;
+	m_LastScan = stats;
+
+	return true;
+}
+
+bool RomLibrary::HashEntry(RomEntry& entry)
+{
+	std::ifstream romFile(entry.Path, std::ios::binary);
+
+	if (!romFile.is_open())
+		return false;
+
+	const std::vector<uint8_t> romData((std::istreambuf_iterator<char>(romFile)), std::istreambuf_iterator<char>());
+
+	entry.Size = romData.size();
+	entry.Hash = RomBundle::HashRom(romData.data(), romData.size());
+	entry.Platform = DetectPlatform(romData.data(), romData.size());
+	entry.InstructionsPerFrame = DefaultInstructionsPerFrame(entry.Platform);
+
+	return true;
+}
+
+RomPlatform RomLibrary::DetectPlatform(const uint8_t* data, size_t size)
+{
+	// Anything bigger than the CHIP-8 program area needs XO-CHIP's 64KB of memory
+	if (size > 4096 - 0x200)
+		return RomPlatform::XoChip;
+
+	// Bit N is set if the Nth SCHIP/XO-CHIP-only instruction form was seen
+	uint32_t superChipForms = 0;
+	uint32_t xoChipForms = 0;
+
+	for (size_t i = 0; i + 1 < size; i += 2)
+	{
+		const uint16_t opcode = static_cast<uint16_t>(data[i] << 8 | data[i + 1]);
+
+		const uint8_t x = (opcode & 0x0F00) >> 8;
+		const uint8_t lowByte = opcode & 0x00FF;
+
+		switch (opcode & 0xF000)
+		{
+			case 0x0000:
+			{
+				if (x != 0)
+					break;
+
+				if ((lowByte & 0xF0) == 0xC0 && (lowByte & 0x0F) != 0) superChipForms |= 1 << 0;	// 00Cn - Scroll down
+				else if (lowByte == 0xFB) superChipForms |= 1 << 1;									// 00FB - Scroll right
+				else if (lowByte == 0xFC) superChipForms |= 1 << 2;									// 00FC - Scroll left
+				else if (lowByte == 0xFD) superChipForms |= 1 << 3;									// 00FD - Exit
+				else if (lowByte == 0xFE || lowByte == 0xFF) superChipForms |= 1 << 4;				// 00FE/00FF - Low/high resolution
+				else if ((lowByte & 0xF0) == 0xD0 && (lowByte & 0x0F) != 0) xoChipForms |= 1 << 0;	// 00Dn - Scroll up
+				break;
+			}
+			case 0x5000:
+			{
+				if ((opcode & 0x000F) == 0x2 || (opcode & 0x000F) == 0x3) xoChipForms |= 1 << 1;		// 5XY2/5XY3 - Save/load register range
+				break;
+			}
+			case 0xF000:
+			{
+				if (opcode == 0xF000) xoChipForms |= 1 << 2;											// F000 nnnn - Long I
+				else if (lowByte == 0x01) xoChipForms |= 1 << 3;										// Fn01 - Select plane
+				else if (opcode == 0xF002) xoChipForms |= 1 << 4;										// F002 - Load audio pattern
+				else if (lowByte == 0x3A) xoChipForms |= 1 << 5;										// Fx3A - Pitch
+				else if (lowByte == 0x30) superChipForms |= 1 << 5;										// Fx30 - Large font
+				else if (lowByte == 0x75 || lowByte == 0x85) superChipForms |= 1 << 6;				// Fx75/Fx85 - Save/load flags
+				break;
+			}
+		}
+	}
+
+	auto formCount = [](uint32_t forms)
+	{
+		int count = 0;
+
+		for (; forms != 0; forms &= forms - 1)
+		{
+			count++;
+		}
+
+		return count;
+	};
+
+	if (formCount(xoChipForms) >= 2)
+		return RomPlatform::XoChip;
+
+	if (formCount(superChipForms) >= 2)
+		return RomPlatform::SuperChip;
+
+	return RomPlatform::Chip8;
+}
+
+const char* RomLibrary::PlatformName(RomPlatform platform)
+{
+	switch (platform)
+	{
+		case RomPlatform::SuperChip: return "SCHIP";
+		case RomPlatform::XoChip: return "XO-CHIP";
+		default: return "CHIP-8";
+	}
+}
+
+QuirkProfile RomLibrary::DefaultQuirkProfile(RomPlatform platform)
+{
+	switch (platform)
+	{
+		case RomPlatform::SuperChip: return QuirkProfile::SuperChip;
+		case RomPlatform::XoChip: return QuirkProfile::Modern;
+		default: return QuirkProfile::CosmacVip;
+	}
+}
+
+uint32_t RomLibrary::DefaultInstructionsPerFrame(RomPlatform platform)
+{
+	switch (platform)
+	{
+		case RomPlatform::SuperChip: return 30;
+		case RomPlatform::XoChip: return 1000;
+		default: return 10;
+	}
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "EmulatorCommon.h"
+
+#include "Quirks.h"
+
+#include <filesystem>
+#include <vector>
+
+/**
+ * Platform a ROM appears to be written for, guessed from the instructions it contains
+ */
+enum class RomPlatform : uint8_t
+{
+	Chip8,
+	SuperChip,
+	XoChip
+};
+
+/*
+* Catalogue of every ROM under a folder, with cached metadata so it can be searched without touching the ROMs themselves.
+*
+* Each ROM's size, modification time, content hash, detected platform and preferred speed are kept in an index file. Rescanning only
+* re-reads ROMs whose size or modification time have changed, so keeping a large collection up to date only costs a directory walk.
+*/
+class RomLibrary
+{
+public:
+	struct RomEntry
+	{
+		std::filesystem::path Path;
+
+		// File name (UTF-8), shown in the library and used for searching
+		std::string Name;
+
+		uint64_t Size;
+
+		// Last write time of the file, in ticks of the filesystem clock. Only ever compared for equality.
+		int64_t ModifiedTime;
+
+		// FNV-1a hash of the ROM's contents (Same as 'RomBundle::HashRom')
+		uint64_t Hash;
+
+		RomPlatform Platform;
+
+		// Number of instructions to run per 60Hz frame
+		uint32_t InstructionsPerFrame;
+	};
+
+	// What the last scan did
+	struct ScanStats
+	{
+		size_t Files = 0;
+		size_t Hashed = 0;
+		size_t Removed = 0;
+		double Milliseconds = 0.0;
+	};
+
+public:
+	/// <summary>
+	/// Loads the library from an index file written by SaveIndex
+	/// </summary>
+	/// <param name="indexPath">Path of the index file</param>
+	/// <returns>True if the index was loaded. False if it doesn't exist or isn't a library index</returns>
+	bool LoadIndex(const std::filesystem::path& indexPath);
+
+	/// <summary>
+	/// Writes the library to an index file so it can be reloaded without rescanning
+	/// </summary>
+	/// <param name="indexPath">Path of the index file. Overwritten if it exists.</param>
+	/// <returns>True if the index was written. Otherwise false</returns>
+	bool SaveIndex(const std::filesystem::path& indexPath) const;
+
+	/// <summary>
+	/// Brings the library up to date with the ROMs under a folder (Including sub-folders). ROMs whose size and modification time
+	/// match the index are kept as they are, new and changed ROMs are hashed and ROMs that no longer exist are removed.
+	/// Scanning a different folder to last time replaces the whole library.
+	/// </summary>
+	/// <param name="rootPath">Folder to scan</param>
+	/// <returns>True if the folder was scanned. False if it doesn't exist</returns>
+	bool Scan(const std::filesystem::path& rootPath);
+
+	/// <summary>
+	/// Gets every ROM in the library, sorted by name
+	/// </summary>
+	const std::vector<RomEntry>& Entries() const { return m_Entries; }
+
+	/// <summary>
+	/// Gets the folder the library was last scanned from
+	/// </summary>
+	const std::filesystem::path& RootPath() const { return m_RootPath; }
+
+	/// <summary>
+	/// Gets what the most recent scan did
+	/// </summary>
+	const ScanStats& LastScan() const { return m_LastScan; }
+
+	/// <summary>
+	/// Guesses which platform a ROM was written for from the instructions it uses. A platform is only picked if at least two
+	/// different instructions unique to it appear, as a single match is just as likely to be sprite data.
+	/// </summary>
+	/// <param name="data">Contents of the ROM</param>
+	/// <param name="size">Size of the ROM in bytes</param>
+	static RomPlatform DetectPlatform(const uint8_t* data, size_t size);
+
+	/// <summary>
+	/// Gets the display name of a platform
+	/// </summary>
+	static const char* PlatformName(RomPlatform platform);
+
+	/// <summary>
+	/// Gets the speed ROMs for a platform are usually written for, in instructions per 60Hz frame
+	/// </summary>
+	static uint32_t DefaultInstructionsPerFrame(RomPlatform platform);
+
+	/// <summary>
+	/// Gets the quirks ROMs for a platform usually expect
+	/// </summary>
+	static QuirkProfile DefaultQuirkProfile(RomPlatform platform);
+
+private:
+	/// <summary>
+	/// Reads a ROM from disk and fills in its hash, platform and speed
+	/// </summary>
+	/// <returns>True if the ROM could be read. Otherwise false</returns>
+	static bool HashEntry(RomEntry& entry);
+
+private:
+	// First field of the first line of an index file
+	static constexpr const char* k_IndexSignature = "CHIP8-ROM-LIBRARY";
+	static constexpr uint32_t k_IndexVersion = 1;
+
+	// Extensions of the files picked up when scanning
+	static constexpr const char* k_RomExtensions[5] = { ".ch8", ".c8", ".sc8", ".xo8", ".bin" };
+
+	std::vector<RomEntry> m_Entries;
+
+	std::filesystem::path m_RootPath;
+
+	ScanStats m_LastScan;
+};
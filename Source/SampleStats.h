@@ -0,0 +1,60 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+
+#include "RingBuffer.h"
+
+/*
+* Percentiles and histograms over a history of samples, such as frame times or input latencies
+*/
+class SampleStats
+{
+public:
+	/// <summary>
+	/// Gets the value below which the specified percentage of samples fall
+	/// </summary>
+	/// <param name="samples">History of samples</param>
+	/// <param name="scratch">Space the samples are copied to so they can be partially sorted without disturbing the history</param>
+	/// <param name="percentile">The percentile to calculate, between 0 and 100</param>
+	/// <returns>The value at that percentile, or 0 if there are no samples</returns>
+	template<size_t Capacity>
+	static float Percentile(const RingBuffer<float, Capacity>& samples, std::array<float, Capacity>& scratch, float percentile)
+	{
+		const size_t count = samples.Size();
+
+		if (count == 0)
+			return 0.0f;
+
+		for (size_t i = 0; i < count; i++)
+		{
+			scratch[i] = samples[i];
+		}
+
+		size_t rank = static_cast<size_t>((percentile / 100.0f) * (count - 1) + 0.5f);
+		rank = std::min(rank, count - 1);
+
+		std::nth_element(scratch.begin(), scratch.begin() + rank, scratch.begin() + count);
+
+		return scratch[rank];
+	}
+
+	/// <summary>
+	/// Counts the samples that fall into each bucket of a histogram. The final bucket holds everything above the others.
+	/// </summary>
+	/// <param name="samples">History of samples</param>
+	/// <param name="bucketWidth">Range of values each bucket covers</param>
+	/// <param name="histogram">Receives the number of samples in each bucket</param>
+	template<size_t Capacity, size_t Buckets>
+	static void FillHistogram(const RingBuffer<float, Capacity>& samples, float bucketWidth, std::array<float, Buckets>& histogram)
+	{
+		histogram.fill(0.0f);
+
+		for (size_t i = 0; i < samples.Size(); i++)
+		{
+			size_t bucket = static_cast<size_t>(std::max(samples[i], 0.0f) / bucketWidth);
+
+			histogram[std::min(bucket, Buckets - 1)] += 1.0f;
+		}
+	}
+};
@@ -208,4 +208,374 @@ const uint8_t Sprites::Font[] = {
 	0b11110000,
 	0b10000000,
 	0b10000000
+};
+
+const uint8_t Sprites::BigFont[] = {
+/*
+	********
+	********
+	**    **
+	**    **
+	**    **
+	**    **
+	**    **
+	**    **
+	********
+	********
+*/
+	0b11111111,
+	0b11111111,
+	0b11000011,
+	0b11000011,
+	0b11000011,
+	0b11000011,
+	0b11000011,
+	0b11000011,
+	0b11111111,
+	0b11111111,
+
+/*
+	   **
+	 ****
+	 ****
+	   **
+	   **
+	   **
+	   **
+	   **
+	********
+	********
+*/
+	0b00011000,
+	0b01111000,
+	0b01111000,
+	0b00011000,
+	0b00011000,
+	0b00011000,
+	0b00011000,
+	0b00011000,
+	0b11111111,
+	0b11111111,
+
+/*
+	********
+	********
+	      **
+	      **
+	********
+	********
+	**
+	**
+	********
+	********
+*/
+	0b11111111,
+	0b11111111,
+	0b00000011,
+	0b00000011,
+	0b11111111,
+	0b11111111,
+	0b11000000,
+	0b11000000,
+	0b11111111,
+	0b11111111,
+
+/*
+	********
+	********
+	      **
+	      **
+	********
+	********
+	      **
+	      **
+	********
+	********
+*/
+	0b11111111,
+	0b11111111,
+	0b00000011,
+	0b00000011,
+	0b11111111,
+	0b11111111,
+	0b00000011,
+	0b00000011,
+	0b11111111,
+	0b11111111,
+
+/*
+	**    **
+	**    **
+	**    **
+	**    **
+	********
+	********
+	      **
+	      **
+	      **
+	      **
+*/
+	0b11000011,
+	0b11000011,
+	0b11000011,
+	0b11000011,
+	0b11111111,
+	0b11111111,
+	0b00000011,
+	0b00000011,
+	0b00000011,
+	0b00000011,
+
+/*
+	********
+	********
+	**
+	**
+	********
+	********
+	      **
+	      **
+	********
+	********
+*/
+	0b11111111,
+	0b11111111,
+	0b11000000,
+	0b11000000,
+	0b11111111,
+	0b11111111,
+	0b00000011,
+	0b00000011,
+	0b11111111,
+	0b11111111,
+
+/*
+	********
+	********
+	**
+	**
+	********
+	********
+	**    **
+	**    **
+	********
+	********
+*/
+	0b11111111,
+	0b11111111,
+	0b11000000,
+	0b11000000,
+	0b11111111,
+	0b11111111,
+	0b11000011,
+	0b11000011,
+	0b11111111,
+	0b11111111,
+
+/*
+	********
+	********
+	      **
+	      **
+	     **
+	    **
+	   **
+	   **
+	   **
+	   **
+*/
+	0b11111111,
+	0b11111111,
+	0b00000011,
+	0b00000011,
+	0b00000110,
+	0b00001100,
+	0b00011000,
+	0b00011000,
+	0b00011000,
+	0b00011000,
+
+/*
+	********
+	********
+	**    **
+	**    **
+	********
+	********
+	**    **
+	**    **
+	********
+	********
+*/
+	0b11111111,
+	0b11111111,
+	0b11000011,
+	0b11000011,
+	0b11111111,
+	0b11111111,
+	0b11000011,
+	0b11000011,
+	0b11111111,
+	0b11111111,
+
+/*
+	********
+	********
+	**    **
+	**    **
+	********
+	********
+	      **
+	      **
+	********
+	********
+*/
+	0b11111111,
+	0b11111111,
+	0b11000011,
+	0b11000011,
+	0b11111111,
+	0b11111111,
+	0b00000011,
+	0b00000011,
+	0b11111111,
+	0b11111111,
+
+/*
+	 ******
+	********
+	**    **
+	**    **
+	**    **
+	********
+	********
+	**    **
+	**    **
+	**    **
+*/
+	0b01111110,
+	0b11111111,
+	0b11000011,
+	0b11000011,
+	0b11000011,
+	0b11111111,
+	0b11111111,
+	0b11000011,
+	0b11000011,
+	0b11000011,
+
+/*
+	******
+	******
+	**    **
+	**    **
+	******
+	******
+	**    **
+	**    **
+	******
+	******
+*/
+	0b11111100,
+	0b11111100,
+	0b11000011,
+	0b11000011,
+	0b11111100,
+	0b11111100,
+	0b11000011,
+	0b11000011,
+	0b11111100,
+	0b11111100,
+
+/*
+	  ****
+	********
+	**    **
+	**
+	**
+	**
+	**
+	**    **
+	********
+	  ****
+*/
+	0b00111100,
+	0b11111111,
+	0b11000011,
+	0b11000000,
+	0b11000000,
+	0b11000000,
+	0b11000000,
+	0b11000011,
+	0b11111111,
+	0b00111100,
+
+/*
+	******
+	*******
+	**    **
+	**    **
+	**    **
+	**    **
+	**    **
+	**    **
+	*******
+	******
+*/
+	0b11111100,
+	0b11111110,
+	0b11000011,
+	0b11000011,
+	0b11000011,
+	0b11000011,
+	0b11000011,
+	0b11000011,
+	0b11111110,
+	0b11111100,
+
+/*
+	********
+	********
+	**
+	**
+	********
+	********
+	**
+	**
+	********
+	********
+*/
+	0b11111111,
+	0b11111111,
+	0b11000000,
+	0b11000000,
+	0b11111111,
+	0b11111111,
+	0b11000000,
+	0b11000000,
+	0b11111111,
+	0b11111111,
+
+/*
+	********
+	********
+	**
+	**
+	********
+	********
+	**
+	**
+	**
+	**
+*/
+	0b11111111,
+	0b11111111,
+	0b11000000,
+	0b11000000,
+	0b11111111,
+	0b11111111,
+	0b11000000,
+	0b11000000,
+	0b11000000,
+	0b11000000
 };
\ No newline at end of file
@@ -16,4 +16,13 @@ public:
 
 	// Starting address of the Fonts in memory
 	static const uint16_t FONT_START = 0;
+
+	// Array of the 16 large (8x10) characters used by SCHIP's high resolution mode. Each character is made up of 10 bytes.
+	static const uint8_t BigFont[];
+
+	// Total size of the 'BigFont' array (10 bytes per sprite, 16 sprites in total)
+	static const uint8_t BIG_FONT_SIZE = 10 * 16;
+
+	// Starting address of the large Fonts in memory (Straight after the small ones)
+	static const uint16_t BIG_FONT_START = FONT_START + FONT_SIZE;
 };
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include "WavWriter.h"
+
+#include <algorithm>
+#include <limits>
+
+WavWriter::~WavWriter()
+{
+	Close();
+}
+
+bool WavWriter::Open(const std::filesystem::path& path, uint32_t sampleRate)
+{
+	Close();
+
+	m_File.open(path, std::ios::binary | std::ios::trunc);
+
+	if (!m_File.is_open())
+	{
+		std::cout << "ERROR: Failed to create WAV file '" << path.u8string() << "'" << std::endl;
+		return false;
+	}
+
+	m_DataSize = 0;
+
+	const uint16_t channels = 1;
+	const uint16_t bitsPerSample = 16;
+	const uint16_t blockAlign = channels * bitsPerSample / 8;
+
+	// RIFF header. The sizes are filled in by Close.
+	m_File.write("RIFF", 4);
+	WriteValue<uint32_t>(0);
+	m_File.write("WAVE", 4);
+
+	m_File.write("fmt ", 4);
+	WriteValue<uint32_t>(16);
+	WriteValue<uint16_t>(1);	// PCM
+	WriteValue<uint16_t>(channels);
+	WriteValue<uint32_t>(sampleRate);
+	WriteValue<uint32_t>(sampleRate * blockAlign);
+	WriteValue<uint16_t>(blockAlign);
+	WriteValue<uint16_t>(bitsPerSample);
+
+	m_File.write("data", 4);
+	WriteValue<uint32_t>(0);
+
+	return m_File.good();
+}
+
+void WavWriter::Write(const int16_t* samples, size_t count)
+{
+	if (!m_File.is_open())
+		return;
+
+	// Converted a block at a time so the stream isn't called for every sample
+	char bytes[1024 * sizeof(int16_t)];
+
+	for (size_t start = 0; start < count; start += 1024)
+	{
+		const size_t blockCount = std::min<size_t>(count - start, 1024);
+
+		for (size_t i = 0; i < blockCount; i++)
+		{
+			const uint16_t sample = static_cast<uint16_t>(samples[start + i]);
+
+			bytes[i * 2] = static_cast<char>(sample & 0xFF);
+			bytes[i * 2 + 1] = static_cast<char>(sample >> 8);
+		}
+
+		m_File.write(bytes, blockCount * sizeof(int16_t));
+	}
+
+	m_DataSize += count * sizeof(int16_t);
+}
+
+bool WavWriter::Close()
+{
+	if (!m_File.is_open())
+		return false;
+
+	// Sizes are 32-bit, so anything past 4GB is left out of the header (Players stop at that point)
+	const uint32_t dataSize = static_cast<uint32_t>(std::min<uint64_t>(m_DataSize, std::numeric_limits<uint32_t>::max() - 36));
+
+	m_File.seekp(4);
+	WriteValue<uint32_t>(36 + dataSize);
+
+	m_File.seekp(40);
+	WriteValue<uint32_t>(dataSize);
+
+	const bool bIsWritten = m_File.good();
+
+	m_File.close();
+
+	return bIsWritten;
+}
+
+template<typename T>
+void WavWriter::WriteValue(T value)
+{
+	// WAV files are little-endian whatever the host is
+	char bytes[sizeof(T)];
+
+	for (size_t i = 0; i < sizeof(T); i++)
+	{
+		bytes[i] = static_cast<char>((static_cast<uint64_t>(value) >> (i * 8)) & 0xFF);
+	}
+
+	m_File.write(bytes, sizeof(T));
+}
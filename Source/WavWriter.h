@@ -0,0 +1,60 @@
+#pragma once
+
+#include "EmulatorCommon.h"
+
+#include <filesystem>
+
+/*
+* Streams mono 16-bit PCM samples to a WAV file.
+*
+* The header is written up front with empty sizes and filled in by Close, so samples can be written as they're rendered without
+* holding the whole recording in memory.
+*/
+class WavWriter
+{
+public:
+	WavWriter() = default;
+	~WavWriter();
+
+	WavWriter(const WavWriter&) = delete;
+	WavWriter& operator=(const WavWriter&) = delete;
+
+	/// <summary>
+	/// Creates a WAV file and writes its header. Closes any file that's already open.
+	/// </summary>
+	/// <param name="path">Path of the file to write. Overwritten if it exists.</param>
+	/// <param name="sampleRate">Rate the samples will be played at (Hz)</param>
+	/// <returns>True if the file was created. Otherwise false</returns>
+	bool Open(const std::filesystem::path& path, uint32_t sampleRate);
+
+	/// <summary>
+	/// Appends samples to the file
+	/// </summary>
+	/// <param name="samples">Mono, signed 16-bit samples</param>
+	/// <param name="count">Number of samples</param>
+	void Write(const int16_t* samples, size_t count);
+
+	/// <summary>
+	/// Fills in the sizes in the header and closes the file
+	/// </summary>
+	/// <returns>True if everything was written successfully. Otherwise false</returns>
+	bool Close();
+
+	/// <summary>
+	/// Checks if a file is open
+	/// </summary>
+	bool IsOpen() const { return m_File.is_open(); }
+
+private:
+	/// <summary>
+	/// Writes a little-endian value to the file
+	/// </summary>
+	template<typename T>
+	void WriteValue(T value);
+
+private:
+	std::ofstream m_File;
+
+	// Bytes of sample data written since the file was opened
+	uint64_t m_DataSize = 0;
+};
@@ -4,109 +4,220 @@
 
 #include "imgui.h"
 
-#include <map>
-#include <list>
 #include <cmath>
 #include <array>
 #include <vector>
 #include <memory>
 #include <iostream>
+#include <cassert>
+#include <cstring>
 #include <algorithm>
-#include <functional>
-#include <unordered_map>
+#include <cfloat>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 namespace
 {
 	struct Device* CurrentDevice = nullptr;
 
-	namespace TupleHash
+	// Compact triangle cache key. Every field that affects the rasterized result is packed into 32-bit words, so comparing and hashing keys
+	// is a handful of integer operations rather than walking a tuple that includes doubles.
+	template <std::size_t WordCount> struct TriangleKey
 	{
-		template <typename T> struct Hash
+		uint32_t Words[WordCount];
+
+		bool operator==(const TriangleKey& other) const
+		{
+			return std::memcmp(Words, other.Words, sizeof(Words)) == 0;
+		}
+
+		uint32_t Hash() const
 		{
-			std::size_t operator()(const T& value) const
+			uint32_t hash = 2166136261u;
+
+			for (std::size_t i = 0; i < WordCount; i++)
 			{
-				return std::hash<T>()(value);
+				hash = (hash ^ Words[i]) * 16777619u;
 			}
-		};
 
-		template <typename T> void CombineHash(std::size_t& seed, const T& value)
-		{
-			seed ^= TupleHash::Hash<T>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+			// Final avalanche (From MurmurHash3) so the low bits used for the slot index depend on every word
+			hash ^= hash >> 16;
+			hash *= 0x85ebca6b;
+			hash ^= hash >> 13;
+			hash *= 0xc2b2ae35;
+			hash ^= hash >> 16;
+
+			return hash;
 		}
+	};
+
+	// Packs a pair of signed 16-bit values into a single key word.
+	inline uint32_t PackKeyWord(int low, int high)
+	{
+		return static_cast<uint32_t>(static_cast<uint16_t>(low)) | (static_cast<uint32_t>(static_cast<uint16_t>(high)) << 16);
+	}
+
+	inline uint32_t FloatKeyWord(float value)
+	{
+		uint32_t word;
+		std::memcpy(&word, &value, sizeof(word));
+		return word;
+	}
+
+	// Location of a cached triangle inside one of the atlas pages.
+	struct AtlasRegion
+	{
+		uint16_t Page;
+		uint16_t X, Y, Width, Height;
+	};
+
+	// Fixed capacity open-addressing hash table (linear probing) mapping triangle keys to atlas regions. All slots live in one
+	// flat array, so inserting never allocates. Entries are never removed individually, instead the owner clears the whole table
+	// when it fills up (See Device::FlushTriangleCaches).
+	template <typename Key, std::size_t Capacity> class FlatTriangleCache
+	{
+		static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
 
-		template <typename Tuple, std::size_t Index = std::tuple_size<Tuple>::value - 1> struct Hasher
+	public:
+		FlatTriangleCache() : Slots(new Slot[Capacity]) { Clear(); }
+
+		const AtlasRegion* Find(const Key& key) const
 		{
-			static void Hash(std::size_t& seed, const Tuple& tuple)
+			for (std::size_t index = key.Hash() & (Capacity - 1);; index = (index + 1) & (Capacity - 1))
 			{
-				Hasher<Tuple, Index - 1>::Hash(seed, tuple);
-				CombineHash(seed, std::get<Index>(tuple));
+				const Slot& slot = Slots[index];
+
+				if (!slot.IsUsed)
+					return nullptr;
+
+				if (slot.SlotKey == key)
+					return &slot.Region;
 			}
-		};
+		}
 
-		template <typename Tuple> struct Hasher<Tuple, 0>
+		// The key must not already be in the cache and the cache must not be full.
+		void Insert(const Key& key, const AtlasRegion& region)
 		{
-			static void Hash(std::size_t& seed, const Tuple& tuple)
+			assert(!IsFull());
+
+			std::size_t index = key.Hash() & (Capacity - 1);
+
+			while (Slots[index].IsUsed)
 			{
-				CombineHash(seed, std::get<0>(tuple));
+				index = (index + 1) & (Capacity - 1);
 			}
-		};
 
-		template <typename... T> struct Hash<std::tuple<T...>>
+			Slots[index].SlotKey = key;
+			Slots[index].Region = region;
+			Slots[index].IsUsed = true;
+
+			Count++;
+		}
+
+		// Full once three quarters of the slots are used, beyond which probe sequences get long.
+		bool IsFull() const { return Count >= (Capacity / 4) * 3; }
+
+		void Clear()
 		{
-			std::size_t operator()(const std::tuple<T...>& value) const
+			for (std::size_t i = 0; i < Capacity; i++)
 			{
-				std::size_t seed = 0;
-				Hasher<std::tuple<T...>>::Hash(seed, value);
-				return seed;
+				Slots[i].IsUsed = false;
 			}
+
+			Count = 0;
+		}
+
+	private:
+		struct Slot
+		{
+			Key SlotKey;
+			AtlasRegion Region;
+			bool IsUsed;
 		};
-	}
 
-	template <typename Key, typename Value, std::size_t Size> class LRUCache
+		std::unique_ptr<Slot[]> Slots;
+		std::size_t Count = 0;
+	};
+
+	// A few large textures that cached triangles are packed into with a simple shelf packer, so caching a triangle doesn't create
+	// (and evicting one doesn't destroy) a texture of its own.
+	class TriangleAtlas
 	{
 	public:
-		bool Contains(const Key& key) const
+		static constexpr int PageCount = 4;
+		static constexpr int PageSize = 1024;
+
+		// Triangles larger than this in either direction aren't cached, they'd use up a shelf each.
+		static constexpr int MaxCachedSize = 256;
+
+		~TriangleAtlas()
 		{
-			return Container.find(key) != Container.end();
+			for (SDL_Texture* page : Pages)
+			{
+				if (page) SDL_DestroyTexture(page);
+			}
 		}
 
-		const Value& At(const Key& key)
+		void Initialize(SDL_Renderer* renderer)
 		{
-			assert(Contains(key));
+			for (SDL_Texture*& page : Pages)
+			{
+				// RGBA32 is byte order R, G, B, A, which matches the packing of ImGui colors (and Color::ToInt) on little endian hosts.
+				page = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, PageSize, PageSize);
+				SDL_SetTextureBlendMode(page, SDL_BLENDMODE_BLEND);
+			}
 
-			const auto location = Container.find(key);
-			Order.splice(Order.begin(), Order, location->second);
-			return location->second->second;
+			Clear();
 		}
 
-		void Insert(const Key& key, Value value)
+		bool Allocate(int width, int height, AtlasRegion& region)
 		{
-			const auto existingLocation = Container.find(key);
-			if (existingLocation != Container.end())
+			if (width > MaxCachedSize || height > MaxCachedSize)
+				return false;
+
+			while (CurrentPage < PageCount)
 			{
-				Order.erase(existingLocation->second);
-				Container.erase(existingLocation);
-			}
+				// Start a new shelf when the triangle doesn't fit on the end of the current one.
+				if (ShelfX + width > PageSize)
+				{
+					ShelfY += ShelfHeight;
+					ShelfX = 0;
+					ShelfHeight = 0;
+				}
+
+				if (ShelfY + height <= PageSize)
+				{
+					region = AtlasRegion{ static_cast<uint16_t>(CurrentPage), static_cast<uint16_t>(ShelfX), static_cast<uint16_t>(ShelfY),
+						static_cast<uint16_t>(width), static_cast<uint16_t>(height) };
+
+					ShelfX += width;
+					ShelfHeight = std::max(ShelfHeight, height);
+
+					return true;
+				}
 
-			Order.push_front(std::make_pair(key, std::move(value)));
-			Container.insert(std::make_pair(key, Order.begin()));
+				CurrentPage++;
+				ShelfX = ShelfY = ShelfHeight = 0;
+			}
 
-			Clean();
+			return false;
 		}
-	private:
-		void Clean()
+
+		void Clear()
 		{
-			while (Container.size() > Size)
-			{
-				auto last = Order.end();
-				last--;
-				Container.erase(last->first);
-				Order.pop_back();
-			}
+			CurrentPage = 0;
+			ShelfX = ShelfY = ShelfHeight = 0;
 		}
 
-		std::list<std::pair<Key, Value>> Order;
-		std::unordered_map<Key, decltype(Order.begin()), TupleHash::Hash<Key>> Container;
+		SDL_Texture* Page(int index) const { return Pages[index]; }
+
+	private:
+		std::array<SDL_Texture*, PageCount> Pages = {};
+
+		int CurrentPage = 0;
+		int ShelfX = 0, ShelfY = 0, ShelfHeight = 0;
 	};
 
 	struct Color
@@ -148,29 +259,33 @@ namespace
 			int X, Y, Width, Height;
 		} Clip;
 
-		struct TriangleCacheItem
-		{
-			SDL_Texture* Texture = nullptr;
-			int Width = 0, Height = 0;
+		// You can tweak these to values that you find that work the best. They must be powers of two.
+		static constexpr std::size_t UniformColorTriangleCacheSize = 4096;
+		static constexpr std::size_t GenericTriangleCacheSize = 1024;
 
-			~TriangleCacheItem() { if (Texture) SDL_DestroyTexture(Texture); }
-		};
+		// Uniform color is identified by its color and the (offset) fixed point coordinates of the vertices.
+		using UniformColorTriangleKey = TriangleKey<4>;
+		// The generic triangle cache unfortunately has to be basically a full representation of the triangle.
+		// This includes the (offset) fixed point vertex positions, the bit patterns of the texture coordinates and the vertex colors.
+		using GenericTriangleKey = TriangleKey<12>;
 
-		// You can tweak these to values that you find that work the best.
-		static constexpr std::size_t UniformColorTriangleCacheSize = 512;
-		static constexpr std::size_t GenericTriangleCacheSize = 64;
+		FlatTriangleCache<UniformColorTriangleKey, UniformColorTriangleCacheSize> UniformColorTriangleCache;
+		FlatTriangleCache<GenericTriangleKey, GenericTriangleCacheSize> GenericTriangleCache;
 
-		// Uniform color is identified by its color and the coordinates of the edges.
-		using UniformColorTriangleKey = std::tuple<uint32_t, int, int, int, int, int, int>;
-		// The generic triangle cache unfortunately has to be basically a full representation of the triangle.
-		// This includes the (offset) vertex positions, texture coordinates and vertex colors.
-		using GenericTriangleVertexKey = std::tuple<int, int, double, double, uint32_t>;
-		using GenericTriangleKey = std::tuple<GenericTriangleVertexKey, GenericTriangleVertexKey, GenericTriangleVertexKey>;
+		TriangleAtlas Atlas;
 
-		LRUCache<UniformColorTriangleKey, std::unique_ptr<TriangleCacheItem>, UniformColorTriangleCacheSize> UniformColorTriangleCache;
-		LRUCache<GenericTriangleKey, std::unique_ptr<TriangleCacheItem>, GenericTriangleCacheSize> GenericTriangleCache;
+		// CPU-side pixel buffer triangles are rasterized into before being uploaded. Reused between triangles so rasterizing doesn't allocate.
+		std::vector<uint32_t> PixelScratch;
 
-		Device(SDL_Renderer* renderer) : Renderer(renderer) { }
+		Device(SDL_Renderer* renderer) : Renderer(renderer) { Atlas.Initialize(renderer); }
+
+		// Empties both triangle caches and the atlas they share. Called when either cache or the atlas runs out of space.
+		void FlushTriangleCaches()
+		{
+			UniformColorTriangleCache.Clear();
+			GenericTriangleCache.Clear();
+			Atlas.Clear();
+		}
 
 		void SetClipRect(const ClipRect& rect)
 		{
@@ -182,28 +297,13 @@ namespace
 		void EnableClip() { SetClipRect(Clip); }
 		void DisableClip() { SDL_RenderSetClipRect(Renderer, nullptr); }
 
-		void SetAt(int x, int y, const Color& color)
-		{
-			color.UseAsDrawColor(Renderer);
-			SDL_RenderDrawPoint(Renderer, x, y);
-		}
-
 		SDL_Texture* MakeTexture(int width, int height)
 		{
-			SDL_Texture* texture = SDL_CreateTexture(Renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET, width, height);
+			// RGBA32 is byte order R, G, B, A, which matches the packing of ImGui colors (and Color::ToInt) on little endian hosts.
+			SDL_Texture* texture = SDL_CreateTexture(Renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, width, height);
 			SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
 			return texture;
 		}
-
-		void UseAsRenderTarget(SDL_Texture* texture)
-		{
-			SDL_SetRenderTarget(Renderer, texture);
-			if (texture)
-			{
-				SDL_SetRenderDrawColor(Renderer, 0, 0, 0, 0);
-				SDL_RenderClear(Renderer);
-			}
-		}
 	};
 
 	struct Texture
@@ -314,7 +414,9 @@ namespace
 		}
 	};
 
-	void DrawTriangleWithColorFunction(const FixedPointTriangleRenderInfo& renderInfo, const std::function<Color(float x, float y)>& colorFunction, Device::TriangleCacheItem* cacheItem)
+	// Walks the pixel centres of [minX, maxX) x [minY, maxY) in row order and calls visitor(x, y, isInside) for each of them. The region is
+	// normally the triangle's bounding box but may be a smaller part of it, e.g. when the triangle is clipped.
+	template <typename Visitor> void ScanTriangle(const FixedPointTriangleRenderInfo& renderInfo, int minX, int minY, int maxX, int maxY, const Visitor& visitor)
 	{
 		// Implementation source: https://web.archive.org/web/20171128164608/http://forum.devmaster.net/t/advanced-rasterization/6145.
 		// This is a fixed point implementation that rounds to top-left.
@@ -335,10 +437,6 @@ namespace
 		const int fixedDeltaY23 = deltaY23 << 4;
 		const int fixedDeltaY31 = deltaY31 << 4;
 
-		const int width = renderInfo.MaxX - renderInfo.MinX;
-		const int height = renderInfo.MaxY - renderInfo.MinY;
-		if (width == 0 || height == 0) return;
-
 		int c1 = deltaY12 * renderInfo.X1 - deltaX12 * renderInfo.Y1;
 		int c2 = deltaY23 * renderInfo.X2 - deltaX23 * renderInfo.Y2;
 		int c3 = deltaY31 * renderInfo.X3 - deltaX31 * renderInfo.Y3;
@@ -347,49 +445,92 @@ namespace
 		if (deltaY23 < 0 || (deltaY23 == 0 && deltaX23 > 0)) c2++;
 		if (deltaY31 < 0 || (deltaY31 == 0 && deltaX31 > 0)) c3++;
 
-		int edgeStart1 = c1 + deltaX12 * (renderInfo.MinY << 4) - deltaY12 * (renderInfo.MinX << 4);
-		int edgeStart2 = c2 + deltaX23 * (renderInfo.MinY << 4) - deltaY23 * (renderInfo.MinX << 4);
-		int edgeStart3 = c3 + deltaX31 * (renderInfo.MinY << 4) - deltaY31 * (renderInfo.MinX << 4);
+		int edgeStart1 = c1 + deltaX12 * (minY << 4) - deltaY12 * (minX << 4);
+		int edgeStart2 = c2 + deltaX23 * (minY << 4) - deltaY23 * (minX << 4);
+		int edgeStart3 = c3 + deltaX31 * (minY << 4) - deltaY31 * (minX << 4);
 
-		SDL_Texture* cache = CurrentDevice->MakeTexture(width, height);
-		CurrentDevice->DisableClip();
-		CurrentDevice->UseAsRenderTarget(cache);
+		const int width = maxX - minX;
 
-		for (int y = renderInfo.MinY; y < renderInfo.MaxY; y++)
+		for (int y = minY; y < maxY; y++)
 		{
-			int edge1 = edgeStart1;
-			int edge2 = edgeStart2;
-			int edge3 = edgeStart3;
-
-			for (int x = renderInfo.MinX; x < renderInfo.MaxX; x++)
+			for (int i = 0; i < width; i++)
 			{
-				if (edge1 > 0 && edge2 > 0 && edge3 > 0)
-				{
-					CurrentDevice->SetAt(x - renderInfo.MinX, y - renderInfo.MinY, colorFunction(x + 0.5f, y + 0.5f));
-				}
+				// Edges at column i are evaluated directly (rather than stepped) so iterations are independent of each other.
+				const int edge1 = edgeStart1 - fixedDeltaY12 * i;
+				const int edge2 = edgeStart2 - fixedDeltaY23 * i;
+				const int edge3 = edgeStart3 - fixedDeltaY31 * i;
 
-				edge1 -= fixedDeltaY12;
-				edge2 -= fixedDeltaY23;
-				edge3 -= fixedDeltaY31;
+				visitor(minX + i, y, (edge1 > 0) & (edge2 > 0) & (edge3 > 0));
 			}
 
 			edgeStart1 += fixedDeltaX12;
 			edgeStart2 += fixedDeltaX23;
 			edgeStart3 += fixedDeltaX31;
 		}
+	}
+
+	// The color function is a template parameter rather than a std::function so it's inlined into the inner loop. For uniform colors it
+	// returns a constant, which leaves the loop as a branch-free select the compiler can vectorize.
+	template <typename ColorFunction> bool DrawTriangleWithColorFunction(const FixedPointTriangleRenderInfo& renderInfo, const ColorFunction& colorFunction)
+	{
+		// The triangle is rasterized into the device's CPU-side pixel buffer, ready to be uploaded in one go, rather than drawn a point at a time through the renderer.
+		// Returns false if the triangle doesn't cover any pixels.
+
+		const int width = renderInfo.MaxX - renderInfo.MinX;
+		const int height = renderInfo.MaxY - renderInfo.MinY;
+		if (width == 0 || height == 0) return false;
 
-		CurrentDevice->UseAsRenderTarget(nullptr);
-		CurrentDevice->EnableClip();
+		std::vector<uint32_t>& pixels = CurrentDevice->PixelScratch;
+		pixels.resize(static_cast<std::size_t>(width) * height);
+
+		uint32_t* const destination = pixels.data();
+
+		ScanTriangle(renderInfo, renderInfo.MinX, renderInfo.MinY, renderInfo.MaxX, renderInfo.MaxY, [&](int x, int y, bool isInside) {
+			destination[(y - renderInfo.MinY) * width + (x - renderInfo.MinX)] = isInside ? colorFunction(x + 0.5f, y + 0.5f) : 0u;
+		});
+
+		return true;
+	}
 
-		cacheItem->Texture = cache;
-		cacheItem->Width = width;
-		cacheItem->Height = height;
+	void DrawCachedTriangle(const AtlasRegion& region, const FixedPointTriangleRenderInfo& renderInfo)
+	{
+		const SDL_Rect source = { region.X, region.Y, region.Width, region.Height };
+		const SDL_Rect destination = { renderInfo.MinX, renderInfo.MinY, region.Width, region.Height };
+		SDL_RenderCopy(CurrentDevice->Renderer, CurrentDevice->Atlas.Page(region.Page), &source, &destination);
 	}
 
-	void DrawCachedTriangle(const Device::TriangleCacheItem& triangle, const FixedPointTriangleRenderInfo& renderInfo)
+	// Uploads the triangle that was just rasterized into the pixel scratch buffer to the atlas, records it in the cache and draws it.
+	template <typename Cache, typename Key> void CacheAndDrawTriangle(Cache& cache, const Key& key, const FixedPointTriangleRenderInfo& renderInfo)
 	{
-		const SDL_Rect destination = { renderInfo.MinX, renderInfo.MinY, triangle.Width, triangle.Height };
-		SDL_RenderCopy(CurrentDevice->Renderer, triangle.Texture, nullptr, &destination);
+		const int width = renderInfo.MaxX - renderInfo.MinX;
+		const int height = renderInfo.MaxY - renderInfo.MinY;
+
+		AtlasRegion region;
+
+		if (cache.IsFull() || !CurrentDevice->Atlas.Allocate(width, height, region))
+		{
+			CurrentDevice->FlushTriangleCaches();
+
+			if (!CurrentDevice->Atlas.Allocate(width, height, region))
+			{
+				// Too big to cache, so draw it through a throwaway texture.
+				SDL_Texture* texture = CurrentDevice->MakeTexture(width, height);
+				SDL_UpdateTexture(texture, nullptr, CurrentDevice->PixelScratch.data(), width * static_cast<int>(sizeof(uint32_t)));
+
+				const SDL_Rect destination = { renderInfo.MinX, renderInfo.MinY, width, height };
+				SDL_RenderCopy(CurrentDevice->Renderer, texture, nullptr, &destination);
+
+				SDL_DestroyTexture(texture);
+				return;
+			}
+		}
+
+		const SDL_Rect atlasRect = { region.X, region.Y, region.Width, region.Height };
+		SDL_UpdateTexture(CurrentDevice->Atlas.Page(region.Page), &atlasRect, CurrentDevice->PixelScratch.data(), width * static_cast<int>(sizeof(uint32_t)));
+
+		cache.Insert(key, region);
+
+		DrawCachedTriangle(region, renderInfo);
 	}
 
 	void DrawTriangle(const ImDrawVert& v1, const ImDrawVert& v2, const ImDrawVert& v3, const Texture* texture)
@@ -398,15 +539,19 @@ namespace
 		const auto& renderInfo = FixedPointTriangleRenderInfo::CalculateFixedPointTriangleInfo(v3.pos, v2.pos, v1.pos);
 
 		// First we check if there is a cached version of this triangle already waiting for us. If so, we can just do a super fast texture copy.
+		// Positions are the fixed point coordinates the rasterizer uses, offset to the top-left of the bounding box.
+
+		const int originX = renderInfo.MinX << 4;
+		const int originY = renderInfo.MinY << 4;
 
-		const auto key = std::make_tuple(
-			std::make_tuple(static_cast<int>(std::round(v1.pos.x)) - renderInfo.MinX, static_cast<int>(std::round(v1.pos.y)) - renderInfo.MinY, v1.uv.x, v1.uv.y, v1.col),
-			std::make_tuple(static_cast<int>(std::round(v2.pos.x)) - renderInfo.MinX, static_cast<int>(std::round(v2.pos.y)) - renderInfo.MinY, v2.uv.x, v2.uv.y, v2.col),
-			std::make_tuple(static_cast<int>(std::round(v3.pos.x)) - renderInfo.MinX, static_cast<int>(std::round(v3.pos.y)) - renderInfo.MinY, v3.uv.x, v3.uv.y, v3.col));
+		const Device::GenericTriangleKey key = { {
+			PackKeyWord(renderInfo.X3 - originX, renderInfo.Y3 - originY), FloatKeyWord(v1.uv.x), FloatKeyWord(v1.uv.y), v1.col,
+			PackKeyWord(renderInfo.X2 - originX, renderInfo.Y2 - originY), FloatKeyWord(v2.uv.x), FloatKeyWord(v2.uv.y), v2.col,
+			PackKeyWord(renderInfo.X1 - originX, renderInfo.Y1 - originY), FloatKeyWord(v3.uv.x), FloatKeyWord(v3.uv.y), v3.col
+		} };
 
-		if (CurrentDevice->GenericTriangleCache.Contains(key))
+		if (const AtlasRegion* cached = CurrentDevice->GenericTriangleCache.Find(key))
 		{
-			const auto& cached = CurrentDevice->GenericTriangleCache.At(key);
 			DrawCachedTriangle(*cached, renderInfo);
 
 			return;
@@ -417,22 +562,18 @@ namespace
 
 		const InterpolatedFactorEquation<Color> shadeColor(Color(v1.col), Color(v2.col), Color(v3.col), v1.pos, v2.pos, v3.pos);
 
-		auto cached = std::make_unique<Device::TriangleCacheItem>();
-		DrawTriangleWithColorFunction(renderInfo, [&](float x, float y) {
+		const bool hasPixels = DrawTriangleWithColorFunction(renderInfo, [&](float x, float y) {
 			const float u = textureU.Evaluate(x, y);
 			const float v = textureV.Evaluate(x, y);
 			const Color sampled = texture->Sample(u, v);
 			const Color shade = shadeColor.Evaluate(x, y);
 
-			return sampled * shade;
-		}, cached.get());
+			return (sampled * shade).ToInt();
+		});
 
-		if (!cached->Texture) return;
+		if (!hasPixels) return;
 
-		const SDL_Rect destination = { renderInfo.MinX, renderInfo.MinY, cached->Width, cached->Height };
-		SDL_RenderCopy(CurrentDevice->Renderer, cached->Texture, nullptr, &destination);
-
-		CurrentDevice->GenericTriangleCache.Insert(key, std::move(cached));
+		CacheAndDrawTriangle(CurrentDevice->GenericTriangleCache, key, renderInfo);
 	}
 
 	void DrawUniformColorTriangle(const ImDrawVert& v1, const ImDrawVert& v2, const ImDrawVert& v3)
@@ -442,27 +583,29 @@ namespace
 		// The naming inconsistency in the parameters is intentional. The fixed point algorithm wants the vertices in a counter clockwise order.
 		const auto& renderInfo = FixedPointTriangleRenderInfo::CalculateFixedPointTriangleInfo(v3.pos, v2.pos, v1.pos);
 
-		const auto key =std::make_tuple(v1.col,
-			static_cast<int>(std::round(v1.pos.x)) - renderInfo.MinX, static_cast<int>(std::round(v1.pos.y)) - renderInfo.MinY,
-			static_cast<int>(std::round(v2.pos.x)) - renderInfo.MinX, static_cast<int>(std::round(v2.pos.y)) - renderInfo.MinY,
-			static_cast<int>(std::round(v3.pos.x)) - renderInfo.MinX, static_cast<int>(std::round(v3.pos.y)) - renderInfo.MinY);
-		if (CurrentDevice->UniformColorTriangleCache.Contains(key))
+		const int originX = renderInfo.MinX << 4;
+		const int originY = renderInfo.MinY << 4;
+
+		const Device::UniformColorTriangleKey key = { {
+			v1.col,
+			PackKeyWord(renderInfo.X1 - originX, renderInfo.Y1 - originY),
+			PackKeyWord(renderInfo.X2 - originX, renderInfo.Y2 - originY),
+			PackKeyWord(renderInfo.X3 - originX, renderInfo.Y3 - originY)
+		} };
+
+		if (const AtlasRegion* cached = CurrentDevice->UniformColorTriangleCache.Find(key))
 		{
-			const auto& cached = CurrentDevice->UniformColorTriangleCache.At(key);
 			DrawCachedTriangle(*cached, renderInfo);
 
 			return;
 		}
 
-		auto cached = std::make_unique<Device::TriangleCacheItem>();
-		DrawTriangleWithColorFunction(renderInfo, [&color](float, float) { return color; }, cached.get());
-
-		if (!cached->Texture) return;
+		const uint32_t packedColor = color.ToInt();
+		const bool hasPixels = DrawTriangleWithColorFunction(renderInfo, [packedColor](float, float) { return packedColor; });
 
-		const SDL_Rect destination = { renderInfo.MinX, renderInfo.MinY, cached->Width, cached->Height };
-		SDL_RenderCopy(CurrentDevice->Renderer, cached->Texture, nullptr, &destination);
+		if (!hasPixels) return;
 
-		CurrentDevice->UniformColorTriangleCache.Insert(key, std::move(cached));
+		CacheAndDrawTriangle(CurrentDevice->UniformColorTriangleCache, key, renderInfo);
 	}
 
 	void DrawRectangle(const Rect& bounding, SDL_Texture* texture, int textureWidth, int textureHeight, const Color& color, bool doHorizontalFlip, bool doVerticalFlip)
@@ -511,134 +654,993 @@ namespace
 		SDL_QueryTexture(texture, nullptr, nullptr, &width, &height);
 		DrawRectangle(bounding, texture, width, height, color, doHorizontalFlip, doVerticalFlip);
 	}
-}
 
-namespace ImGuiSDL
-{
-	void Initialize(SDL_Renderer* renderer, int windowWidth, int windowHeight)
+	// Channel-wise product of two packed colors, as used to tint texture samples by the vertex color.
+	inline uint32_t ModulateColor(uint32_t a, uint32_t b)
 	{
-		ImGuiIO& io = ImGui::GetIO();
-		io.DisplaySize.x = static_cast<float>(windowWidth);
-		io.DisplaySize.y = static_cast<float>(windowHeight);
+		uint32_t result = 0;
 
-		ImGui::GetStyle().WindowRounding = 0.0f;
-		ImGui::GetStyle().AntiAliasedFill = false;
-		ImGui::GetStyle().AntiAliasedLines = false;
+		for (int shift = 0; shift < 32; shift += 8)
+		{
+			const uint32_t product = ((a >> shift) & 0xff) * ((b >> shift) & 0xff);
+			result |= ((product + 127) / 255) << shift;
+		}
 
-		// Loads the font texture.
-		unsigned char* pixels;
-		int width, height;
-		io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
-		static constexpr uint32_t rmask = 0x000000ff, gmask = 0x0000ff00, bmask = 0x00ff0000, amask = 0xff000000;
-		SDL_Surface* surface = SDL_CreateRGBSurfaceFrom(pixels, width, height, 32, 4 * width, rmask, gmask, bmask, amask);
+		return result;
+	}
 
-		Texture* texture = new Texture();
-		texture->Surface = surface;
-		texture->Source = SDL_CreateTextureFromSurface(renderer, surface);
-		io.Fonts->TexID = (void*)texture;
+	// Composites a packed straight alpha color over another one, matching what SDL_BLENDMODE_BLEND does when the result is later drawn.
+	inline uint32_t BlendOver(uint32_t destination, uint32_t source)
+	{
+		const uint32_t sourceAlpha = source >> 24;
+		if (sourceAlpha == 0xff) return source;
+		if (sourceAlpha == 0) return destination;
 
-		CurrentDevice = new Device(renderer);
+		const uint32_t destinationAlpha = destination >> 24;
+		if (destinationAlpha == 0) return source;
+
+		// The framebuffer holds straight (not premultiplied) alpha, so the channels are weighted by their coverage and then divided back out.
+		const uint32_t destinationWeight = (destinationAlpha * (255 - sourceAlpha) + 127) / 255;
+		const uint32_t outputAlpha = sourceAlpha + destinationWeight;
+
+		uint32_t result = outputAlpha << 24;
+
+		for (int shift = 0; shift < 24; shift += 8)
+		{
+			const uint32_t channel = ((source >> shift) & 0xff) * sourceAlpha + ((destination >> shift) & 0xff) * destinationWeight;
+			result |= ((channel + outputAlpha / 2) / outputAlpha) << shift;
+		}
+
+		return result;
 	}
 
-	void Deinitialize()
+	// Fast non-cryptographic hash of a block of memory, eight bytes at a time.
+	uint64_t HashBytes(uint64_t hash, const void* data, std::size_t size)
 	{
-		// Frees up the memory of the font texture.
-		ImGuiIO& io = ImGui::GetIO();
-		Texture* texture = static_cast<Texture*>(io.Fonts->TexID);
-		delete texture;
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
 
-		delete CurrentDevice;
+		std::size_t i = 0;
+
+		for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+		{
+			uint64_t word;
+			std::memcpy(&word, bytes + i, sizeof(word));
+
+			hash = (hash ^ word) * 0x9e3779b97f4a7c15ull;
+			hash ^= hash >> 32;
+		}
+
+		uint64_t tail = size;
+		std::memcpy(&tail, bytes + i, size - i);
+
+		hash = (hash ^ tail) * 0x9e3779b97f4a7c15ull;
+		return hash ^ (hash >> 32);
 	}
 
-	void Render(ImDrawData* drawData)
+	// Half-open rectangle of whole pixels.
+	struct PixelRect
 	{
-		SDL_BlendMode blendMode;
-		SDL_GetRenderDrawBlendMode(CurrentDevice->Renderer, &blendMode);
-		SDL_SetRenderDrawBlendMode(CurrentDevice->Renderer, SDL_BLENDMODE_BLEND);
+		int MinX, MinY, MaxX, MaxY;
 
-		Uint8 initialR, initialG, initialB, initialA;
-		SDL_GetRenderDrawColor(CurrentDevice->Renderer, &initialR, &initialG, &initialB, &initialA);
+		bool IsEmpty() const { return MinX >= MaxX || MinY >= MaxY; }
+		int Area() const { return IsEmpty() ? 0 : (MaxX - MinX) * (MaxY - MinY); }
 
-		SDL_bool initialClipEnabled = SDL_RenderIsClipEnabled(CurrentDevice->Renderer);
-		SDL_Rect initialClipRect;
-		SDL_RenderGetClipRect(CurrentDevice->Renderer, &initialClipRect);
+		bool Overlaps(const PixelRect& other) const
+		{
+			return MinX < other.MaxX && other.MinX < MaxX && MinY < other.MaxY && other.MinY < MaxY;
+		}
 
-		SDL_Texture* initialRenderTarget = SDL_GetRenderTarget(CurrentDevice->Renderer);
+		PixelRect Intersect(const PixelRect& other) const
+		{
+			return PixelRect{ std::max(MinX, other.MinX), std::max(MinY, other.MinY), std::min(MaxX, other.MaxX), std::min(MaxY, other.MaxY) };
+		}
 
-		ImGuiIO& io = ImGui::GetIO();
+		PixelRect Union(const PixelRect& other) const
+		{
+			return PixelRect{ std::min(MinX, other.MinX), std::min(MinY, other.MinY), std::max(MaxX, other.MaxX), std::max(MaxY, other.MaxY) };
+		}
 
-		for (int n = 0; n < drawData->CmdListsCount; n++)
+		SDL_Rect ToSDL() const { return SDL_Rect{ MinX, MinY, MaxX - MinX, MaxY - MinY }; }
+	};
+
+	// Renderer state that drawing ImGui changes, saved beforehand so it can be put back and doesn't leak into the rest of the frame.
+	struct SavedRenderState
+	{
+		SDL_BlendMode BlendMode;
+		Uint8 R, G, B, A;
+		SDL_bool ClipEnabled;
+		SDL_Rect ClipRect;
+		SDL_Texture* RenderTarget;
+
+		explicit SavedRenderState(SDL_Renderer* renderer)
 		{
-			auto commandList = drawData->CmdLists[n];
-			auto vertexBuffer = commandList->VtxBuffer;
-			auto indexBuffer = commandList->IdxBuffer.Data;
+			SDL_GetRenderDrawBlendMode(renderer, &BlendMode);
+			SDL_GetRenderDrawColor(renderer, &R, &G, &B, &A);
 
-			for (int cmd_i = 0; cmd_i < commandList->CmdBuffer.Size; cmd_i++)
+			ClipEnabled = SDL_RenderIsClipEnabled(renderer);
+			SDL_RenderGetClipRect(renderer, &ClipRect);
+
+			RenderTarget = SDL_GetRenderTarget(renderer);
+		}
+
+		void Restore(SDL_Renderer* renderer) const
+		{
+			SDL_SetRenderTarget(renderer, RenderTarget);
+			SDL_RenderSetClipRect(renderer, ClipEnabled ? &ClipRect : nullptr);
+			SDL_SetRenderDrawColor(renderer, R, G, B, A);
+			SDL_SetRenderDrawBlendMode(renderer, BlendMode);
+		}
+	};
+
+	// Small pool of worker threads that run one job over a range of indices. The calling thread works through the indices too, and Run
+	// returns once all of them are done. Workers sleep on a condition variable between jobs.
+	class WorkerPool
+	{
+	public:
+		explicit WorkerPool(unsigned int workerCount)
+		{
+			for (unsigned int i = 0; i < workerCount; i++)
 			{
-				const ImDrawCmd* drawCommand = &commandList->CmdBuffer[cmd_i];
+				Workers.emplace_back([this]() { WorkerLoop(); });
+			}
+		}
 
-				const Device::ClipRect clipRect = {
-					static_cast<int>(drawCommand->ClipRect.x),
-					static_cast<int>(drawCommand->ClipRect.y),
-					static_cast<int>(drawCommand->ClipRect.z - drawCommand->ClipRect.x),
-					static_cast<int>(drawCommand->ClipRect.w - drawCommand->ClipRect.y)
-				};
-				CurrentDevice->SetClipRect(clipRect);
+		~WorkerPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(Mutex);
+				IsStopping = true;
+			}
 
-				if (drawCommand->UserCallback)
+			WakeCondition.notify_all();
+
+			for (std::thread& worker : Workers)
+			{
+				worker.join();
+			}
+		}
+
+		// Number of threads that work on a job, including the calling thread
+		unsigned int ThreadCount() const { return static_cast<unsigned int>(Workers.size()) + 1; }
+
+		// Calls job(index) for every index in [0, count), spread over the pool. Jobs must be safe to run concurrently with each other.
+		template <typename Job> void Run(std::size_t count, const Job& job)
+		{
+			if (Workers.empty() || count <= 1)
+			{
+				for (std::size_t i = 0; i < count; i++)
 				{
-					drawCommand->UserCallback(commandList, drawCommand);
+					job(i);
 				}
-				else
-				{
-					const bool isWrappedTexture = drawCommand->TextureId == io.Fonts->TexID;
 
-					// Loops over triangles.
-					for (unsigned int i = 0; i + 3 <= drawCommand->ElemCount; i += 3)
-					{
-						const ImDrawVert& v0 = vertexBuffer[indexBuffer[i + 0]];
-						const ImDrawVert& v1 = vertexBuffer[indexBuffer[i + 1]];
-						const ImDrawVert& v2 = vertexBuffer[indexBuffer[i + 2]];
+				return;
+			}
 
-						const Rect& bounding = Rect::CalculateBoundingBox(v0, v1, v2);
+			{
+				std::unique_lock<std::mutex> lock(Mutex);
 
-						const bool isTriangleUniformColor = v0.col == v1.col && v1.col == v2.col;
-						const bool doesTriangleUseOnlyColor = bounding.UsesOnlyColor();
+				// A worker that woke up too late for the previous job may still be on its way out
+				DoneCondition.wait(lock, [this]() { return ActiveWorkers == 0; });
 
-						// Actually, since we render a whole bunch of rectangles, we try to first detect those, and render them more efficiently.
-						// How are rectangles detected? It's actually pretty simple: If all 6 vertices lie on the extremes of the bounding box,
-						// it's a rectangle.
-						if (i + 6 <= drawCommand->ElemCount)
-						{
-							const ImDrawVert& v3 = vertexBuffer[indexBuffer[i + 3]];
-							const ImDrawVert& v4 = vertexBuffer[indexBuffer[i + 4]];
-							const ImDrawVert& v5 = vertexBuffer[indexBuffer[i + 5]];
+				JobFunction = [](const void* context, std::size_t index) { (*static_cast<const Job*>(context))(index); };
+				JobContext = &job;
+				JobCount = count;
+				NextIndex = 0;
+				Generation++;
+			}
 
-							const bool isUniformColor = isTriangleUniformColor && v2.col == v3.col && v3.col == v4.col && v4.col == v5.col;
+			WakeCondition.notify_all();
 
-							if (isUniformColor
-							&& bounding.IsOnExtreme(v0.pos)
-							&& bounding.IsOnExtreme(v1.pos)
-							&& bounding.IsOnExtreme(v2.pos)
-							&& bounding.IsOnExtreme(v3.pos)
-							&& bounding.IsOnExtreme(v4.pos)
-							&& bounding.IsOnExtreme(v5.pos))
-							{
-								// ImGui gives the triangles in a nice order: the first vertex happens to be the topleft corner of our rectangle.
-								// We need to check for the orientation of the texture, as I believe in theory ImGui could feed us a flipped texture,
-								// so that the larger texture coordinates are at topleft instead of bottomright.
-								// We don't consider equal texture coordinates to require a flip, as then the rectangle is mostlikely simply a colored rectangle.
-								const bool doHorizontalFlip = v2.uv.x < v0.uv.x;
-								const bool doVerticalFlip = v2.uv.x < v0.uv.x;
+			Work();
 
-								if (isWrappedTexture)
-								{
-									DrawRectangle(bounding, static_cast<const Texture*>(drawCommand->TextureId), Color(v0.col), doHorizontalFlip, doVerticalFlip);
-								}
-								else
-								{
-									DrawRectangle(bounding, static_cast<SDL_Texture*>(drawCommand->TextureId), Color(v0.col), doHorizontalFlip, doVerticalFlip);
-								}
+			std::unique_lock<std::mutex> lock(Mutex);
+			DoneCondition.wait(lock, [this]() { return ActiveWorkers == 0; });
+		}
+
+	private:
+		void Work()
+		{
+			for (std::size_t index = NextIndex.fetch_add(1); index < JobCount; index = NextIndex.fetch_add(1))
+			{
+				JobFunction(JobContext, index);
+			}
+		}
+
+		void WorkerLoop()
+		{
+			uint64_t lastGeneration = 0;
+
+			for (;;)
+			{
+				{
+					std::unique_lock<std::mutex> lock(Mutex);
+					WakeCondition.wait(lock, [&]() { return IsStopping || Generation != lastGeneration; });
+
+					if (IsStopping) return;
+
+					lastGeneration = Generation;
+					ActiveWorkers++;
+				}
+
+				Work();
+
+				{
+					std::lock_guard<std::mutex> lock(Mutex);
+					ActiveWorkers--;
+				}
+
+				DoneCondition.notify_all();
+			}
+		}
+
+	private:
+		std::vector<std::thread> Workers;
+
+		std::mutex Mutex;
+		std::condition_variable WakeCondition;
+		std::condition_variable DoneCondition;
+
+		// The current job. Only changed while no worker is active, with the mutex held.
+		void (*JobFunction)(const void* context, std::size_t index) = nullptr;
+		const void* JobContext = nullptr;
+		std::size_t JobCount = 0;
+		uint64_t Generation = 0;
+
+		std::atomic<std::size_t> NextIndex{ 0 };
+		unsigned int ActiveWorkers = 0;
+		bool IsStopping = false;
+	};
+
+	// Rasterizes the whole UI on the CPU into one framebuffer, which is uploaded to a single streaming texture and drawn with one copy.
+	// Every draw command is hashed each frame and only the rectangles covered by commands that appeared, disappeared or changed since the
+	// previous frame are rasterized and uploaded again. Without a GPU each SDL draw call is itself rasterized in software, so this is far
+	// cheaper than replaying every triangle through the renderer like Render does.
+	//
+	// Dirty rectangles are cut along a grid of tiles and each primitive is binned into the pieces it overlaps, in draw order. The pieces
+	// don't overlap each other, so they're rasterized in parallel on a pool of worker threads.
+	class SoftwareCompositor
+	{
+	public:
+		// Past this many separate dirty rectangles they're merged into one, as each one is a separate upload.
+		static constexpr std::size_t MaxDirtyRects = 16;
+
+		// Width and height of the tiles dirty rectangles are split into for rasterizing in parallel
+		static constexpr int TileSize = 64;
+
+		// Upper limit on threads rasterizing tiles. Past this, full-screen redraws are limited by memory bandwidth rather than the rasterizer.
+		static constexpr unsigned int MaxThreads = 16;
+
+		explicit SoftwareCompositor(SDL_Renderer* renderer)
+			: Renderer(renderer), Pool(std::min(std::max(std::thread::hardware_concurrency(), 1u), MaxThreads) - 1) { }
+
+		~SoftwareCompositor()
+		{
+			if (Target != nullptr)
+				SDL_DestroyTexture(Target);
+		}
+
+		// Returns false, without drawing anything, if the draw data uses something the compositor can't rasterize (user callbacks or textures
+		// other than the font atlas, which only live on the GPU). The caller should then fall back to the renderer for that frame.
+		bool Render(ImDrawData* drawData)
+		{
+			if (!CollectCommands(drawData))
+			{
+				NeedsFullRedraw = true;
+				return false;
+			}
+
+			if (!EnsureTarget(static_cast<int>(drawData->DisplaySize.x), static_cast<int>(drawData->DisplaySize.y)))
+				return false;
+
+			FindDirtyRects();
+			SplitIntoPieces();
+			BinPrimitives();
+
+			Pool.Run(Pieces.size(), [this](std::size_t pieceIndex) { RasterizePiece(pieceIndex); });
+
+			LastStats = ImGuiSDL::SoftwareRenderStats{ static_cast<int>(DirtyRects.size()), 0, Width * Height, static_cast<int>(Pieces.size()), static_cast<int>(Pool.ThreadCount()) };
+
+			for (const PixelRect& dirty : DirtyRects)
+			{
+				const SDL_Rect area = dirty.ToSDL();
+				SDL_UpdateTexture(Target, &area, &Pixels[static_cast<std::size_t>(dirty.MinY) * Width + dirty.MinX], Width * static_cast<int>(sizeof(uint32_t)));
+
+				LastStats.DirtyPixels += dirty.Area();
+			}
+
+			const SavedRenderState savedState(Renderer);
+
+			SDL_RenderSetClipRect(Renderer, nullptr);
+			SDL_RenderCopy(Renderer, Target, nullptr, nullptr);
+
+			savedState.Restore(Renderer);
+
+			PreviousCommands.clear();
+
+			for (const CommandInfo& command : Commands)
+			{
+				PreviousCommands.push_back(CommandSignature{ command.Hash, command.Bounds, false });
+			}
+
+			NeedsFullRedraw = false;
+
+			return true;
+		}
+
+		const ImGuiSDL::SoftwareRenderStats& Stats() const { return LastStats; }
+
+	private:
+		struct CommandInfo
+		{
+			const ImDrawList* List;
+			const ImDrawCmd* Command;
+			unsigned int IndexOffset;
+
+			// Clip rectangle, and the area actually covered by the command's vertices within it
+			PixelRect Clip;
+			PixelRect Bounds;
+
+			uint64_t Hash;
+			bool Matched;
+		};
+
+		// A rectangle or a single triangle from a command, starting at FirstIndex within the command's indices
+		struct Primitive
+		{
+			uint32_t Command;
+			unsigned int FirstIndex;
+			bool IsRectangle;
+
+			// Pixels the primitive may cover, within its command's bounds
+			PixelRect Bounds;
+		};
+
+		// What's remembered about each command of the previous frame. The draw lists themselves are rebuilt by ImGui every frame.
+		struct CommandSignature
+		{
+			uint64_t Hash;
+			PixelRect Bounds;
+			bool Matched;
+		};
+
+		static uint64_t HashWords(uint64_t hash, const void* data, std::size_t size)
+		{
+			assert(size % sizeof(uint32_t) == 0);
+
+			const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+			for (std::size_t i = 0; i < size; i += sizeof(uint32_t))
+			{
+				uint32_t word;
+				std::memcpy(&word, bytes + i, sizeof(word));
+
+				hash = (hash ^ word) * 0x100000001b3ull;
+			}
+
+			return hash;
+		}
+
+		bool EnsureTarget(int width, int height)
+		{
+			if (Target != nullptr && width == Width && height == Height)
+				return true;
+
+			if (Target != nullptr)
+				SDL_DestroyTexture(Target);
+
+			Width = width;
+			Height = height;
+
+			Target = SDL_CreateTexture(Renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING, std::max(width, 1), std::max(height, 1));
+			if (Target == nullptr) return false;
+
+			SDL_SetTextureBlendMode(Target, SDL_BLENDMODE_BLEND);
+
+			Pixels.assign(static_cast<std::size_t>(std::max(width, 1)) * std::max(height, 1), 0u);
+			NeedsFullRedraw = true;
+
+			return true;
+		}
+
+		bool CollectCommands(ImDrawData* drawData)
+		{
+			const ImTextureID fontTexture = ImGui::GetIO().Fonts->TexID;
+
+			const PixelRect screen = { 0, 0, static_cast<int>(drawData->DisplaySize.x), static_cast<int>(drawData->DisplaySize.y) };
+
+			Commands.clear();
+
+			for (int n = 0; n < drawData->CmdListsCount; n++)
+			{
+				const ImDrawList* commandList = drawData->CmdLists[n];
+				const ImDrawVert* vertexBuffer = commandList->VtxBuffer.Data;
+				const ImDrawIdx* indexBuffer = commandList->IdxBuffer.Data;
+
+				unsigned int indexOffset = 0;
+
+				for (int cmd_i = 0; cmd_i < commandList->CmdBuffer.Size; cmd_i++)
+				{
+					const ImDrawCmd* drawCommand = &commandList->CmdBuffer[cmd_i];
+
+					if (drawCommand->UserCallback || drawCommand->TextureId != fontTexture)
+						return false;
+
+					const PixelRect clip = PixelRect{
+						static_cast<int>(std::floor(drawCommand->ClipRect.x)),
+						static_cast<int>(std::floor(drawCommand->ClipRect.y)),
+						static_cast<int>(std::ceil(drawCommand->ClipRect.z)),
+						static_cast<int>(std::ceil(drawCommand->ClipRect.w))
+					}.Intersect(screen);
+
+					float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+
+					uint64_t hash = 0xcbf29ce484222325ull;
+					hash = HashWords(hash, &clip, sizeof(clip));
+					hash = HashWords(hash, &drawCommand->ElemCount, sizeof(drawCommand->ElemCount));
+
+					for (unsigned int i = 0; i < drawCommand->ElemCount; i++)
+					{
+						const ImDrawVert& vertex = vertexBuffer[indexBuffer[indexOffset + i]];
+
+						hash = HashWords(hash, &vertex, sizeof(vertex));
+
+						minX = std::min(minX, vertex.pos.x);
+						minY = std::min(minY, vertex.pos.y);
+						maxX = std::max(maxX, vertex.pos.x);
+						maxY = std::max(maxY, vertex.pos.y);
+					}
+
+					const PixelRect bounds = PixelRect{
+						static_cast<int>(std::floor(minX)),
+						static_cast<int>(std::floor(minY)),
+						static_cast<int>(std::ceil(maxX)),
+						static_cast<int>(std::ceil(maxY))
+					}.Intersect(clip);
+
+					if (drawCommand->ElemCount > 0 && !bounds.IsEmpty())
+					{
+						Commands.push_back(CommandInfo{ commandList, drawCommand, indexOffset, clip, bounds, hash, false });
+					}
+
+					indexOffset += drawCommand->ElemCount;
+				}
+			}
+
+			return true;
+		}
+
+		void AddDirtyRect(PixelRect rect)
+		{
+			if (rect.IsEmpty()) return;
+
+			// Absorb every rectangle the new one overlaps. The grown rectangle may now overlap ones that were checked already, so start over each time.
+			for (std::size_t i = 0; i < DirtyRects.size();)
+			{
+				if (DirtyRects[i].Overlaps(rect))
+				{
+					rect = rect.Union(DirtyRects[i]);
+					DirtyRects[i] = DirtyRects.back();
+					DirtyRects.pop_back();
+					i = 0;
+				}
+				else
+				{
+					i++;
+				}
+			}
+
+			DirtyRects.push_back(rect);
+
+			if (DirtyRects.size() > MaxDirtyRects)
+			{
+				PixelRect combined = DirtyRects[0];
+
+				for (const PixelRect& dirty : DirtyRects)
+				{
+					combined = combined.Union(dirty);
+				}
+
+				DirtyRects.assign(1, combined);
+			}
+		}
+
+		void FindDirtyRects()
+		{
+			DirtyRects.clear();
+
+			if (NeedsFullRedraw)
+			{
+				DirtyRects.push_back(PixelRect{ 0, 0, Width, Height });
+				return;
+			}
+
+			// Sort both frames' commands by hash and walk them together. A command found in only one of the frames was added, removed or changed,
+			// so the area it covers (or used to cover) has to be drawn again.
+			CurrentOrder.resize(Commands.size());
+			PreviousOrder.resize(PreviousCommands.size());
+
+			for (std::size_t i = 0; i < CurrentOrder.size(); i++) CurrentOrder[i] = i;
+			for (std::size_t i = 0; i < PreviousOrder.size(); i++) PreviousOrder[i] = i;
+
+			std::sort(CurrentOrder.begin(), CurrentOrder.end(), [this](std::size_t a, std::size_t b) { return Commands[a].Hash < Commands[b].Hash; });
+			std::sort(PreviousOrder.begin(), PreviousOrder.end(), [this](std::size_t a, std::size_t b) { return PreviousCommands[a].Hash < PreviousCommands[b].Hash; });
+
+			for (std::size_t i = 0, j = 0; i < CurrentOrder.size() && j < PreviousOrder.size();)
+			{
+				CommandInfo& current = Commands[CurrentOrder[i]];
+				CommandSignature& previous = PreviousCommands[PreviousOrder[j]];
+
+				if (current.Hash == previous.Hash)
+				{
+					current.Matched = true;
+					previous.Matched = true;
+					i++;
+					j++;
+				}
+				else if (current.Hash < previous.Hash)
+				{
+					i++;
+				}
+				else
+				{
+					j++;
+				}
+			}
+
+			for (const CommandInfo& current : Commands)
+			{
+				if (!current.Matched) AddDirtyRect(current.Bounds);
+			}
+
+			for (const CommandSignature& previous : PreviousCommands)
+			{
+				if (!previous.Matched) AddDirtyRect(previous.Bounds);
+			}
+
+			// Unchanged commands may still be drawn in a different order (e.g. a window was brought to the front), which changes how they overlap.
+			// That's rare enough that redrawing everything is simpler than working out which overlaps changed.
+			std::size_t j = 0;
+
+			for (const CommandInfo& current : Commands)
+			{
+				if (!current.Matched) continue;
+
+				while (!PreviousCommands[j].Matched) j++;
+
+				if (PreviousCommands[j].Hash != current.Hash)
+				{
+					DirtyRects.assign(1, PixelRect{ 0, 0, Width, Height });
+					return;
+				}
+
+				j++;
+			}
+		}
+
+		template <typename ColorFunction> void BlendSpan(int y, int minX, int maxX, const ColorFunction& colorFunction)
+		{
+			uint32_t* const row = &Pixels[static_cast<std::size_t>(y) * Width];
+
+			for (int x = minX; x < maxX; x++)
+			{
+				row[x] = BlendOver(row[x], colorFunction(x));
+			}
+		}
+
+		// Splits the UI's draw commands into primitives (a rectangle or a single triangle) and records the ones overlapping each dirty piece.
+		// Only commands that touch a dirty rectangle are looked at. Primitives are binned in draw order so blending stays correct within each piece.
+		void BinPrimitives()
+		{
+			Primitives.clear();
+
+			for (std::size_t i = 0; i < Pieces.size(); i++)
+			{
+				Bins[i].clear();
+			}
+
+			for (std::size_t commandIndex = 0; commandIndex < Commands.size(); commandIndex++)
+			{
+				const CommandInfo& command = Commands[commandIndex];
+
+				bool isVisible = false;
+
+				for (const PixelRect& dirty : DirtyRects)
+				{
+					isVisible |= command.Bounds.Overlaps(dirty);
+				}
+
+				if (!isVisible) continue;
+
+				const ImDrawVert* vertexBuffer = command.List->VtxBuffer.Data;
+				const ImDrawIdx* indexBuffer = command.List->IdxBuffer.Data + command.IndexOffset;
+
+				const unsigned int elementCount = command.Command->ElemCount;
+
+				for (unsigned int i = 0; i + 3 <= elementCount; i += 3)
+				{
+					const ImDrawVert& v0 = vertexBuffer[indexBuffer[i + 0]];
+					const ImDrawVert& v1 = vertexBuffer[indexBuffer[i + 1]];
+					const ImDrawVert& v2 = vertexBuffer[indexBuffer[i + 2]];
+
+					const Rect& bounding = Rect::CalculateBoundingBox(v0, v1, v2);
+
+					// Rectangles (almost everything ImGui draws, including every glyph) are detected the same way as in Render and filled directly.
+					if (i + 6 <= elementCount)
+					{
+						const ImDrawVert& v3 = vertexBuffer[indexBuffer[i + 3]];
+						const ImDrawVert& v4 = vertexBuffer[indexBuffer[i + 4]];
+						const ImDrawVert& v5 = vertexBuffer[indexBuffer[i + 5]];
+
+						const bool isUniformColor = v0.col == v1.col && v1.col == v2.col && v2.col == v3.col && v3.col == v4.col && v4.col == v5.col;
+
+						if (isUniformColor
+						&& bounding.IsOnExtreme(v0.pos)
+						&& bounding.IsOnExtreme(v1.pos)
+						&& bounding.IsOnExtreme(v2.pos)
+						&& bounding.IsOnExtreme(v3.pos)
+						&& bounding.IsOnExtreme(v4.pos)
+						&& bounding.IsOnExtreme(v5.pos))
+						{
+							const PixelRect covered = PixelRect{
+								static_cast<int>(std::ceil(bounding.MinX - 0.5f)),
+								static_cast<int>(std::ceil(bounding.MinY - 0.5f)),
+								static_cast<int>(std::ceil(bounding.MaxX - 0.5f)),
+								static_cast<int>(std::ceil(bounding.MaxY - 0.5f))
+							};
+
+							AddPrimitive(Primitive{ static_cast<uint32_t>(commandIndex), i, true, covered.Intersect(command.Bounds) });
+
+							i += 3;  // Additional increment to account for the extra 3 vertices we consumed.
+							continue;
+						}
+					}
+
+					// The naming inconsistency in the parameters is intentional. The fixed point algorithm wants the vertices in a counter clockwise order.
+					const auto& renderInfo = FixedPointTriangleRenderInfo::CalculateFixedPointTriangleInfo(v2.pos, v1.pos, v0.pos);
+
+					const PixelRect covered = PixelRect{ renderInfo.MinX, renderInfo.MinY, renderInfo.MaxX, renderInfo.MaxY };
+
+					AddPrimitive(Primitive{ static_cast<uint32_t>(commandIndex), i, false, covered.Intersect(command.Bounds) });
+				}
+			}
+		}
+
+		void AddPrimitive(const Primitive& primitive)
+		{
+			if (primitive.Bounds.IsEmpty()) return;
+
+			const uint32_t primitiveIndex = static_cast<uint32_t>(Primitives.size());
+			bool isBinned = false;
+
+			for (std::size_t d = 0; d < DirtyRects.size(); d++)
+			{
+				const PixelRect& dirty = DirtyRects[d];
+				const PixelRect overlap = primitive.Bounds.Intersect(dirty);
+
+				if (overlap.IsEmpty()) continue;
+
+				// Pieces of each dirty rectangle were created row by row over the tiles it touches, so the piece for a tile can be found directly.
+				const int firstTileX = dirty.MinX / TileSize;
+				const int firstTileY = dirty.MinY / TileSize;
+				const int tilesAcross = (dirty.MaxX - 1) / TileSize - firstTileX + 1;
+
+				for (int tileY = overlap.MinY / TileSize; tileY <= (overlap.MaxY - 1) / TileSize; tileY++)
+				{
+					for (int tileX = overlap.MinX / TileSize; tileX <= (overlap.MaxX - 1) / TileSize; tileX++)
+					{
+						Bins[PieceStarts[d] + (tileY - firstTileY) * tilesAcross + (tileX - firstTileX)].push_back(primitiveIndex);
+					}
+				}
+
+				isBinned = true;
+			}
+
+			if (isBinned)
+				Primitives.push_back(primitive);
+		}
+
+		// Cuts the dirty rectangles along the tile grid. Dirty rectangles never overlap, so neither do the pieces, and each can be rasterized by a different thread.
+		void SplitIntoPieces()
+		{
+			Pieces.clear();
+			PieceStarts.clear();
+
+			for (const PixelRect& dirty : DirtyRects)
+			{
+				PieceStarts.push_back(Pieces.size());
+
+				for (int tileY = dirty.MinY / TileSize; tileY <= (dirty.MaxY - 1) / TileSize; tileY++)
+				{
+					for (int tileX = dirty.MinX / TileSize; tileX <= (dirty.MaxX - 1) / TileSize; tileX++)
+					{
+						const PixelRect tile = { tileX * TileSize, tileY * TileSize, (tileX + 1) * TileSize, (tileY + 1) * TileSize };
+
+						Pieces.push_back(tile.Intersect(dirty));
+					}
+				}
+			}
+
+			if (Bins.size() < Pieces.size())
+				Bins.resize(Pieces.size());
+		}
+
+		void RasterizePiece(std::size_t pieceIndex)
+		{
+			const PixelRect& piece = Pieces[pieceIndex];
+
+			for (int y = piece.MinY; y < piece.MaxY; y++)
+			{
+				std::fill(&Pixels[static_cast<std::size_t>(y) * Width + piece.MinX], &Pixels[static_cast<std::size_t>(y) * Width + piece.MaxX], 0u);
+			}
+
+			for (uint32_t primitiveIndex : Bins[pieceIndex])
+			{
+				const Primitive& primitive = Primitives[primitiveIndex];
+
+				RasterizePrimitive(primitive, primitive.Bounds.Intersect(piece));
+			}
+		}
+
+		// Draws the part of a primitive that falls within area, which is already limited to its command's clip rectangle.
+		void RasterizePrimitive(const Primitive& primitive, const PixelRect& area)
+		{
+			const CommandInfo& command = Commands[primitive.Command];
+
+			const ImDrawVert* vertexBuffer = command.List->VtxBuffer.Data;
+			const ImDrawIdx* indexBuffer = command.List->IdxBuffer.Data + command.IndexOffset + primitive.FirstIndex;
+			const Texture* texture = static_cast<const Texture*>(command.Command->TextureId);
+
+			const ImDrawVert& v0 = vertexBuffer[indexBuffer[0]];
+			const ImDrawVert& v1 = vertexBuffer[indexBuffer[1]];
+			const ImDrawVert& v2 = vertexBuffer[indexBuffer[2]];
+
+			const Rect& bounding = Rect::CalculateBoundingBox(v0, v1, v2);
+
+			if (primitive.IsRectangle)
+			{
+				RasterizeRectangle(v0, v2, bounding, texture, area);
+				return;
+			}
+
+			const auto& renderInfo = FixedPointTriangleRenderInfo::CalculateFixedPointTriangleInfo(v2.pos, v1.pos, v0.pos);
+
+			if (v0.col == v1.col && v1.col == v2.col && bounding.UsesOnlyColor())
+			{
+				const uint32_t color = v0.col;
+
+				ScanTriangle(renderInfo, area.MinX, area.MinY, area.MaxX, area.MaxY, [&](int x, int y, bool isInside) {
+					if (isInside)
+					{
+						uint32_t& pixel = Pixels[static_cast<std::size_t>(y) * Width + x];
+						pixel = BlendOver(pixel, color);
+					}
+				});
+			}
+			else
+			{
+				const InterpolatedFactorEquation<float> textureU(v0.uv.x, v1.uv.x, v2.uv.x, v0.pos, v1.pos, v2.pos);
+				const InterpolatedFactorEquation<float> textureV(v0.uv.y, v1.uv.y, v2.uv.y, v0.pos, v1.pos, v2.pos);
+
+				const InterpolatedFactorEquation<Color> shadeColor(Color(v0.col), Color(v1.col), Color(v2.col), v0.pos, v1.pos, v2.pos);
+
+				ScanTriangle(renderInfo, area.MinX, area.MinY, area.MaxX, area.MaxY, [&](int x, int y, bool isInside) {
+					if (isInside)
+					{
+						const float pixelX = x + 0.5f;
+						const float pixelY = y + 0.5f;
+
+						const Color sampled = texture->Sample(textureU.Evaluate(pixelX, pixelY), textureV.Evaluate(pixelX, pixelY));
+
+						uint32_t& pixel = Pixels[static_cast<std::size_t>(y) * Width + x];
+						pixel = BlendOver(pixel, (sampled * shadeColor.Evaluate(pixelX, pixelY)).ToInt());
+					}
+				});
+			}
+		}
+
+		// Fills a rectangle given its top-left and bottom-right vertices. Pixels are covered when their centre is inside, like the triangle rasterizer.
+		void RasterizeRectangle(const ImDrawVert& topLeft, const ImDrawVert& bottomRight, const Rect& bounding, const Texture* texture, const PixelRect& area)
+		{
+			const PixelRect covered = PixelRect{
+				static_cast<int>(std::ceil(bounding.MinX - 0.5f)),
+				static_cast<int>(std::ceil(bounding.MinY - 0.5f)),
+				static_cast<int>(std::ceil(bounding.MaxX - 0.5f)),
+				static_cast<int>(std::ceil(bounding.MaxY - 0.5f))
+			}.Intersect(area);
+
+			if (covered.IsEmpty()) return;
+
+			const uint32_t color = topLeft.col;
+
+			if (bounding.UsesOnlyColor())
+			{
+				for (int y = covered.MinY; y < covered.MaxY; y++)
+				{
+					BlendSpan(y, covered.MinX, covered.MaxX, [color](int) { return color; });
+				}
+
+				return;
+			}
+
+			// Texture coordinates are mapped linearly from the corners, which also takes care of flipped rectangles.
+			const int textureWidth = texture->Surface->w;
+			const int textureHeight = texture->Surface->h;
+			const uint32_t* texels = static_cast<const uint32_t*>(texture->Surface->pixels);
+
+			const float texelsPerPixelX = (bottomRight.uv.x - topLeft.uv.x) * textureWidth / (bottomRight.pos.x - topLeft.pos.x);
+			const float texelsPerPixelY = (bottomRight.uv.y - topLeft.uv.y) * textureHeight / (bottomRight.pos.y - topLeft.pos.y);
+
+			for (int y = covered.MinY; y < covered.MaxY; y++)
+			{
+				const float texelY = topLeft.uv.y * textureHeight + (y + 0.5f - topLeft.pos.y) * texelsPerPixelY;
+				const int row = std::min(std::max(static_cast<int>(texelY), 0), textureHeight - 1);
+
+				const uint32_t* texelRow = texels + static_cast<std::size_t>(row) * textureWidth;
+
+				BlendSpan(y, covered.MinX, covered.MaxX, [&](int x) {
+					const float texelX = topLeft.uv.x * textureWidth + (x + 0.5f - topLeft.pos.x) * texelsPerPixelX;
+					const int column = std::min(std::max(static_cast<int>(texelX), 0), textureWidth - 1);
+
+					return ModulateColor(texelRow[column], color);
+				});
+			}
+		}
+
+	private:
+		SDL_Renderer* Renderer;
+
+		// Streaming texture the framebuffer is uploaded to, and the framebuffer itself
+		SDL_Texture* Target = nullptr;
+		std::vector<uint32_t> Pixels;
+		int Width = 0;
+		int Height = 0;
+
+		// Set when the framebuffer contents can't be trusted, e.g. it was just created or the last frame fell back to the renderer
+		bool NeedsFullRedraw = true;
+
+		std::vector<CommandInfo> Commands;
+		std::vector<CommandSignature> PreviousCommands;
+		std::vector<PixelRect> DirtyRects;
+
+		// Scratch space for sorting the commands by hash, kept between frames so it doesn't allocate
+		std::vector<std::size_t> CurrentOrder;
+		std::vector<std::size_t> PreviousOrder;
+
+		// Dirty rectangles cut along the tile grid, the index of the first piece of each dirty rectangle and the primitives binned into each piece
+		std::vector<PixelRect> Pieces;
+		std::vector<std::size_t> PieceStarts;
+		std::vector<std::vector<uint32_t>> Bins;
+
+		std::vector<Primitive> Primitives;
+
+		WorkerPool Pool;
+
+		ImGuiSDL::SoftwareRenderStats LastStats = {};
+	};
+
+	SoftwareCompositor* CurrentCompositor = nullptr;
+}
+
+namespace ImGuiSDL
+{
+	void Initialize(SDL_Renderer* renderer, int windowWidth, int windowHeight)
+	{
+		ImGuiIO& io = ImGui::GetIO();
+		io.DisplaySize.x = static_cast<float>(windowWidth);
+		io.DisplaySize.y = static_cast<float>(windowHeight);
+
+		ImGui::GetStyle().WindowRounding = 0.0f;
+		ImGui::GetStyle().AntiAliasedFill = false;
+		ImGui::GetStyle().AntiAliasedLines = false;
+
+		// Loads the font texture.
+		unsigned char* pixels;
+		int width, height;
+		io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+		static constexpr uint32_t rmask = 0x000000ff, gmask = 0x0000ff00, bmask = 0x00ff0000, amask = 0xff000000;
+		SDL_Surface* surface = SDL_CreateRGBSurfaceFrom(pixels, width, height, 32, 4 * width, rmask, gmask, bmask, amask);
+
+		Texture* texture = new Texture();
+		texture->Surface = surface;
+		texture->Source = SDL_CreateTextureFromSurface(renderer, surface);
+		io.Fonts->TexID = (void*)texture;
+
+		CurrentDevice = new Device(renderer);
+	}
+
+	void Deinitialize()
+	{
+		// Frees up the memory of the font texture.
+		ImGuiIO& io = ImGui::GetIO();
+		Texture* texture = static_cast<Texture*>(io.Fonts->TexID);
+		delete texture;
+
+		delete CurrentCompositor;
+		CurrentCompositor = nullptr;
+
+		delete CurrentDevice;
+	}
+
+	void Render(ImDrawData* drawData)
+	{
+		const SavedRenderState savedState(CurrentDevice->Renderer);
+
+		SDL_SetRenderDrawBlendMode(CurrentDevice->Renderer, SDL_BLENDMODE_BLEND);
+
+		ImGuiIO& io = ImGui::GetIO();
+
+		for (int n = 0; n < drawData->CmdListsCount; n++)
+		{
+			auto commandList = drawData->CmdLists[n];
+			auto vertexBuffer = commandList->VtxBuffer;
+			auto indexBuffer = commandList->IdxBuffer.Data;
+
+			for (int cmd_i = 0; cmd_i < commandList->CmdBuffer.Size; cmd_i++)
+			{
+				const ImDrawCmd* drawCommand = &commandList->CmdBuffer[cmd_i];
+
+				const Device::ClipRect clipRect = {
+					static_cast<int>(drawCommand->ClipRect.x),
+					static_cast<int>(drawCommand->ClipRect.y),
+					static_cast<int>(drawCommand->ClipRect.z - drawCommand->ClipRect.x),
+					static_cast<int>(drawCommand->ClipRect.w - drawCommand->ClipRect.y)
+				};
+				CurrentDevice->SetClipRect(clipRect);
+
+				if (drawCommand->UserCallback)
+				{
+					drawCommand->UserCallback(commandList, drawCommand);
+				}
+				else
+				{
+					const bool isWrappedTexture = drawCommand->TextureId == io.Fonts->TexID;
+
+					// Loops over triangles.
+					for (unsigned int i = 0; i + 3 <= drawCommand->ElemCount; i += 3)
+					{
+						const ImDrawVert& v0 = vertexBuffer[indexBuffer[i + 0]];
+						const ImDrawVert& v1 = vertexBuffer[indexBuffer[i + 1]];
+						const ImDrawVert& v2 = vertexBuffer[indexBuffer[i + 2]];
+
+						const Rect& bounding = Rect::CalculateBoundingBox(v0, v1, v2);
+
+						const bool isTriangleUniformColor = v0.col == v1.col && v1.col == v2.col;
+						const bool doesTriangleUseOnlyColor = bounding.UsesOnlyColor();
+
+						// Actually, since we render a whole bunch of rectangles, we try to first detect those, and render them more efficiently.
+						// How are rectangles detected? It's actually pretty simple: If all 6 vertices lie on the extremes of the bounding box,
+						// it's a rectangle.
+						if (i + 6 <= drawCommand->ElemCount)
+						{
+							const ImDrawVert& v3 = vertexBuffer[indexBuffer[i + 3]];
+							const ImDrawVert& v4 = vertexBuffer[indexBuffer[i + 4]];
+							const ImDrawVert& v5 = vertexBuffer[indexBuffer[i + 5]];
+
+							const bool isUniformColor = isTriangleUniformColor && v2.col == v3.col && v3.col == v4.col && v4.col == v5.col;
+
+							if (isUniformColor
+							&& bounding.IsOnExtreme(v0.pos)
+							&& bounding.IsOnExtreme(v1.pos)
+							&& bounding.IsOnExtreme(v2.pos)
+							&& bounding.IsOnExtreme(v3.pos)
+							&& bounding.IsOnExtreme(v4.pos)
+							&& bounding.IsOnExtreme(v5.pos))
+							{
+								// ImGui gives the triangles in a nice order: the first vertex happens to be the topleft corner of our rectangle.
+								// We need to check for the orientation of the texture, as I believe in theory ImGui could feed us a flipped texture,
+								// so that the larger texture coordinates are at topleft instead of bottomright.
+								// We don't consider equal texture coordinates to require a flip, as then the rectangle is mostlikely simply a colored rectangle.
+								const bool doHorizontalFlip = v2.uv.x < v0.uv.x;
+								const bool doVerticalFlip = v2.uv.x < v0.uv.x;
+
+								if (isWrappedTexture)
+								{
+									DrawRectangle(bounding, static_cast<const Texture*>(drawCommand->TextureId), Color(v0.col), doHorizontalFlip, doVerticalFlip);
+								}
+								else
+								{
+									DrawRectangle(bounding, static_cast<SDL_Texture*>(drawCommand->TextureId), Color(v0.col), doHorizontalFlip, doVerticalFlip);
+								}
 
 								i += 3;  // Additional increment to account for the extra 3 vertices we consumed.
 								continue;
@@ -664,13 +1666,39 @@ namespace ImGuiSDL
 
 		CurrentDevice->DisableClip();
 
-		SDL_SetRenderTarget(CurrentDevice->Renderer, initialRenderTarget);
+		savedState.Restore(CurrentDevice->Renderer);
+	}
 
-		SDL_RenderSetClipRect(CurrentDevice->Renderer, initialClipEnabled ? &initialClipRect : nullptr);
+	void RenderSoftware(ImDrawData* drawData)
+	{
+		if (CurrentCompositor == nullptr)
+			CurrentCompositor = new SoftwareCompositor(CurrentDevice->Renderer);
+
+		if (!CurrentCompositor->Render(drawData))
+			Render(drawData);
+	}
 
-		SDL_SetRenderDrawColor(CurrentDevice->Renderer,
-			initialR, initialG, initialB, initialA);
+	uint64_t Fingerprint(ImDrawData* drawData)
+	{
+		uint64_t hash = 0xcbf29ce484222325ull;
 
-		SDL_SetRenderDrawBlendMode(CurrentDevice->Renderer, blendMode);
+		hash = HashBytes(hash, &drawData->DisplaySize, sizeof(drawData->DisplaySize));
+
+		for (int n = 0; n < drawData->CmdListsCount; n++)
+		{
+			const ImDrawList* commandList = drawData->CmdLists[n];
+
+			// ImDrawCmd zeroes its padding, so the commands can be hashed as raw memory
+			hash = HashBytes(hash, commandList->CmdBuffer.Data, commandList->CmdBuffer.size_in_bytes());
+			hash = HashBytes(hash, commandList->IdxBuffer.Data, commandList->IdxBuffer.size_in_bytes());
+			hash = HashBytes(hash, commandList->VtxBuffer.Data, commandList->VtxBuffer.size_in_bytes());
+		}
+
+		return hash;
+	}
+
+	SoftwareRenderStats GetSoftwareRenderStats()
+	{
+		return (CurrentCompositor != nullptr) ? CurrentCompositor->Stats() : SoftwareRenderStats{};
 	}
 }
@@ -1,5 +1,7 @@
 ﻿#pragma once
 
+#include <cstdint>
+
 struct ImDrawData;
 struct SDL_Renderer;
 
@@ -14,4 +16,28 @@ namespace ImGuiSDL
 	// Call this every frame after ImGui::Render with ImGui::GetDrawData(). This will use the SDL_Renderer provided to the interfrace with Initialize
 	// to draw the contents of the draw data to the screen.
 	void Render(ImDrawData* drawData);
+
+	// Work done by RenderSoftware on the most recent frame it drew.
+	struct SoftwareRenderStats
+	{
+		int DirtyRects;
+		int DirtyPixels;
+		int TotalPixels;
+
+		// Tiles the dirty rectangles were split into, and the number of threads they were rasterized on
+		int Tiles;
+		int Threads;
+	};
+
+	// Alternative to Render that rasterizes the whole draw data on the CPU into one framebuffer and only re-rasterizes and uploads the
+	// rectangles whose draw commands changed since the last frame. Much faster than Render on software renderers. Frames that use user
+	// callbacks or textures other than the font atlas are passed to Render instead.
+	void RenderSoftware(ImDrawData* drawData);
+
+	// Hashes everything in the draw data that affects what's drawn. Equal fingerprints on consecutive frames mean the UI would be drawn
+	// exactly the same, so the caller can skip rendering it.
+	uint64_t Fingerprint(ImDrawData* drawData);
+
+	// Gets what RenderSoftware did on the most recent frame, for diagnostics.
+	SoftwareRenderStats GetSoftwareRenderStats();
 }